@@ -20,35 +20,115 @@
 #include "db_client.hpp"
 #include "db_server.hpp"
 
+#include "wsrep/adaptive_mutex.hpp"
+#include "wsrep/compiler.hpp"
 #include "wsrep/logger.hpp"
 
+#include <cmath>
+#include <sstream>
+
+static wsrep::mutex* make_mutex(const db::params& params)
+{
+    if (params.client_mutex == "adaptive")
+    {
+        return new wsrep::adaptive_mutex();
+    }
+    return new wsrep::default_mutex();
+}
+
+static wsrep::condition_variable* make_cond(const db::params& params)
+{
+    if (params.client_mutex == "adaptive")
+    {
+        return new wsrep::adaptive_condition_variable();
+    }
+    return new wsrep::default_condition_variable();
+}
+
+// Clients with the lowest IDs run large transactions.
+static bool large_trx_client(wsrep::client_id client_id,
+                             enum wsrep::client_state::mode mode,
+                             const db::params& params)
+{
+    const double large_clients(
+        std::round(params.large_trx_clients * double(params.n_clients)));
+    return (mode == wsrep::client_state::m_local &&
+            double(client_id.get()) <= large_clients);
+}
+
+// Clients following large transaction clients run XA transactions.
+static bool xa_client(wsrep::client_id client_id,
+                      enum wsrep::client_state::mode mode,
+                      const db::params& params)
+{
+    const double large_clients(
+        std::round(params.large_trx_clients * double(params.n_clients)));
+    const double xa_clients(
+        std::round(params.xa_clients * double(params.n_clients)));
+    return (mode == wsrep::client_state::m_local &&
+            double(client_id.get()) > large_clients &&
+            double(client_id.get()) <= large_clients + xa_clients);
+}
+
 db::client::client(db::server& server,
                    wsrep::client_id client_id,
                    enum wsrep::client_state::mode mode,
                    const db::params& params)
-    : mutex_()
-    , cond_()
+    : mutex_(make_mutex(params))
+    , cond_(make_cond(params))
     , params_(params)
     , server_(server)
     , server_state_(server.server_state())
-    , client_state_(mutex_, cond_, server_state_, client_service_, client_id, mode)
+    , client_state_(*mutex_, *cond_, server_state_, client_service_,
+                    client_id, mode)
     , client_service_(*this)
     , se_trx_(server.storage_engine())
     , data_()
+    , large_trx_(large_trx_client(client_id, mode, params))
+    , xa_(xa_client(client_id, mode, params))
+    , trx_log_()
+    , key_type_mix_(params.key_type_mix)
     , random_device_()
     , random_engine_(random_device_())
+    , xa_commit_by_xid_(params.xa_commit_by_xid)
+    , phase_(p_open)
+    , transactions_()
+    , trx_()
     , stats_()
 {
-    data_.resize(params.max_data_size);
+    data_.resize(large_trx_ ? params.large_trx_row_size
+                 : params.max_data_size);
 }
 
 void db::client::start()
+{
+    while (step()) { }
+}
+
+bool db::client::step()
+{
+    if (phase_ != p_open)
+    {
+        // Session may resume on another thread in thread pool mode.
+        store_globals();
+    }
+    const bool ret(execute_step());
+    reset_globals();
+    return ret;
+}
+
+void db::client::commit_detached_xa()
 {
     client_state_.open(client_state_.id());
-    for (size_t i(0); i < params_.n_transactions; ++i)
+    // Transactions which fail to commit are queued again, try each
+    // transaction once.
+    for (size_t n(server_.detached_xa_count());
+         n > 0 && commit_detached_xa(wsrep::client_id()); --n)
+    { }
+    if (const size_t left = server_.detached_xa_count())
     {
-        run_one_transaction();
-        report_progress(i + 1);
+        wsrep::log_warning() << "Detached XA transactions left prepared: "
+                             << left;
     }
     client_state_.close();
     client_state_.cleanup();
@@ -63,6 +143,42 @@ bool db::client::bf_abort(wsrep::seqno seqno)
 //                              Private                                       //
 ////////////////////////////////////////////////////////////////////////////////
 
+bool db::client::done(size_t transactions) const
+{
+    if (params_.duration)
+    {
+        return (std::chrono::steady_clock::now() >=
+                server_.clients_start() +
+                std::chrono::seconds(params_.warmup + params_.duration));
+    }
+    return (transactions >= params_.n_transactions);
+}
+
+bool db::client::next_transaction(
+    std::chrono::steady_clock::time_point& trx_start)
+{
+    if (db::load_generator* generator = server_.load_generator())
+    {
+        return generator->next(trx_start);
+    }
+    trx_start = std::chrono::steady_clock::now();
+    return not done(transactions_);
+}
+
+bool db::client::measured(std::chrono::steady_clock::time_point start) const
+{
+    return (start >=
+            server_.clients_start() + std::chrono::seconds(params_.warmup));
+}
+
+static uint64_t elapsed_usec(std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            end - start).count());
+}
+
 template <class F>
 int db::client::client_command(F f)
 {
@@ -91,18 +207,91 @@ int db::client::client_command(F f)
     return err;
 }
 
-static void release_commit_critical_section(void* ptr)
+// Each step executes at most one client command.
+bool db::client::execute_step()
 {
-    auto* crit = static_cast<db::server::commit_critical_section*>(ptr);
-    if (crit->lock.owns_lock())
+    for (;;)
     {
-        crit->lock.unlock();
+        switch (phase_)
+        {
+        case p_open:
+            client_state_.open(client_state_.id());
+            if (large_trx_ && params_.fragment_size)
+            {
+                client_state_.enable_streaming(
+                    db::fragment_unit(params_.fragment_unit),
+                    params_.fragment_size);
+            }
+            phase_ = p_begin;
+            break;
+        case p_begin:
+            if (not next_transaction(trx_.start))
+            {
+                client_state_.close();
+                client_state_.cleanup();
+                phase_ = p_closed;
+                return false;
+            }
+            phase_ = p_start;
+            // XA COMMIT for transaction prepared by another client.
+            if (xa_ && commit_detached_xa(client_state_.id()))
+            {
+                return true;
+            }
+            break;
+        case p_start:
+            begin_transaction();
+            phase_ = p_statement;
+            return true;
+        case p_statement:
+            if (trx_.err || trx_.written >= (large_trx_ ?
+                                             params_.large_trx_rows :
+                                             params_.statements_per_trx))
+            {
+                phase_ = (xa_ ? p_prepare : p_commit);
+                break;
+            }
+            trx_.err = execute_statement();
+            return true;
+        case p_prepare:
+            phase_ = p_commit;
+            if (trx_.err)
+            {
+                break;
+            }
+            trx_.err = xa_prepare();
+            if (trx_.err == 0 && xa_commit_by_xid_(random_engine_))
+            {
+                phase_ = p_detach;
+            }
+            return true;
+        case p_detach:
+        {
+            // Transaction is committed by another client and counted
+            // there.
+            const int err WSREP_UNUSED(xa_detach());
+            assert(err == 0);
+            assert(se_trx_.active() == false);
+            report_progress(++transactions_);
+            phase_ = p_begin;
+            return true;
+        }
+        case p_commit:
+            commit_transaction();
+            report_progress(++transactions_);
+            phase_ = p_begin;
+            return true;
+        case p_closed:
+            return false;
+        }
     }
 }
 
-void db::client::run_one_transaction()
+void db::client::begin_transaction()
 {
-    if (params_.sync_wait)
+    const size_t sync_waits((params_.sync_wait ? 1 : 0) +
+                            params_.sync_wait_reads);
+    for (size_t i(0); i < sync_waits; ++i)
     {
         if (client_state_.sync_wait(5))
         {
@@ -110,47 +299,75 @@ void db::client::run_one_transaction()
         }
     }
     client_state_.reset_error();
-    int err = client_command(
+    const db::storage_engine& se(server_.storage_engine());
+    trx_.ddl_events = se.ddl_events();
+    trx_.ddl_active = se.ddl_active();
+    trx_.written = 0;
+    trx_.err = client_command(
         [&]()
         {
             // wsrep::log_debug() << "Start transaction";
-            err = client_state_.start_transaction(
-                wsrep::transaction_id(server_.next_transaction_id()));
+            int err(client_state_.start_transaction(
+                        wsrep::transaction_id(server_.next_transaction_id())));
             assert(err == 0);
             se_trx_.start(this);
+            trx_log_.clear();
+            if (xa_)
+            {
+                // XA START, xid is unique in the cluster.
+                std::ostringstream os;
+                os << server_state_.name() << "-"
+                   << client_state_.transaction().id().get();
+                const std::string gtrid(os.str());
+                client_state_.assign_xid(
+                    wsrep::xid(1, long(gtrid.size()), 0, gtrid.data()));
+            }
             return err;
         });
+}
 
-    const wsrep::transaction& transaction(
-        client_state_.transaction());
-
-    err = err || client_command(
+int db::client::execute_statement()
+{
+    const wsrep::transaction& transaction(client_state_.transaction());
+    if (large_trx_)
+    {
+        const size_t rows(std::min(params_.keys_per_statement,
+                                   params_.large_trx_rows - trx_.written));
+        trx_.written += rows;
+        return client_command(
+            [&]()
+            {
+                assert(transaction.active());
+                return write_large_statement(rows);
+            });
+    }
+    const bool first(trx_.written == 0);
+    ++trx_.written;
+    return client_command(
         [&]()
         {
             // wsrep::log_debug() << "Generate write set";
             assert(transaction.active());
-            assert(err == 0);
-            std::uniform_int_distribution<size_t> uniform_dist(0, params_.n_rows);
-            const size_t randkey(uniform_dist(random_engine_));
-            ::memcpy(data_.data(), &randkey,
-                     std::min(sizeof(randkey), data_.size()));
-            wsrep::key key(wsrep::key::exclusive);
-            key.append_key_part("dbms", 4);
-            unsigned long long client_key(client_state_.id().get());
-            key.append_key_part(&client_key, sizeof(client_key));
-            key.append_key_part(&randkey, sizeof(randkey));
-            err = client_state_.append_key(key);
-            size_t bytes_to_append(data_.size());
-            if (params_.random_data_size)
-            {
-                bytes_to_append = std::uniform_int_distribution<size_t>(
-                    1, data_.size())(random_engine_);
-            }
-            err = err || client_state_.append_data(
-                wsrep::const_buffer(data_.data(), bytes_to_append));
-            return err;
+            return write_statement(first);
         });
+}
+
+static void release_commit_critical_section(void* ptr)
+{
+    auto* crit = static_cast<db::server::commit_critical_section*>(ptr);
+    if (crit->lock.owns_lock())
+    {
+        crit->lock.unlock();
+    }
+}
 
+void db::client::commit_transaction()
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point commit_start(clock::now());
+    int err(trx_.err);
+    const wsrep::transaction& transaction(
+        client_state_.transaction());
     err = err || client_command(
         [&]()
         {
@@ -159,7 +376,10 @@ void db::client::run_one_transaction()
                 commit_crit.lock.unlock();
             }
 
-            client_state_.append_data({&commit_crit.commit_seqno,
+            // Commit seqno must be the last item in the write set.
+            // In streaming transaction it is replicated with the rest
+            // of the log in prepare_data_for_replication().
+            append_data({&commit_crit.commit_seqno,
                     sizeof(commit_crit.commit_seqno)});
 
             wsrep::provider::seq_cb seq_cb {
@@ -168,7 +388,7 @@ void db::client::run_one_transaction()
             };
 
             assert(err == 0);
-            if (params_.do_2pc)
+            if (params_.do_2pc && not xa_)
             {
                 err = err || client_state_.before_prepare(&seq_cb);
                 err = err || client_state_.after_prepare();
@@ -184,6 +404,7 @@ void db::client::run_one_transaction()
                 }
             }
             err = err || client_state_.ordered_commit();
+            if (err == 0) se_trx_.wait_durable();
             err = err || client_state_.after_commit();
             if (err)
             {
@@ -204,18 +425,284 @@ void db::client::run_one_transaction()
     {
     case wsrep::transaction::s_committed:
         ++stats_.commits;
+        if (large_trx_) ++stats_.large_commits;
         break;
     case wsrep::transaction::s_aborted:
         ++stats_.rollbacks;
+        if (large_trx_) ++stats_.large_rollbacks;
         break;
     default:
         assert(0);
     }
+
+    const clock::time_point trx_end(clock::now());
+    const clock::time_point clients_start(server_.clients_start());
+    const bool committed(
+        transaction.state() == wsrep::transaction::s_committed);
+    stats_.throughput.record(
+        static_cast<size_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                                trx_end - clients_start).count()),
+        committed);
+    if (committed &&
+        trx_.start >= clients_start + std::chrono::seconds(params_.warmup))
+    {
+        stats_.trx_latency.record(
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    trx_end - trx_.start).count()));
+        stats_.commit_latency.record(
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    trx_end - commit_start).count()));
+        if (xa_)
+        {
+            stats_.xa_commit_latency.record(
+                elapsed_usec(commit_start, trx_end));
+        }
+        const db::storage_engine& se(server_.storage_engine());
+        if (trx_.ddl_active || se.ddl_active() ||
+            se.ddl_events() != trx_.ddl_events)
+        {
+            stats_.ddl_trx_latency.record(
+                static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        trx_end - trx_.start).count()));
+        }
+    }
+}
+
+int db::client::xa_prepare()
+{
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start(clock::now());
+    int err(client_command(
+        [&]()
+        {
+            // XA END and XA PREPARE, prepare replicates the write set
+            // in a fragment. Transaction stays open in the client
+            // after the statement.
+            int err(client_state_.before_prepare());
+            err = err || client_state_.after_prepare();
+            if (err)
+            {
+                client_state_.before_rollback();
+                se_trx_.rollback();
+                client_state_.after_rollback();
+            }
+            return err;
+        }));
+    if (err == 0)
+    {
+        assert(client_state_.transaction().state() ==
+               wsrep::transaction::s_prepared);
+        ++stats_.xa_prepares;
+        if (measured(start))
+        {
+            stats_.xa_prepare_latency.record(
+                elapsed_usec(start, clock::now()));
+        }
+    }
+    return err;
+}
+
+int db::client::xa_detach()
+{
+    const wsrep::xid xid(client_state_.transaction().xid());
+    // Streaming applier takes over the prepared transaction, see
+    // client_service::cleanup_transaction().
+    int err(client_command(
+        [&]()
+        {
+            client_state_.xa_detach();
+            return 0;
+        }));
+    if (err == 0)
+    {
+        server_.detach_xa(xid, client_state_.id());
+    }
+    return err;
+}
+
+bool db::client::commit_detached_xa(wsrep::client_id client_id)
+{
+    typedef std::chrono::steady_clock clock;
+    std::pair<wsrep::xid, wsrep::client_id> detached;
+    if (not server_.next_detached_xa(client_id, detached))
+    {
+        return false;
+    }
+    const clock::time_point start(clock::now());
+    client_state_.reset_error();
+    int err(client_command(
+        [&]()
+        {
+            int err(client_state_.start_transaction(
+                        wsrep::transaction_id(server_.next_transaction_id())));
+            assert(err == 0);
+            client_state_.assign_xid(detached.first);
+            err = err || client_state_.commit_by_xid(detached.first);
+            if (err == 0)
+            {
+                err = server_.commit_detached_xa(detached.first);
+            }
+            else
+            {
+                client_state_.before_rollback();
+                client_state_.after_rollback();
+            }
+            return err;
+        }));
+    if (err)
+    {
+        ++stats_.xa_commit_by_xid_failures;
+        if (client_state_.transaction().state() !=
+            wsrep::transaction::s_committed)
+        {
+            // Transaction is still prepared, try again later.
+            server_.detach_xa(detached.first, detached.second);
+        }
+        return true;
+    }
+    const clock::time_point end(clock::now());
+    ++stats_.commits;
+    ++stats_.xa_commits_by_xid;
+    stats_.throughput.record(
+        static_cast<size_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                                end - server_.clients_start()).count()),
+        true);
+    if (measured(start))
+    {
+        stats_.xa_commit_by_xid_latency.record(elapsed_usec(start, end));
+    }
+    return true;
+}
+
+int db::client::write_statement(bool first)
+{
+    const db::key_distribution& dist(server_.key_distribution());
+    int err(0);
+    size_t row(0);
+    for (size_t i(0); i < params_.keys_per_statement && err == 0; ++i)
+    {
+        row = dist(random_engine_);
+        err = append_row_key(row);
+    }
+    if (params_.hot_rows && first)
+    {
+        // Row shared by all clients, conflicts between nodes.
+        std::uniform_int_distribution<size_t> hot_dist(
+            0, params_.hot_rows - 1);
+        const size_t hot_row(hot_dist(random_engine_));
+        wsrep::key hot_key(wsrep::key::exclusive);
+        hot_key.append_key_part("dbms", 4);
+        hot_key.append_key_part("hot", 3);
+        hot_key.append_key_part(&hot_row, sizeof(hot_row));
+        err = err || write_row(hot_key);
+    }
+    if (server_.storage_engine().row_store())
+    {
+        // Data was replicated with row images.
+        return err;
+    }
+    ::memcpy(data_.data(), &row, std::min(sizeof(row), data_.size()));
+    err = err || append_data(
+        wsrep::const_buffer(data_.data(), payload_size()));
+    return err;
+}
+
+int db::client::write_large_statement(size_t rows)
+{
+    const db::key_distribution& dist(server_.key_distribution());
+    int err(0);
+    for (size_t i(0); i < rows && err == 0; ++i)
+    {
+        const size_t row(dist(random_engine_));
+        err = append_row_key(row);
+        if (err == 0 && server_.storage_engine().row_store() == nullptr)
+        {
+            ::memcpy(data_.data(), &row, std::min(sizeof(row), data_.size()));
+            err = append_data(
+                wsrep::const_buffer(data_.data(), payload_size()));
+        }
+        // Replicates a fragment if fragment size is exceeded.
+        err = err || client_state_.after_row();
+    }
+    return err;
+}
+
+int db::client::append_data(const wsrep::const_buffer& data)
+{
+    if (streaming())
+    {
+        trx_log_.append(data.data(), data.size());
+        return 0;
+    }
+    return client_state_.append_data(data);
+}
+
+int db::client::append_row_key(size_t row)
+{
+    wsrep::key key(key_type_mix_(random_engine_));
+    key.append_key_part("dbms", 4);
+    if (params_.shared_keys)
+    {
+        key.append_key_part("shared", 6);
+    }
+    else
+    {
+        // Rows private to client, conflicts come only from hot rows
+        // and ALG events.
+        unsigned long long client_key(client_state_.id().get());
+        key.append_key_part(&client_key, sizeof(client_key));
+    }
+    key.append_key_part(&row, sizeof(row));
+    return write_row(key);
+}
+
+int db::client::write_row(const wsrep::key& key)
+{
+    int err(client_state_.append_key(key));
+    if (err || server_.storage_engine().row_store() == nullptr ||
+        key.type() == wsrep::key::shared ||
+        key.type() == wsrep::key::reference)
+    {
+        return err;
+    }
+    const db::row_store::row_id row(db::row_store::id(key));
+    ::memcpy(data_.data(), &row, std::min(sizeof(row), data_.size()));
+    const std::string value(data_.data(), payload_size());
+    if (se_trx_.write_row(row, value))
+    {
+        // Row locked by other transaction, roll back.
+        client_state_.before_rollback();
+        se_trx_.rollback();
+        client_state_.after_rollback();
+        return 1;
+    }
+    std::string image;
+    db::storage_engine::append_row_image(image, row, value);
+    return append_data(
+        wsrep::const_buffer(image.data(), image.size()));
+}
+
+size_t db::client::payload_size()
+{
+    if (params_.random_data_size && not large_trx_)
+    {
+        return std::uniform_int_distribution<size_t>(
+            1, data_.size())(random_engine_);
+    }
+    return data_.size();
 }
 
 void db::client::report_progress(size_t i) const
 {
-    if ((i % 1000) == 0)
+    if ((params_.duration || params_.rate > 0.) && (i % 1000) == 0)
+    {
+        wsrep::log_info() << "client: " << client_state_.id().get()
+                          << " transactions: " << i;
+    }
+    else if ((i % 1000) == 0)
     {
         wsrep::log_info() << "client: " << client_state_.id().get()
                           << " transactions: " << i
@@ -27,7 +27,11 @@
 #include "db_client_state.hpp"
 #include "db_client_service.hpp"
 #include "db_high_priority_service.hpp"
+#include "db_workload.hpp"
+#include "db_stats.hpp"
 
+#include <chrono>
+#include <memory>
 #include <random>
 
 namespace db
@@ -41,10 +45,46 @@ namespace db
             long long commits;
             long long rollbacks;
             long long replays;
+            /* Commits and rollbacks of large transactions, included
+             * also in commits and rollbacks. */
+            long long large_commits;
+            long long large_rollbacks;
+            /* XA transactions prepared and committed by xid from
+             * other than the preparing client, and failed commits
+             * by xid. */
+            long long xa_prepares;
+            long long xa_commits_by_xid;
+            long long xa_commit_by_xid_failures;
+            /* Latencies in microseconds of committed transactions started
+             * after warmup, for whole transaction and for commit step. */
+            db::histogram trx_latency;
+            db::histogram commit_latency;
+            /* Latencies of committed transactions which overlapped
+             * DDL execution on the server. */
+            db::histogram ddl_trx_latency;
+            /* Latencies of XA PREPARE, XA COMMIT from the preparing
+             * client and XA COMMIT by xid from another client. */
+            db::histogram xa_prepare_latency;
+            db::histogram xa_commit_latency;
+            db::histogram xa_commit_by_xid_latency;
+            /* Completed transactions per second since client start. */
+            db::time_series throughput;
             stats()
                 : commits(0)
                 , rollbacks(0)
                 , replays(0)
+                , large_commits(0)
+                , large_rollbacks(0)
+                , xa_prepares(0)
+                , xa_commits_by_xid(0)
+                , xa_commit_by_xid_failures(0)
+                , trx_latency()
+                , commit_latency()
+                , ddl_trx_latency()
+                , xa_prepare_latency()
+                , xa_commit_latency()
+                , xa_commit_by_xid_latency()
+                , throughput()
             { }
         };
         client(db::server&,
@@ -52,14 +92,25 @@ namespace db
                enum wsrep::client_state::mode,
                const db::params&);
         bool bf_abort(wsrep::seqno);
-        const struct stats stats() const { return stats_; }
+        const struct stats& stats() const { return stats_; }
         void store_globals()
         {
             client_state_.store_globals();
         }
         void reset_globals()
         { }
+        /* Run client session in the calling thread until done. */
         void start();
+        /*
+         * Execute the next step of client session, at most one client
+         * command. Thread pool workers execute steps of any client,
+         * the session resumes on the calling thread.
+         *
+         * @return False when the session has ended.
+         */
+        bool step();
+        /* Commit all detached XA transactions by xid. */
+        void commit_detached_xa();
         wsrep::client_state& client_state() { return client_state_; }
         wsrep::client_service& client_service() { return client_service_; }
     private:
@@ -67,11 +118,34 @@ namespace db
         friend class db::client_service;
         friend class db::high_priority_service;
         template <class F> int client_command(F f);
-        void run_one_transaction();
+        bool done(size_t transactions) const;
+        bool next_transaction(std::chrono::steady_clock::time_point&);
+        bool measured(std::chrono::steady_clock::time_point) const;
+        bool execute_step();
+        void begin_transaction();
+        int execute_statement();
+        void commit_transaction();
+        int xa_prepare();
+        int xa_detach();
+        /*
+         * Commit by xid one XA transaction detached by other client,
+         * or by any client if client id is undefined.
+         *
+         * @return False if there was no transaction to commit.
+         */
+        bool commit_detached_xa(wsrep::client_id);
+        int write_statement(bool first);
+        int write_large_statement(size_t rows);
+        int append_data(const wsrep::const_buffer&);
+        bool streaming() const
+        { return (large_trx_ && params_.fragment_size) || xa_; }
+        int append_row_key(size_t row);
+        int write_row(const wsrep::key&);
+        size_t payload_size();
         void reset_error();
         void report_progress(size_t) const;
-        wsrep::default_mutex mutex_;
-        wsrep::default_condition_variable cond_;
+        std::unique_ptr<wsrep::mutex> mutex_;
+        std::unique_ptr<wsrep::condition_variable> cond_;
         const db::params& params_;
         db::server& server_;
         db::server_state& server_state_;
@@ -79,8 +153,49 @@ namespace db
         db::client_service client_service_;
         db::storage_engine::transaction se_trx_;
         wsrep::mutable_buffer data_;
+        /* Runs large transactions. */
+        const bool large_trx_;
+        /* Runs XA transactions. */
+        const bool xa_;
+        /* Write set data of streaming transaction, fragments are
+         * replicated from the position certified so far. */
+        std::string trx_log_;
+        const db::key_type_mix key_type_mix_;
         std::random_device random_device_;
         std::default_random_engine random_engine_;
+        std::bernoulli_distribution xa_commit_by_xid_;
+        /* Session state between steps. */
+        enum phase
+        {
+            p_open,
+            p_begin,
+            p_start,
+            p_statement,
+            p_prepare,
+            p_detach,
+            p_commit,
+            p_closed
+        } phase_;
+        /* Transactions completed by the session. */
+        size_t transactions_;
+        /* Current transaction. Latency is measured from start, which
+         * is the scheduled start time in open loop mode. Written is
+         * the number of statements, or rows for large transactions. */
+        struct trx_context
+        {
+            std::chrono::steady_clock::time_point start;
+            long long ddl_events;
+            bool ddl_active;
+            size_t written;
+            int err;
+            trx_context()
+                : start()
+                , ddl_events()
+                , ddl_active()
+                , written()
+                , err()
+            { }
+        } trx_;
         struct stats stats_;
     };
 }
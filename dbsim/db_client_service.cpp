@@ -29,6 +29,79 @@ db::client_service::client_service(db::client& client)
     , client_state_(client_.client_state())
 { }
 
+int db::client_service::prepare_data_for_replication()
+{
+    // Replicate the part of streaming transaction log which was not
+    // replicated in fragments.
+    const size_t position(
+        client_state_.transaction().streaming_context().log_position());
+    if (client_.trx_log_.size() > position)
+    {
+        return client_state_.append_data(
+            wsrep::const_buffer(client_.trx_log_.data() + position,
+                                client_.trx_log_.size() - position));
+    }
+    return 0;
+}
+
+void db::client_service::cleanup_transaction()
+{
+    if (is_prepared_xa() && client_.se_trx_.active())
+    {
+        // Prepared XA transaction is detached from the client, hand
+        // the storage engine transaction over to the streaming
+        // applier which took over the transaction.
+        db::high_priority_service* sa(
+            static_cast<db::high_priority_service*>(
+                client_.server_state_.find_streaming_applier(
+                    client_state_.transaction().xid())));
+        if (sa)
+        {
+            sa->adopt_storage_transaction(client_);
+        }
+        else
+        {
+            client_.se_trx_.rollback();
+        }
+    }
+}
+
+size_t db::client_service::bytes_generated() const
+{
+    return client_.trx_log_.size();
+}
+
+int db::client_service::prepare_fragment_for_replication(
+    wsrep::mutable_buffer& buffer, size_t& position)
+{
+    const size_t log_position(
+        client_state_.transaction().streaming_context().log_position());
+    assert(log_position <= client_.trx_log_.size());
+    buffer.push_back(client_.trx_log_.data() + log_position,
+                     client_.trx_log_.data() + client_.trx_log_.size());
+    position = client_.trx_log_.size();
+    return 0;
+}
+
+int db::client_service::remove_fragments()
+{
+    // Fragments are removed when the storage engine transaction
+    // commits, or immediately if there is no active transaction.
+    const wsrep::transaction& transaction(client_state_.transaction());
+    client_.se_trx_.remove_fragments(transaction.server_id(),
+                                     transaction.id());
+    return 0;
+}
+
+bool db::client_service::is_prepared_xa()
+{
+    // XA transaction remains open in the client between XA PREPARE
+    // and XA COMMIT statements.
+    const wsrep::transaction& transaction(client_state_.transaction());
+    return (transaction.is_xa() &&
+            transaction.state() == wsrep::transaction::s_prepared);
+}
+
 int db::client_service::bf_rollback()
 {
     int ret(client_state_.before_rollback());
@@ -38,26 +38,16 @@ namespace db
         { return false; }
         void reset_globals() override { }
         void store_globals() override { }
-        int prepare_data_for_replication() override
-        {
-            return 0;
-        }
-        void cleanup_transaction() override { }
-        size_t bytes_generated() const override
-        {
-            return 0;
-        }
+        int prepare_data_for_replication() override;
+        void cleanup_transaction() override;
+        size_t bytes_generated() const override;
         bool statement_allowed_for_streaming() const override
         {
             return true;
         }
         int prepare_fragment_for_replication(wsrep::mutable_buffer&,
-                                             size_t& position) override
-        {
-            position = 0;
-            return 0;
-        }
-        int remove_fragments() override { return 0; }
+                                             size_t& position) override;
+        int remove_fragments() override;
         int bf_rollback() override;
         void will_replay() override { }
         void signal_replayed() override { }
@@ -79,13 +69,10 @@ namespace db
 
         bool is_explicit_xa() override
         {
-            return false;
+            return is_prepared_xa();
         }
 
-        bool is_prepared_xa() override
-        {
-            return false;
-        }
+        bool is_prepared_xa() override;
 
         bool is_xa_rollback() override
         {
@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_ddl.hpp"
+#include "db_client.hpp"
+#include "db_server.hpp"
+
+#include "wsrep/exception.hpp"
+#include "wsrep/logger.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    const size_t event_size(sizeof(uint32_t) + 2*sizeof(uint64_t));
+}
+
+wsrep::key_array db::ddl_event::keys() const
+{
+    wsrep::key_array ret;
+    wsrep::key key(wsrep::key::exclusive);
+    switch (scope)
+    {
+    case sc_none:
+        break;
+    case sc_table:
+        key.append_key_part("dbms", 4);
+        ret.push_back(key);
+        break;
+    case sc_row:
+        // Same key as shared row written by clients.
+        key.append_key_part("dbms", 4);
+        key.append_key_part("shared", 6);
+        key.append_key_part(&row, sizeof(row));
+        ret.push_back(key);
+        break;
+    }
+    return ret;
+}
+
+void db::ddl_event::execute() const
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(duration_usec));
+}
+
+std::string db::ddl_event::serialize() const
+{
+    std::string ret(event_size, '\0');
+    const uint32_t s(scope);
+    ::memcpy(&ret[0], &s, sizeof(s));
+    ::memcpy(&ret[sizeof(s)], &row, sizeof(row));
+    ::memcpy(&ret[sizeof(s) + sizeof(row)], &duration_usec,
+             sizeof(duration_usec));
+    return ret;
+}
+
+db::ddl_event db::ddl_event::deserialize(const wsrep::const_buffer& data)
+{
+    uint32_t s;
+    if (data.size() != event_size ||
+        (::memcpy(&s, data.data(), sizeof(s)), s > sc_row))
+    {
+        throw wsrep::runtime_error("Invalid DDL event");
+    }
+    ddl_event ret;
+    ret.scope = static_cast<enum scope>(s);
+    ::memcpy(&ret.row, data.data() + sizeof(s), sizeof(ret.row));
+    ::memcpy(&ret.duration_usec, data.data() + sizeof(s) + sizeof(ret.row),
+             sizeof(ret.duration_usec));
+    return ret;
+}
+
+enum db::ddl_event::scope db::ddl_event::parse_scope(const std::string& name)
+{
+    if (name == "none") return sc_none;
+    if (name == "table") return sc_table;
+    if (name == "row") return sc_row;
+    throw std::invalid_argument("Unknown DDL scope: " + name);
+}
+
+db::ddl_generator::ddl_generator(db::server& server,
+                                 const db::params& params,
+                                 double rate)
+    : server_(server)
+    , params_(params)
+    , rate_(rate)
+    , scope_(db::ddl_event::parse_scope(params.ddl_scope))
+    , mutex_()
+    , stopped_()
+    , issued_()
+    , failed_()
+    , latency_()
+    , thread_()
+{ }
+
+db::ddl_generator::~ddl_generator()
+{
+    stop();
+}
+
+void db::ddl_generator::start()
+{
+    thread_ = boost::thread(&db::ddl_generator::run, this);
+}
+
+void db::ddl_generator::stop()
+{
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+long long db::ddl_generator::issued() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return issued_;
+}
+
+long long db::ddl_generator::failed() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return failed_;
+}
+
+db::histogram db::ddl_generator::latency() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return latency_;
+}
+
+void db::ddl_generator::run()
+{
+    db::client client(server_, server_.next_client_id(),
+                      wsrep::client_state::m_local, params_);
+    wsrep::client_state& cs(client.client_state());
+    cs.open(cs.id());
+    std::random_device random_device;
+    std::default_random_engine random_engine(random_device());
+    std::exponential_distribution<double> interval(rate_);
+    clock::time_point scheduled(clock::now());
+    for (;;)
+    {
+        scheduled += std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(interval(random_engine)));
+        if (not wait_until(scheduled)) break;
+        db::ddl_event event;
+        event.scope = scope_;
+        event.row = server_.key_distribution()(random_engine);
+        event.duration_usec = params_.ddl_duration;
+        const clock::time_point start(clock::now());
+        cs.reset_error();
+        const int err(params_.ddl_type == "nbo"
+                      ? execute_nbo(client, event)
+                      : execute_toi(client, event));
+        const uint64_t usec(
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    clock::now() - start).count()));
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        ++issued_;
+        if (err)
+        {
+            ++failed_;
+        }
+        else
+        {
+            latency_.record(usec);
+        }
+    }
+    cs.close();
+    cs.cleanup();
+}
+
+bool db::ddl_generator::wait_until(clock::time_point tp)
+{
+    // Sleep in short steps to keep stop() responsive with low rates.
+    for (;;)
+    {
+        {
+            wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+            if (stopped_) return false;
+        }
+        const clock::time_point now(clock::now());
+        if (now >= tp) return true;
+        std::this_thread::sleep_for(
+            std::min(clock::duration(tp - now),
+                     clock::duration(std::chrono::milliseconds(10))));
+    }
+}
+
+int db::ddl_generator::execute_toi(db::client& client,
+                                   const db::ddl_event& event)
+{
+    wsrep::client_state& cs(client.client_state());
+    const std::string data(event.serialize());
+    const wsrep::key_array keys(event.keys());
+    int err(cs.before_command());
+    if (err == 0)
+    {
+        cs.before_statement();
+        err = cs.enter_toi_local(keys,
+                                 wsrep::const_buffer(data.data(), data.size()));
+        if (err == 0)
+        {
+            server_.storage_engine().begin_ddl(event, &client,
+                                               cs.toi_meta().seqno());
+            event.execute();
+            server_.storage_engine().end_ddl(event, &client);
+            err = cs.leave_toi_local(wsrep::mutable_buffer());
+        }
+        cs.after_statement();
+    }
+    cs.after_command_before_result();
+    cs.after_command_after_result();
+    return err;
+}
+
+int db::ddl_generator::execute_nbo(db::client& client,
+                                   const db::ddl_event& event)
+{
+    wsrep::client_state& cs(client.client_state());
+    const std::string data(event.serialize());
+    const wsrep::key_array keys(event.keys());
+    int err(cs.before_command());
+    if (err == 0)
+    {
+        cs.before_statement();
+        err = cs.begin_nbo_phase_one(
+            keys, wsrep::const_buffer(data.data(), data.size()));
+        if (err == 0)
+        {
+            // Resources are acquired in phase one, the operation
+            // itself is executed outside of total order.
+            server_.storage_engine().begin_ddl(event, &client,
+                                               cs.toi_meta().seqno());
+            err = cs.end_nbo_phase_one(wsrep::mutable_buffer());
+            event.execute();
+            err = cs.begin_nbo_phase_two(keys) || err;
+            server_.storage_engine().end_ddl(event, &client);
+            if (cs.mode() == wsrep::client_state::m_nbo)
+            {
+                err = cs.end_nbo_phase_two(wsrep::mutable_buffer()) || err;
+            }
+        }
+        cs.after_statement();
+    }
+    cs.after_command_before_result();
+    cs.after_command_after_result();
+    return err;
+}
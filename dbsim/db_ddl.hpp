@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_ddl.hpp
+ *
+ * DDL workload for dbsim.
+ *
+ * DDL generator issues TOI or NBO operations with Poisson arrivals
+ * on a dedicated client of the server. Each operation carries a DDL
+ * event in its write set data, so that appliers on the other servers
+ * execute the same operation. Executing DDL event in the storage
+ * engine BF aborts conflicting local transactions in total order
+ * and holds the event scope locked for the duration of the event,
+ * see db::storage_engine::begin_ddl().
+ */
+
+#ifndef WSREP_DB_DDL_HPP
+#define WSREP_DB_DDL_HPP
+
+#include "db_params.hpp"
+#include "db_stats.hpp"
+
+#include "wsrep/buffer.hpp"
+#include "wsrep/key.hpp"
+#include "wsrep/mutex.hpp"
+
+#include <boost/thread.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace db
+{
+    class server;
+    class client;
+
+    /*
+     * DDL operation executed in total order.
+     */
+    struct ddl_event
+    {
+        enum scope
+        {
+            /* No keys, serialized only by total order. */
+            sc_none,
+            /* Whole table, conflicts with all transactions. */
+            sc_table,
+            /* Single shared row. */
+            sc_row
+        };
+        enum scope scope;
+        uint64_t row;
+        uint64_t duration_usec;
+
+        /*
+         * Keys certified for the event. Keys refer to the event data,
+         * the event must outlive the returned keys.
+         */
+        wsrep::key_array keys() const;
+        /* Spend the duration of the event. */
+        void execute() const;
+        std::string serialize() const;
+        /*
+         * Parse event from write set data.
+         *
+         * @throw wsrep::runtime_error If the data is not a DDL event.
+         */
+        static ddl_event deserialize(const wsrep::const_buffer&);
+        /*
+         * Parse scope name: none, table or row.
+         *
+         * @throw std::invalid_argument If the name is not known.
+         */
+        static enum scope parse_scope(const std::string&);
+    };
+
+    class ddl_generator
+    {
+    public:
+        /*
+         * Constructor.
+         *
+         * @param rate DDL operations per second.
+         */
+        ddl_generator(db::server& server, const db::params& params,
+                      double rate);
+        ~ddl_generator();
+        void start();
+        void stop();
+        /* Number of operations issued and failed, latencies of
+         * successful operations in microseconds. */
+        long long issued() const;
+        long long failed() const;
+        db::histogram latency() const;
+    private:
+        ddl_generator(const ddl_generator&);
+        ddl_generator& operator=(const ddl_generator&);
+        typedef std::chrono::steady_clock clock;
+        void run();
+        bool wait_until(clock::time_point);
+        int execute_toi(db::client&, const db::ddl_event&);
+        int execute_nbo(db::client&, const db::ddl_event&);
+
+        db::server& server_;
+        const db::params& params_;
+        const double rate_;
+        const enum ddl_event::scope scope_;
+        mutable wsrep::default_mutex mutex_;
+        bool stopped_;
+        long long issued_;
+        long long failed_;
+        db::histogram latency_;
+        boost::thread thread_;
+    };
+}
+
+#endif // WSREP_DB_DDL_HPP
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_fragment_store.hpp"
+
+#include "wsrep/compiler.hpp"
+#include "wsrep/exception.hpp"
+#include "wsrep/logger.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    enum record_type : uint8_t { rt_append = 1, rt_remove = 2 };
+    const size_t header_size(2*sizeof(uint32_t));
+    const size_t key_size(sizeof(uint8_t) + sizeof(wsrep::id::native_type)
+                          + sizeof(uint64_t));
+    const size_t append_size(key_size + sizeof(int64_t) + sizeof(int32_t));
+
+    uint32_t checksum(const char* ptr, size_t len)
+    {
+        // FNV-1a
+        uint32_t ret(2166136261U);
+        for (size_t i(0); i < len; ++i)
+        {
+            ret = (ret ^ static_cast<unsigned char>(ptr[i])) * 16777619U;
+        }
+        return ret;
+    }
+
+    template <typename T>
+    void append_value(std::string& buf, const T& value)
+    {
+        buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T read_value(const char*& ptr)
+    {
+        T ret;
+        ::memcpy(&ret, ptr, sizeof(ret));
+        ptr += sizeof(ret);
+        return ret;
+    }
+
+    // Record with header and key part of the payload filled in.
+    std::string make_record(record_type type, const wsrep::id& server_id,
+                            wsrep::transaction_id transaction_id)
+    {
+        std::string ret(header_size, '\0');
+        append_value(ret, type);
+        ret.append(static_cast<const char*>(server_id.data()),
+                   server_id.size());
+        append_value(ret, uint64_t(transaction_id.get()));
+        return ret;
+    }
+
+    void finish_record(std::string& record)
+    {
+        const uint32_t size(static_cast<uint32_t>(record.size() - header_size));
+        const uint32_t sum(checksum(&record[header_size], size));
+        ::memcpy(&record[0], &size, sizeof(size));
+        ::memcpy(&record[sizeof(size)], &sum, sizeof(sum));
+    }
+}
+
+db::fragment_store::fragment_store(bool fsync)
+    : mutex_()
+    , fsync_(fsync)
+    , fd_(-1)
+    , size_()
+    , index_()
+    , appended_()
+    , removed_()
+{ }
+
+db::fragment_store::~fragment_store()
+{
+    if (fd_ >= 0) ::close(fd_);
+}
+
+void db::fragment_store::open(const std::string& file)
+{
+    fd_ = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+    {
+        throw wsrep::runtime_error(
+            "Failed to open fragment store " + file + ": " + ::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd_, &st))
+    {
+        throw wsrep::runtime_error(
+            std::string("Fragment store stat failed: ") + ::strerror(errno));
+    }
+    std::vector<char> buf(size_t(st.st_size));
+    if (buf.size() &&
+        ::pread(fd_, buf.data(), buf.size(), 0) != ssize_t(buf.size()))
+    {
+        throw wsrep::runtime_error(
+            std::string("Fragment store read failed: ") + ::strerror(errno));
+    }
+
+    size_t pos(0);
+    while (pos + header_size <= buf.size())
+    {
+        uint32_t size, sum;
+        ::memcpy(&size, buf.data() + pos, sizeof(size));
+        ::memcpy(&sum, buf.data() + pos + sizeof(size), sizeof(sum));
+        const char* ptr(buf.data() + pos + header_size);
+        if (size < key_size || pos + header_size + size > buf.size() ||
+            checksum(ptr, size) != sum)
+        {
+            break;
+        }
+        const uint8_t type(read_value<uint8_t>(ptr));
+        const wsrep::id server_id(ptr, sizeof(wsrep::id::native_type));
+        ptr += sizeof(wsrep::id::native_type);
+        const wsrep::transaction_id transaction_id(read_value<uint64_t>(ptr));
+        const key k(server_id, transaction_id);
+        if (type == rt_append && size >= append_size)
+        {
+            const int64_t seqno(read_value<int64_t>(ptr));
+            const int32_t flags(read_value<int32_t>(ptr));
+            index_[k].push_back(
+                location{ wsrep::seqno(seqno), flags,
+                          pos + header_size + append_size,
+                          size - append_size });
+        }
+        else if (type == rt_remove)
+        {
+            index_.erase(k);
+        }
+        else
+        {
+            break;
+        }
+        pos += header_size + size;
+    }
+    if (pos != buf.size())
+    {
+        wsrep::log_warning() << "Truncating fragment store " << file
+                             << " from " << buf.size() << " to " << pos
+                             << " bytes";
+        if (::ftruncate(fd_, off_t(pos)))
+        {
+            throw wsrep::runtime_error(
+                std::string("Fragment store truncate failed: ")
+                + ::strerror(errno));
+        }
+    }
+    size_ = pos;
+    wsrep::log_info() << "Recovered " << index_.size()
+                      << " streaming transactions from fragment store "
+                      << file;
+}
+
+void db::fragment_store::append(const wsrep::id& server_id,
+                                wsrep::transaction_id transaction_id,
+                                wsrep::seqno seqno,
+                                int flags,
+                                const wsrep::const_buffer& data)
+{
+    std::string record(make_record(rt_append, server_id, transaction_id));
+    append_value(record, int64_t(seqno.get()));
+    append_value(record, int32_t(flags));
+    record.append(data.data(), data.size());
+    finish_record(record);
+
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    const size_t offset(size_ + header_size + append_size);
+    write_record(lock, record);
+    index_[key(server_id, transaction_id)].push_back(
+        location{ seqno, flags, offset, data.size() });
+    ++appended_;
+}
+
+void db::fragment_store::remove(const wsrep::id& server_id,
+                                wsrep::transaction_id transaction_id)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    index::iterator i(index_.find(key(server_id, transaction_id)));
+    if (i == index_.end()) return;
+    removed_ += static_cast<long long>(i->second.size());
+    index_.erase(i);
+    if (index_.empty())
+    {
+        // No fragments left to recover, start a new segment.
+        if (::ftruncate(fd_, 0))
+        {
+            throw wsrep::runtime_error(
+                std::string("Fragment store truncate failed: ")
+                + ::strerror(errno));
+        }
+        size_ = 0;
+        return;
+    }
+    std::string record(make_record(rt_remove, server_id, transaction_id));
+    finish_record(record);
+    write_record(lock, record);
+}
+
+void db::fragment_store::recover(const recover_fn& recover) const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    for (index::const_iterator i(index_.begin()); i != index_.end(); ++i)
+    {
+        std::vector<location> locations(i->second);
+        std::sort(locations.begin(), locations.end(),
+                  [](const location& a, const location& b)
+                  { return a.seqno < b.seqno; });
+        std::vector<fragment> fragments;
+        for (const auto& l : locations)
+        {
+            std::string data(l.size, '\0');
+            if (l.size && ::pread(fd_, &data[0], l.size, off_t(l.offset)) !=
+                ssize_t(l.size))
+            {
+                throw wsrep::runtime_error(
+                    std::string("Fragment store read failed: ")
+                    + ::strerror(errno));
+            }
+            fragments.push_back(fragment{ l.seqno, l.flags, std::move(data) });
+        }
+        recover(i->first.first, i->first.second, fragments);
+    }
+}
+
+size_t db::fragment_store::transactions() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return index_.size();
+}
+
+long long db::fragment_store::appended() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return appended_;
+}
+
+long long db::fragment_store::removed() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return removed_;
+}
+
+void db::fragment_store::write_record(
+    wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED,
+    const std::string& record)
+{
+    assert(lock.owns_lock());
+    const char* ptr(record.data());
+    size_t len(record.size());
+    while (len)
+    {
+        ssize_t ret(::pwrite(fd_, ptr, len, off_t(size_)));
+        if (ret < 0)
+        {
+            if (errno == EINTR) continue;
+            throw wsrep::runtime_error(
+                std::string("Fragment store write failed: ")
+                + ::strerror(errno));
+        }
+        ptr += ret;
+        len -= size_t(ret);
+        size_ += size_t(ret);
+    }
+    if (fsync_ && ::fdatasync(fd_))
+    {
+        throw wsrep::runtime_error(
+            std::string("Fragment store sync failed: ") + ::strerror(errno));
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_fragment_store.hpp
+ *
+ * Streaming replication fragment store for dbsim storage engine.
+ *
+ * Fragments of streaming transactions are appended to a segment file
+ * in server data directory. An in-memory index maps each streaming
+ * transaction, identified by originating server ID and transaction ID,
+ * to file offsets of its fragments ordered by seqno. When a streaming
+ * transaction commits or rolls back, all of its fragments are removed
+ * with a single remove record. The segment file is truncated when
+ * the last transaction is removed from the index.
+ *
+ * At startup the index is rebuilt from the segment file and the
+ * fragments of transactions which were in flight are handed to
+ * streaming appliers for recovery.
+ *
+ * Record format:
+ *   uint32 payload size
+ *   uint32 payload checksum
+ *   payload: record type (uint8), server ID (16 bytes),
+ *            transaction ID (uint64), and for append records
+ *            seqno (int64), flags (int32) and fragment data
+ */
+
+#ifndef WSREP_DB_FRAGMENT_STORE_HPP
+#define WSREP_DB_FRAGMENT_STORE_HPP
+
+#include "wsrep/buffer.hpp"
+#include "wsrep/id.hpp"
+#include "wsrep/lock.hpp"
+#include "wsrep/mutex.hpp"
+#include "wsrep/seqno.hpp"
+#include "wsrep/transaction_id.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace db
+{
+    class fragment_store
+    {
+    public:
+        struct fragment
+        {
+            wsrep::seqno seqno;
+            int flags;
+            std::string data;
+        };
+        typedef std::function<void(const wsrep::id&,
+                                   wsrep::transaction_id,
+                                   const std::vector<fragment>&)>
+        recover_fn;
+
+        /**
+         * Constructor.
+         *
+         * @param fsync If true, appends and removals are synced
+         *              before returning.
+         */
+        explicit fragment_store(bool fsync);
+        ~fragment_store();
+
+        /**
+         * Open segment file, creating it if it does not exist, and
+         * rebuild the index. Incomplete or corrupted records at the
+         * end of the file are truncated.
+         *
+         * @throw wsrep::runtime_error If the file cannot be opened.
+         */
+        void open(const std::string& file);
+
+        /**
+         * Append fragment of streaming transaction.
+         */
+        void append(const wsrep::id& server_id,
+                    wsrep::transaction_id transaction_id,
+                    wsrep::seqno seqno,
+                    int flags,
+                    const wsrep::const_buffer& data);
+
+        /**
+         * Remove all fragments of streaming transaction. No-op if
+         * the transaction has no stored fragments.
+         */
+        void remove(const wsrep::id& server_id,
+                    wsrep::transaction_id transaction_id);
+
+        /**
+         * Call recover for each stored transaction with its fragments
+         * in seqno order.
+         */
+        void recover(const recover_fn& recover) const;
+
+        /** Number of streaming transactions with stored fragments. */
+        size_t transactions() const;
+        /** Number of fragments appended and removed. */
+        long long appended() const;
+        long long removed() const;
+    private:
+        fragment_store(const fragment_store&);
+        fragment_store& operator=(const fragment_store&);
+
+        struct location
+        {
+            wsrep::seqno seqno;
+            int flags;
+            size_t offset;
+            size_t size;
+        };
+        typedef std::pair<wsrep::id, wsrep::transaction_id> key;
+        typedef std::map<key, std::vector<location>> index;
+
+        void write_record(wsrep::unique_lock<wsrep::mutex>&,
+                          const std::string& record);
+
+        mutable wsrep::default_mutex mutex_;
+        const bool fsync_;
+        int fd_;
+        size_t size_;
+        index index_;
+        long long appended_;
+        long long removed_;
+    };
+}
+
+#endif // WSREP_DB_FRAGMENT_STORE_HPP
@@ -46,38 +46,92 @@ const wsrep::transaction& db::high_priority_service::transaction() const
     return client_.client_state().transaction();
 }
 
-int db::high_priority_service::adopt_transaction(const wsrep::transaction&)
+int db::high_priority_service::adopt_transaction(
+    const wsrep::transaction& transaction)
 {
-    throw wsrep::not_implemented_error();
+    client_.client_state().adopt_transaction(transaction);
+    if (transaction.state() == wsrep::transaction::s_prepared)
+    {
+        // Detached XA transaction, can be committed by xid.
+        return client_.client_state().restore_xid(transaction.xid());
+    }
+    return 0;
 }
 
 int db::high_priority_service::apply_write_set(
-    const wsrep::ws_meta&,
+    const wsrep::ws_meta& ws_meta,
     const wsrep::const_buffer& buf,
     wsrep::mutable_buffer&)
 {
-    client_.se_trx_.start(&client_);
-    client_.se_trx_.apply(client_.client_state().transaction());
-    assert(buf.size() > sizeof(uint64_t));
-    ::memcpy(&commit_seqno_, buf.data() + buf.size() - sizeof(uint64_t),
-             sizeof(uint64_t));
+    // Streaming applier keeps the storage engine transaction open
+    // over fragments.
+    if (not client_.se_trx_.active()) client_.se_trx_.start(&client_);
+    wsrep::const_buffer rows(buf);
+    if (wsrep::commits_transaction(ws_meta.flags()))
+    {
+        // Row images of committing write set are followed by commit
+        // seqno of the originator. Commit by xid carries no data.
+        if (buf.size() < sizeof(uint64_t))
+        {
+            assert(buf.size() == 0);
+            return 0;
+        }
+        ::memcpy(&commit_seqno_, buf.data() + buf.size() - sizeof(uint64_t),
+                 sizeof(uint64_t));
+        rows = wsrep::const_buffer(buf.data(), buf.size() - sizeof(uint64_t));
+    }
+    else
+    {
+        client_.client_state().fragment_applied(ws_meta.seqno());
+    }
+    client_.se_trx_.apply(client_.client_state().transaction(), rows);
+    return 0;
+}
+
+int db::high_priority_service::append_fragment_and_commit(
+    const wsrep::ws_handle& ws_handle,
+    const wsrep::ws_meta& ws_meta,
+    const wsrep::const_buffer& data,
+    const wsrep::xid&)
+{
+    int ret(client_.client_state().start_transaction(ws_handle, ws_meta));
+    if (ret == 0)
+    {
+        server_.storage_engine().fragment_store().append(
+            ws_meta.server_id(), ws_meta.transaction_id(), ws_meta.seqno(),
+            ws_meta.flags(), data);
+    }
+    ret = ret || commit(ws_handle, ws_meta);
+    return ret;
+}
+
+int db::high_priority_service::remove_fragments(const wsrep::ws_meta& ws_meta)
+{
+    client_.se_trx_.remove_fragments(ws_meta.server_id(),
+                                     ws_meta.transaction_id());
     return 0;
 }
 
 int db::high_priority_service::apply_toi(
-    const wsrep::ws_meta&,
-    const wsrep::const_buffer&,
+    const wsrep::ws_meta& ws_meta,
+    const wsrep::const_buffer& data,
     wsrep::mutable_buffer&)
 {
-    throw wsrep::not_implemented_error();
+    const db::ddl_event event(db::ddl_event::deserialize(data));
+    client_.client_state_.enter_toi_mode(ws_meta);
+    server_.storage_engine().begin_ddl(event, &client_, ws_meta.seqno());
+    event.execute();
+    server_.storage_engine().end_ddl(event, &client_);
+    client_.client_state_.leave_toi_mode();
+    return 0;
 }
 
 int db::high_priority_service::apply_nbo_begin(
-    const wsrep::ws_meta&,
-    const wsrep::const_buffer&,
+    const wsrep::ws_meta& ws_meta,
+    const wsrep::const_buffer& data,
     wsrep::mutable_buffer&)
 {
-    throw wsrep::not_implemented_error();
+    return server_.start_nbo(ws_meta, db::ddl_event::deserialize(data));
 }
 
 int db::high_priority_service::commit(const wsrep::ws_handle& ws_handle,
@@ -95,6 +149,7 @@ int db::high_priority_service::commit(const wsrep::ws_handle& ws_handle,
                                              commit_seqno_);
     }
     ret = ret || client_.client_state_.ordered_commit();
+    if (ret == 0) client_.se_trx_.wait_durable();
     ret = ret || client_.client_state_.after_commit();
     return ret;
 }
@@ -147,3 +202,39 @@ bool db::high_priority_service::is_replaying() const
 {
     return false;
 }
+
+void db::high_priority_service::adopt_storage_transaction(db::client& client)
+{
+    client_.se_trx_.adopt(&client_, client.se_trx_);
+}
+
+int db::high_priority_service::commit_by_xid()
+{
+    const wsrep::transaction& trx(transaction());
+    assert(trx.state() == wsrep::transaction::s_prepared);
+    client_.se_trx_.remove_fragments(trx.server_id(), trx.id());
+    // Commit by xid is not ordered by the provider.
+    client_.se_trx_.commit(wsrep::gtid::undefined());
+    // Applier transaction remains in prepared state, release it
+    // the same way as rolled back streaming applier.
+    return rollback(wsrep::ws_handle(), wsrep::ws_meta());
+}
+
+db::streaming_applier_service::streaming_applier_service(
+    db::server& server, std::unique_ptr<db::client> applier)
+    : db::high_priority_service(server, *applier)
+    , applier_(std::move(applier))
+{
+    wsrep::client_state& cs(applier_->client_state());
+    cs.open(cs.id());
+    cs.before_command();
+}
+
+db::streaming_applier_service::~streaming_applier_service()
+{
+    wsrep::client_state& cs(applier_->client_state());
+    cs.after_command_before_result();
+    cs.after_command_after_result();
+    cs.close();
+    cs.cleanup();
+}
@@ -22,6 +22,8 @@
 
 #include "wsrep/high_priority_service.hpp"
 
+#include <memory>
+
 namespace db
 {
     class server;
@@ -42,10 +44,8 @@ namespace db
             const wsrep::ws_handle&,
             const wsrep::ws_meta&,
             const wsrep::const_buffer&,
-            const wsrep::xid&) override
-        { return 0; }
-        int remove_fragments(const wsrep::ws_meta&) override
-        { return 0; }
+            const wsrep::xid&) override;
+        int remove_fragments(const wsrep::ws_meta&) override;
         int commit(const wsrep::ws_handle&, const wsrep::ws_meta&) override;
         int rollback(const wsrep::ws_handle&, const wsrep::ws_meta&) override;
         int apply_toi(const wsrep::ws_meta&, const wsrep::const_buffer&,
@@ -64,6 +64,15 @@ namespace db
                                 wsrep::mutable_buffer&) override;
         virtual bool is_replaying() const override;
         void debug_crash(const char*) override { }
+        /* Take over storage engine transaction of detached XA
+         * transaction from the client which prepared it. */
+        void adopt_storage_transaction(db::client&);
+        /*
+         * Commit prepared XA transaction which was committed by xid
+         * from local client. The storage engine transaction is
+         * committed and the applier transaction is released.
+         */
+        int commit_by_xid();
     private:
         high_priority_service(const high_priority_service&);
         high_priority_service& operator=(const high_priority_service&);
@@ -72,6 +81,20 @@ namespace db
         uint64_t commit_seqno_;
     };
 
+    /*
+     * High priority service for streaming applier. Owns the client
+     * which holds the streaming transaction between fragments.
+     */
+    class streaming_applier_service : public db::high_priority_service
+    {
+    public:
+        streaming_applier_service(db::server& server,
+                                  std::unique_ptr<db::client> applier);
+        ~streaming_applier_service() override;
+    private:
+        std::unique_ptr<db::client> applier_;
+    };
+
     class replayer_service : public db::high_priority_service
     {
     public:
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_load_generator.hpp"
+
+#include <random>
+#include <thread>
+
+db::load_generator::load_generator(double rate, size_t transactions,
+                                   clock::time_point end)
+    : mutex_()
+    , cond_()
+    , rate_(rate)
+    , transactions_(transactions)
+    , end_(end)
+    , queue_()
+    , max_queue_length_()
+    , stopped_()
+    , thread_()
+{ }
+
+db::load_generator::~load_generator()
+{
+    stop();
+}
+
+void db::load_generator::start()
+{
+    thread_ = boost::thread(&db::load_generator::run, this);
+}
+
+void db::load_generator::stop()
+{
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        stopped_ = true;
+        cond_.notify_all();
+    }
+    if (thread_.joinable()) thread_.join();
+}
+
+bool db::load_generator::next(clock::time_point& scheduled)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    while (queue_.empty() && not stopped_)
+    {
+        cond_.wait(lock);
+    }
+    if (queue_.empty()) return false;
+    scheduled = queue_.front();
+    queue_.pop_front();
+    return true;
+}
+
+size_t db::load_generator::max_queue_length() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return max_queue_length_;
+}
+
+void db::load_generator::run()
+{
+    std::random_device random_device;
+    std::default_random_engine random_engine(random_device());
+    std::exponential_distribution<double> interval(rate_);
+    // Schedule is computed from the start time so that sleep overshoot
+    // does not accumulate and reduce the rate.
+    clock::time_point scheduled(clock::now());
+    for (size_t i(0); transactions_ == 0 || i < transactions_; ++i)
+    {
+        scheduled += std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(interval(random_engine)));
+        if (transactions_ == 0 && scheduled >= end_) break;
+        std::this_thread::sleep_until(scheduled);
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        if (stopped_) return;
+        queue_.push_back(scheduled);
+        if (queue_.size() > max_queue_length_)
+        {
+            max_queue_length_ = queue_.size();
+        }
+        cond_.notify_one();
+    }
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    stopped_ = true;
+    cond_.notify_all();
+}
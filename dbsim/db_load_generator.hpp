@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_load_generator.hpp
+ *
+ * Open loop load generator.
+ *
+ * In closed loop mode each client starts the next transaction when
+ * the previous one has completed, so a slow server also slows down
+ * the arrival of new transactions and queueing delay is not visible
+ * in measured latencies. The open loop load generator schedules
+ * transaction start times with Poisson arrivals at a given rate
+ * independently of clients. Clients pick up the scheduled
+ * transactions from a queue and the latency is measured from the
+ * scheduled start time.
+ */
+
+#ifndef WSREP_DB_LOAD_GENERATOR_HPP
+#define WSREP_DB_LOAD_GENERATOR_HPP
+
+#include "wsrep/mutex.hpp"
+#include "wsrep/condition_variable.hpp"
+
+#include <boost/thread.hpp>
+
+#include <chrono>
+#include <deque>
+
+namespace db
+{
+    class load_generator
+    {
+    public:
+        typedef std::chrono::steady_clock clock;
+        /**
+         * Constructor.
+         *
+         * @param rate Transactions per second.
+         * @param transactions Number of transactions to schedule,
+         *        zero for no limit.
+         * @param end Time after which no more transactions are
+         *        scheduled, ignored if transactions is non-zero.
+         */
+        load_generator(double rate, size_t transactions,
+                       clock::time_point end);
+        ~load_generator();
+        void start();
+        /**
+         * Stop scheduling transactions and wake up waiting clients.
+         */
+        void stop();
+        /**
+         * Wait for the next scheduled transaction.
+         *
+         * @param[out] scheduled Scheduled start time of the transaction.
+         *
+         * @return True if a transaction was scheduled, false if the
+         *         generator has finished and the queue is empty.
+         */
+        bool next(clock::time_point& scheduled);
+        /** Maximum number of transactions waiting in the queue. */
+        size_t max_queue_length() const;
+    private:
+        load_generator(const load_generator&);
+        load_generator& operator=(const load_generator&);
+        void run();
+
+        mutable wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable cond_;
+        const double rate_;
+        const size_t transactions_;
+        const clock::time_point end_;
+        std::deque<clock::time_point> queue_;
+        size_t max_queue_length_;
+        bool stopped_;
+        boost::thread thread_;
+    };
+}
+
+#endif // WSREP_DB_LOAD_GENERATOR_HPP
@@ -18,6 +18,8 @@
  */
 
 #include "db_params.hpp"
+#include "db_ddl.hpp"
+#include "db_workload.hpp"
 
 #include <boost/program_options.hpp>
 #include <iostream>
@@ -37,6 +39,125 @@ namespace
                    << params.n_servers << "\n";
             }
         }
+        if (params.client_mutex != "default" &&
+            params.client_mutex != "adaptive")
+        {
+            os << "Error: --client-mutex=" << params.client_mutex
+               << " is not one of: default, adaptive\n";
+        }
+        if (not db::key_distribution::valid_name(params.key_distribution))
+        {
+            os << "Error: --key-distribution=" << params.key_distribution
+               << " is not one of: uniform, zipfian, hotspot\n";
+        }
+        if (params.zipf_theta <= 0. || params.zipf_theta >= 1.)
+        {
+            os << "Error: --zipf-theta=" << params.zipf_theta
+               << " must be in range (0, 1)\n";
+        }
+        if (params.hotspot_fraction <= 0. || params.hotspot_fraction > 1.)
+        {
+            os << "Error: --hotspot-fraction=" << params.hotspot_fraction
+               << " must be in range (0, 1]\n";
+        }
+        if (params.hotspot_probability < 0. ||
+            params.hotspot_probability > 1.)
+        {
+            os << "Error: --hotspot-probability="
+               << params.hotspot_probability
+               << " must be in range [0, 1]\n";
+        }
+        if (params.rate < 0.)
+        {
+            os << "Error: --rate=" << params.rate << " must not be negative\n";
+        }
+        if (params.keys_per_statement == 0)
+        {
+            os << "Error: --keys-per-statement must be at least 1\n";
+        }
+        if (params.statements_per_trx == 0)
+        {
+            os << "Error: --statements-per-trx must be at least 1\n";
+        }
+        try
+        {
+            db::key_type_mix mix(params.key_type_mix);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            os << "Error: --key-type-mix: " << e.what() << "\n";
+        }
+        if (params.large_trx_clients < 0. || params.large_trx_clients > 1.)
+        {
+            os << "Error: --large-trx-clients=" << params.large_trx_clients
+               << " must be in range [0, 1]\n";
+        }
+        if (params.large_trx_rows == 0)
+        {
+            os << "Error: --large-trx-rows must be at least 1\n";
+        }
+        try
+        {
+            (void)db::fragment_unit(params.fragment_unit);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            os << "Error: --fragment-unit: " << e.what() << "\n";
+        }
+        if (params.xa_clients < 0. || params.xa_clients > 1.)
+        {
+            os << "Error: --xa-clients=" << params.xa_clients
+               << " must be in range [0, 1]\n";
+        }
+        else if (params.large_trx_clients + params.xa_clients > 1.)
+        {
+            os << "Error: --large-trx-clients and --xa-clients must "
+               << "not exceed 1 in total\n";
+        }
+        if (params.xa_commit_by_xid < 0. || params.xa_commit_by_xid > 1.)
+        {
+            os << "Error: --xa-commit-by-xid=" << params.xa_commit_by_xid
+               << " must be in range [0, 1]\n";
+        }
+        if (params.xa_clients > 0. && params.check_sequential_consistency)
+        {
+            os << "Error: --xa-clients is not supported with "
+               << "--check-sequential-consistency\n";
+        }
+        if (params.thread_pool_size && params.row_store)
+        {
+            // BF aborted sessions waiting in the run queue would hold
+            // row locks until a worker picks them up, background
+            // rollback is not implemented.
+            os << "Error: --thread-pool-size is not supported with "
+               << "--row-store\n";
+        }
+        if (params.thread_pool_size && params.rate > 0.)
+        {
+            // A session waiting for its next scheduled arrival would
+            // block the worker thread and delay the sessions queued
+            // behind it.
+            os << "Error: --thread-pool-size is not supported with "
+               << "--rate\n";
+        }
+        if (params.ddl_rate < 0.)
+        {
+            os << "Error: --ddl-rate=" << params.ddl_rate
+               << " must not be negative\n";
+        }
+        if (params.ddl_type != "toi" && params.ddl_type != "nbo")
+        {
+            os << "Error: --ddl-type=" << params.ddl_type
+               << " must be toi or nbo\n";
+        }
+        try
+        {
+            (void)db::ddl_event::parse_scope(params.ddl_scope);
+        }
+        catch (const std::invalid_argument& e)
+        {
+            os << "Error: --ddl-scope: " << e.what() << "\n";
+        }
         if (os.str().size())
         {
             throw std::invalid_argument(os.str());
@@ -68,6 +189,23 @@ db::params db::parse_args(int argc, char** argv)
          "number of clients to start per master")
         ("transactions", po::value<size_t>(&params.n_transactions),
          "number of transactions run by a client")
+        ("duration", po::value<size_t>(&params.duration),
+         "run clients for given number of seconds after warmup instead "
+         "of fixed number of transactions (default 0, disabled)")
+        ("rate", po::value<double>(&params.rate),
+         "open loop mode: schedule transactions with Poisson arrivals at "
+         "given rate per second, divided evenly between master servers. "
+         "Clients execute scheduled transactions and latency is measured "
+         "from scheduled start time. With --transactions, each server "
+         "schedules transactions times clients transactions "
+         "(default 0, closed loop)")
+        ("warmup", po::value<size_t>(&params.warmup),
+         "number of seconds from the start of client load excluded from "
+         "latency and throughput measurement (default 0)")
+        ("results-json", po::value<std::string>(&params.results_json),
+         "write measurement results in JSON format to given file")
+        ("results-csv", po::value<std::string>(&params.results_csv),
+         "write per second throughput in CSV format to given file")
         ("rows", po::value<size_t>(&params.n_rows),
          "number of rows per table")
         ("max-data-size", po::value<size_t>(&params.max_data_size),
@@ -76,8 +214,117 @@ db::params db::parse_args(int argc, char** argv)
          "randomized payload data size (default 0)")
         ("alg-freq", po::value<size_t>(&params.alg_freq),
          "ALG frequency")
+        ("bf-abort-batch", po::value<size_t>(&params.bf_abort_batch),
+         "Maximum number of victims BF aborted in one bulk abort on "
+         "ALG event (default 1)")
+        ("client-registry", po::value<bool>(&params.client_registry),
+         "Select BF abort victims from wsrep-lib client registry "
+         "(default false)")
+        ("hot-rows", po::value<size_t>(&params.hot_rows),
+         "Number of hot rows shared by all clients. If non-zero, each "
+         "transaction updates also one randomly chosen hot row "
+         "(default 0)")
+        ("key-distribution",
+         po::value<std::string>(&params.key_distribution),
+         "Distribution of rows accessed by transactions: uniform, "
+         "zipfian or hotspot (default uniform)")
+        ("zipf-theta", po::value<double>(&params.zipf_theta),
+         "Skew of zipfian key distribution in range (0, 1) "
+         "(default 0.99)")
+        ("hotspot-fraction", po::value<double>(&params.hotspot_fraction),
+         "Fraction of rows in the hotspot (default 0.1)")
+        ("hotspot-probability",
+         po::value<double>(&params.hotspot_probability),
+         "Probability of accessing a row in the hotspot (default 0.9)")
+        ("shared-keys", po::value<bool>(&params.shared_keys),
+         "Rows are shared by all clients on all servers, so that "
+         "transactions of different clients conflict. If false, each "
+         "client accesses only its own rows (default false)")
+        ("keys-per-statement",
+         po::value<size_t>(&params.keys_per_statement),
+         "Number of keys appended by each statement (default 1)")
+        ("statements-per-trx",
+         po::value<size_t>(&params.statements_per_trx),
+         "Number of write statements per transaction (default 1)")
+        ("key-type-mix", po::value<std::string>(&params.key_type_mix),
+         "Comma separated weights for shared, reference, update and "
+         "exclusive keys (default 0,0,0,1)")
+        ("large-trx-clients", po::value<double>(&params.large_trx_clients),
+         "Fraction of clients on each server which run large "
+         "transactions instead of statements-per-trx statements "
+         "(default 0)")
+        ("large-trx-rows", po::value<size_t>(&params.large_trx_rows),
+         "Number of rows written by large transaction, keys-per-statement "
+         "rows in each statement (default 1000)")
+        ("large-trx-row-size", po::value<size_t>(&params.large_trx_row_size),
+         "Size of row data written by large transaction (default 100)")
+        ("fragment-unit", po::value<std::string>(&params.fragment_unit),
+         "Streaming replication fragment unit for large transactions: "
+         "bytes, rows or statements (default rows)")
+        ("fragment-size", po::value<size_t>(&params.fragment_size),
+         "Streaming replication fragment size for large transactions in "
+         "fragment units, zero disables streaming (default 0)")
+        ("xa-clients", po::value<double>(&params.xa_clients),
+         "Fraction of clients on each server which run XA transactions. "
+         "XA transactions are prepared in a separate statement and "
+         "replicate a fragment on prepare (default 0)")
+        ("xa-commit-by-xid", po::value<double>(&params.xa_commit_by_xid),
+         "Fraction of XA transactions which are detached after prepare "
+         "and committed by xid from another XA client (default 0)")
+        ("ddl-rate", po::value<double>(&params.ddl_rate),
+         "DDL operations per second for the whole cluster, issued by "
+         "a dedicated client on each server running clients "
+         "(default 0)")
+        ("ddl-type", po::value<std::string>(&params.ddl_type),
+         "DDL replication method: toi or nbo (default toi)")
+        ("ddl-scope", po::value<std::string>(&params.ddl_scope),
+         "Keys of DDL operation: none, table or row. Table scope "
+         "DDL BF aborts local transactions in total order and blocks "
+         "new ones until it completes, row scope DDL locks a shared "
+         "row if row store is enabled (default table)")
+        ("ddl-duration", po::value<size_t>(&params.ddl_duration),
+         "Execution time of DDL operation in microseconds. NBO "
+         "operations execute outside of total order (default 1000)")
+        ("row-store", po::value<bool>(&params.row_store),
+         "Store rows in storage engine. Local transactions lock the rows "
+         "they write, write sets carry row images and appliers BF abort "
+         "local lock holders. Shared and reference keys are not "
+         "locked (default false)")
+        ("wal", po::value<bool>(&params.wal),
+         "Write committed transactions to write-ahead log in server "
+         "data directory and recover position from it at startup "
+         "(default false)")
+        ("wal-fsync", po::value<bool>(&params.wal_fsync),
+         "Sync WAL with group commit before commit returns "
+         "(default true)")
+        ("fragment-fsync", po::value<bool>(&params.fragment_fsync),
+         "Sync streaming replication fragment store on fragment append "
+         "and removal (default true)")
+        ("sr-recovery-threads",
+         po::value<size_t>(&params.sr_recovery_threads),
+         "Number of threads reconstructing streaming appliers from "
+         "fragment store at startup (default 1)")
+        ("hot-key-detector", po::value<bool>(&params.hot_key_detector),
+         "Serialize local transactions on hot keys with wsrep-lib "
+         "hot key detector (default false)")
         ("sync-wait", po::value<bool>(&params.sync_wait),
          "Turn on sync wait for each transaction")
+        ("sync-wait-reads", po::value<size_t>(&params.sync_wait_reads),
+         "Number of sync wait reads performed before each transaction, "
+         "for simulating read heavy load (default 0)")
+        ("client-mutex", po::value<std::string>(&params.client_mutex),
+         "Client state mutex and condition variable implementation: "
+         "default (pthread) or adaptive (spin then park)")
+        ("pin-threads", po::value<bool>(&params.pin_threads),
+         "Pin client and applier threads of each server to the CPUs of "
+         "one NUMA node, servers are assigned to nodes round robin "
+         "(default false)")
+        ("thread-pool-size", po::value<size_t>(&params.thread_pool_size),
+         "Number of worker threads executing client commands on each "
+         "server. Client sessions are scheduled from a run queue for "
+         "each command, so that a session may migrate between workers. "
+         "Not supported with --rate. "
+         "Zero runs each client in its own thread (default 0)")
         ("debug-log-level", po::value<int>(&params.debug_log_level),
          "debug logging level: 0 - none, 1 - verbose")
         ("fast-exit", po::value<int>(&params.fast_exit),
@@ -30,17 +30,93 @@ namespace db
         size_t n_servers{0};
         size_t n_clients{0};
         size_t n_transactions{0};
+        /* Run time in seconds after warmup, overrides n_transactions. */
+        size_t duration{0};
+        /* Open loop arrival rate in transactions per second for the
+         * whole cluster, zero for closed loop clients. */
+        double rate{0};
+        /* Seconds excluded from latency and throughput measurement. */
+        size_t warmup{0};
         size_t n_rows{1000};
         size_t max_data_size{8}; // Maximum size of write set data payload.
         bool random_data_size{false}; // If true, randomize data payload size.
         /* Asymmetric lock granularity frequency. */
         size_t alg_freq{0};
+        /* Maximum number of victims BF aborted at once on ALG event. */
+        size_t bf_abort_batch{1};
+        /* Whether to track local transactions in wsrep client registry. */
+        bool client_registry{false};
+        /* Number of hot rows updated by all clients, zero disables. */
+        size_t hot_rows{0};
+        /* Row distribution: uniform, zipfian or hotspot. */
+        std::string key_distribution{"uniform"};
+        /* Skew of zipfian distribution, in range (0, 1). */
+        double zipf_theta{0.99};
+        /* Fraction of rows in hotspot and probability of hitting it. */
+        double hotspot_fraction{0.1};
+        double hotspot_probability{0.9};
+        /* Whether rows are shared by all clients instead of per client. */
+        bool shared_keys{false};
+        /* Number of keys appended by each statement. */
+        size_t keys_per_statement{1};
+        /* Number of write statements per transaction. */
+        size_t statements_per_trx{1};
+        /* Weights of shared, reference, update and exclusive keys. */
+        std::string key_type_mix{"0,0,0,1"};
+        /* Fraction of clients which run large transactions. */
+        double large_trx_clients{0};
+        /* Number of rows written by large transaction and row size. */
+        size_t large_trx_rows{1000};
+        size_t large_trx_row_size{100};
+        /* Streaming replication fragment unit and size for large
+         * transactions, zero fragment size disables streaming. */
+        std::string fragment_unit{"rows"};
+        size_t fragment_size{0};
+        /* Fraction of clients which run XA transactions and fraction
+         * of XA transactions committed by xid from another client. */
+        double xa_clients{0};
+        double xa_commit_by_xid{0};
+        /* DDL operations per second for the whole cluster, zero
+         * disables DDL. */
+        double ddl_rate{0};
+        /* DDL replication method: toi or nbo. */
+        std::string ddl_type{"toi"};
+        /* Keys of DDL operation: none, table or row. */
+        std::string ddl_scope{"table"};
+        /* Execution time of DDL operation in microseconds. */
+        size_t ddl_duration{1000};
+        /* Whether to store rows and take row locks in storage engine. */
+        bool row_store{false};
+        /* Whether to write committed transactions to WAL and whether
+         * to sync WAL on commit. */
+        bool wal{false};
+        bool wal_fsync{true};
+        /* Whether to sync streaming replication fragment store on
+         * fragment append and removal. */
+        bool fragment_fsync{true};
+        /* Number of threads recovering streaming appliers from
+         * fragment store at startup. */
+        size_t sr_recovery_threads{1};
+        /* Whether to enable wsrep hot key detector. */
+        bool hot_key_detector{false};
         /* Whether to sync wait before start of transaction. */
         bool sync_wait{false};
+        /* Number of sync wait reads before each transaction. */
+        size_t sync_wait_reads{0};
+        /* Client state mutex implementation: default or adaptive. */
+        std::string client_mutex{"default"};
+        /* Whether to pin server threads to NUMA nodes. */
+        bool pin_threads{false};
+        /* Number of workers executing client commands on each server,
+         * zero runs each client in its own thread. */
+        size_t thread_pool_size{0};
         std::string topology{};
         std::string wsrep_provider{};
         std::string wsrep_provider_options{};
         std::string status_file{"status.json"};
+        /* Files for measurement results, empty disables. */
+        std::string results_json{};
+        std::string results_csv{};
         int debug_log_level{0};
         int fast_exit{0};
         int thread_instrumentation{0};
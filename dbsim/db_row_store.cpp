@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_row_store.hpp"
+#include "db_client.hpp"
+
+#include "wsrep/compiler.hpp"
+
+#include <cassert>
+
+db::row_store::row_store(size_t n_shards)
+    : shards_()
+    , lock_conflicts_()
+    , bf_lock_conflicts_()
+    , bf_lock_aborts_()
+{
+    for (size_t i(0); i < (n_shards ? n_shards : 1); ++i)
+    {
+        shards_.push_back(std::unique_ptr<shard>(new shard()));
+    }
+}
+
+db::row_store::row_id db::row_store::id(const wsrep::key& key)
+{
+    // FNV-1a over key parts, part lengths included to separate
+    // part boundaries.
+    row_id ret(14695981039346656037ULL);
+    for (size_t i(0); i < key.size(); ++i)
+    {
+        const unsigned char* ptr(
+            reinterpret_cast<const unsigned char*>(key.key_parts()[i].data()));
+        const size_t len(key.key_parts()[i].size());
+        ret = (ret ^ len) * 1099511628211ULL;
+        for (size_t j(0); j < len; ++j)
+        {
+            ret = (ret ^ ptr[j]) * 1099511628211ULL;
+        }
+    }
+    return ret;
+}
+
+int db::row_store::try_lock(row_id id, db::client* owner)
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    row& r(s.rows[id]);
+    if (r.owner && r.owner != owner)
+    {
+        ++lock_conflicts_;
+        return 1;
+    }
+    r.owner = owner;
+    return 0;
+}
+
+void db::row_store::lock_bf(row_id id, db::client* owner,
+                            wsrep::seqno seqno)
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    row& r(s.rows[id]);
+    if (r.owner && r.owner != owner)
+    {
+        ++bf_lock_conflicts_;
+    }
+    while (r.owner && r.owner != owner)
+    {
+        // Victim rollback releases the lock and takes the shard mutex,
+        // BF abort must be done without holding it.
+        db::client* holder(r.owner);
+        lock.unlock();
+        if (holder->bf_abort(seqno))
+        {
+            ++bf_lock_aborts_;
+        }
+        lock.lock();
+        ++s.waiters;
+        while (r.owner == holder)
+        {
+            s.cond.wait(lock);
+        }
+        --s.waiters;
+    }
+    r.owner = owner;
+}
+
+void db::row_store::write(row_id id, db::client* owner WSREP_UNUSED,
+                          wsrep::seqno version, const std::string& value)
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    row& r(s.rows[id]);
+    assert(r.owner == owner);
+    r.version = version;
+    r.value = value;
+}
+
+void db::row_store::unlock(row_id id, db::client* owner WSREP_UNUSED)
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    row& r(s.rows[id]);
+    assert(r.owner == owner);
+    r.owner = nullptr;
+    if (s.waiters)
+    {
+        s.cond.notify_all();
+    }
+}
+
+void db::row_store::transfer(row_id id, db::client* owner WSREP_UNUSED,
+                             db::client* new_owner)
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    row& r(s.rows[id]);
+    assert(r.owner == owner);
+    r.owner = new_owner;
+    // Waiters BF abort the new owner.
+    if (s.waiters)
+    {
+        s.cond.notify_all();
+    }
+}
+
+bool db::row_store::read(row_id id, std::string& value,
+                         wsrep::seqno& version) const
+{
+    shard& s(shard_for(id));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    auto i(s.rows.find(id));
+    if (i == s.rows.end() || i->second.version.is_undefined())
+    {
+        return false;
+    }
+    value = i->second.value;
+    version = i->second.version;
+    return true;
+}
+
+size_t db::row_store::size() const
+{
+    size_t ret(0);
+    for (const auto& s : shards_)
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(s->mutex);
+        for (const auto& r : s->rows)
+        {
+            if (not r.second.version.is_undefined()) ++ret;
+        }
+    }
+    return ret;
+}
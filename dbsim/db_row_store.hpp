@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_row_store.hpp
+ *
+ * In-memory row store for dbsim storage engine.
+ *
+ * Rows are kept in a hash table which is split into shards, each
+ * protected by its own mutex. A row stores the latest committed value
+ * together with its version, which is the seqno of the transaction
+ * which wrote it, and the transaction currently holding the row lock.
+ *
+ * Local transactions lock rows without waiting: if the row is locked
+ * by another transaction, the lock attempt fails and the transaction
+ * must roll back. High priority transactions BF abort the lock holder
+ * and wait until the lock is released.
+ */
+
+#ifndef WSREP_DB_ROW_STORE_HPP
+#define WSREP_DB_ROW_STORE_HPP
+
+#include "wsrep/condition_variable.hpp"
+#include "wsrep/key.hpp"
+#include "wsrep/mutex.hpp"
+#include "wsrep/seqno.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace db
+{
+    class client;
+    class row_store
+    {
+    public:
+        typedef uint64_t row_id;
+
+        explicit row_store(size_t n_shards = 64);
+
+        /** Compute row identifier from certification key. */
+        static row_id id(const wsrep::key& key);
+
+        /**
+         * Lock row for local transaction without waiting.
+         *
+         * @return Zero on success, non-zero if the row is locked by
+         *         another transaction.
+         */
+        int try_lock(row_id row, db::client* owner);
+
+        /**
+         * Lock row for high priority transaction. If the row is
+         * locked by another transaction, the holder is BF aborted
+         * and the call waits until the lock is released.
+         */
+        void lock_bf(row_id row, db::client* owner, wsrep::seqno seqno);
+
+        /** Write row value, the row must be locked by owner. */
+        void write(row_id row, db::client* owner,
+                   wsrep::seqno version, const std::string& value);
+
+        /** Release row lock held by owner. */
+        void unlock(row_id row, db::client* owner);
+
+        /** Transfer row lock held by owner to new owner. */
+        void transfer(row_id row, db::client* owner, db::client* new_owner);
+
+        /**
+         * Read committed row value.
+         *
+         * @return True if the row exists.
+         */
+        bool read(row_id row, std::string& value,
+                  wsrep::seqno& version) const;
+
+        /** Number of committed rows. */
+        size_t size() const;
+
+        /** Number of local lock attempts which failed on conflict. */
+        long long lock_conflicts() const { return lock_conflicts_; }
+        /** Number of high priority lock requests which found the row
+         *  locked and the number of holders which were BF aborted. */
+        long long bf_lock_conflicts() const { return bf_lock_conflicts_; }
+        long long bf_lock_aborts() const { return bf_lock_aborts_; }
+    private:
+        row_store(const row_store&);
+        row_store& operator=(const row_store&);
+
+        struct row
+        {
+            row() : version(), value(), owner() { }
+            wsrep::seqno version;
+            std::string value;
+            db::client* owner;
+        };
+
+        struct shard
+        {
+            shard() : mutex(), cond(), rows(), waiters() { }
+            mutable wsrep::default_mutex mutex;
+            wsrep::default_condition_variable cond;
+            // References to elements stay valid on rehash, rows are
+            // never erased.
+            std::unordered_map<row_id, row> rows;
+            size_t waiters;
+        };
+
+        shard& shard_for(row_id row) const
+        {
+            return *shards_[row % shards_.size()];
+        }
+
+        std::vector<std::unique_ptr<shard>> shards_;
+        std::atomic<long long> lock_conflicts_;
+        std::atomic<long long> bf_lock_conflicts_;
+        std::atomic<long long> bf_lock_aborts_;
+    };
+}
+
+#endif // WSREP_DB_ROW_STORE_HPP
@@ -22,9 +22,13 @@
 #include "db_high_priority_service.hpp"
 #include "db_client.hpp"
 #include "db_simulator.hpp"
+#include "db_threads.hpp"
 
 #include "wsrep/logger.hpp"
+#include "wsrep/streaming_applier_recovery.hpp"
 
+#include <algorithm>
+#include <map>
 #include <ostream>
 #include <cstdio>
 
@@ -57,6 +61,7 @@ db::server::server(simulator& simulator,
                    const std::string& address)
     : simulator_(simulator)
     , storage_engine_(simulator_.params())
+    , key_distribution_(simulator_.params())
     , mutex_()
     , cond_()
     , server_service_(*this)
@@ -68,15 +73,32 @@ db::server::server(simulator& simulator,
     , appliers_()
     , clients_()
     , client_threads_()
+    , thread_pool_()
+    , load_generator_()
+    , ddl_generator_()
+    , nbo_threads_()
+    , xa_mutex_()
+    , detached_xa_()
+    , numa_node_(-1)
     , commit_mutex_()
     , next_commit_seqno_()
     , committed_seqno_()
 {
     wsrep::log::logger_fn(logger_fn);
+    if (simulator_.params().client_registry)
+    {
+        server_state_.enable_client_registry();
+        storage_engine_.client_registry(server_state_.client_registry());
+    }
+    if (simulator_.params().hot_key_detector)
+    {
+        server_state_.enable_hot_key_detector();
+    }
 }
 
 void db::server::applier_thread()
 {
+    if (numa_node_ >= 0) (void)db::ti::pin_self(numa_node_);
     wsrep::client_id client_id(last_client_id_.fetch_add(1) + 1);
     db::client applier(*this, client_id,
                        wsrep::client_state::m_high_priority,
@@ -103,15 +125,56 @@ void db::server::start_applier()
 
 void db::server::stop_applier()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
-    appliers_.front().join();
-    appliers_.erase(appliers_.begin());
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        appliers_.front().join();
+        appliers_.erase(appliers_.begin());
+    }
+    join_nbo_threads();
 }
 
 
 void db::server::start_clients()
 {
-    size_t n_clients(simulator_.params().n_clients);
+    const db::params& params(simulator_.params());
+    size_t n_clients(params.n_clients);
+    const std::string& topology(params.topology);
+    const size_t masters(
+        topology.empty() ? params.n_servers
+        : size_t(std::count(topology.begin(), topology.end(), 'm')));
+    if (params.rate > 0.)
+    {
+        load_generator_.reset(
+            new db::load_generator(
+                params.rate/double(masters ? masters : 1),
+                params.duration ? 0 : params.n_transactions * n_clients,
+                clients_start() +
+                std::chrono::seconds(params.warmup + params.duration)));
+        load_generator_->start();
+    }
+    if (params.ddl_rate > 0.)
+    {
+        ddl_generator_.reset(
+            new db::ddl_generator(
+                *this, params, params.ddl_rate/double(masters ? masters : 1)));
+        ddl_generator_->start();
+    }
+    if (params.thread_pool_size)
+    {
+        thread_pool_.reset(
+            new db::thread_pool(params.thread_pool_size, numa_node_));
+        for (size_t i(0); i < n_clients; ++i)
+        {
+            auto client(std::make_shared<db::client>(
+                            *this, wsrep::client_id(i + 1),
+                            wsrep::client_state::m_local,
+                            simulator_.params()));
+            clients_.push_back(client);
+            thread_pool_->submit(client.get());
+        }
+        thread_pool_->start();
+        return;
+    }
     for (size_t i(0); i < n_clients; ++i)
     {
         start_client(i + 1);
@@ -124,17 +187,67 @@ void db::server::stop_clients()
     {
         i.join();
     }
+    if (thread_pool_)
+    {
+        thread_pool_->join();
+    }
+    if (ddl_generator_)
+    {
+        ddl_generator_->stop();
+    }
+    if (load_generator_)
+    {
+        load_generator_->stop();
+        wsrep::log_info() << "Open loop max queue length: "
+                          << load_generator_->max_queue_length();
+    }
+    if (detached_xa_count())
+    {
+        // Commit XA transactions which were left detached when
+        // clients stopped.
+        auto client(std::make_shared<db::client>(
+                        *this, next_client_id(),
+                        wsrep::client_state::m_local,
+                        simulator_.params()));
+        client->commit_detached_xa();
+        clients_.push_back(client);
+    }
     for (const auto& i : clients_)
     {
         const struct db::client::stats& stats(i->stats());
         simulator_.stats_.commits += stats.commits;
         simulator_.stats_.rollbacks  += stats.rollbacks;
         simulator_.stats_.replays += stats.replays;
+        simulator_.stats_.large_commits += stats.large_commits;
+        simulator_.stats_.large_rollbacks += stats.large_rollbacks;
+        simulator_.stats_.xa_prepares += stats.xa_prepares;
+        simulator_.stats_.xa_commits_by_xid += stats.xa_commits_by_xid;
+        simulator_.stats_.xa_commit_by_xid_failures +=
+            stats.xa_commit_by_xid_failures;
+        simulator_.stats_.trx_latency.merge(stats.trx_latency);
+        simulator_.stats_.commit_latency.merge(stats.commit_latency);
+        simulator_.stats_.ddl_trx_latency.merge(stats.ddl_trx_latency);
+        simulator_.stats_.xa_prepare_latency.merge(stats.xa_prepare_latency);
+        simulator_.stats_.xa_commit_latency.merge(stats.xa_commit_latency);
+        simulator_.stats_.xa_commit_by_xid_latency.merge(
+            stats.xa_commit_by_xid_latency);
+        simulator_.stats_.throughput.merge(stats.throughput);
     }
 }
 
+const db::params& db::server::params() const
+{
+    return simulator_.params();
+}
+
+std::chrono::steady_clock::time_point db::server::clients_start() const
+{
+    return simulator_.clients_start();
+}
+
 void db::server::client_thread(const std::shared_ptr<db::client>& client)
 {
+    if (numa_node_ >= 0) (void)db::ti::pin_self(numa_node_);
     client->start();
 }
 
@@ -157,9 +270,222 @@ void db::server::donate_sst(const std::string& req,
 }
 
 
+int db::server::start_nbo(const wsrep::ws_meta& ws_meta,
+                          const db::ddl_event& event)
+{
+    auto client(std::make_shared<db::client>(
+                    *this, next_client_id(),
+                    wsrep::client_state::m_local,
+                    simulator_.params()));
+    wsrep::client_state& cs(client->client_state());
+    cs.open(cs.id());
+    cs.before_command();
+    cs.before_statement();
+    int ret(cs.enter_nbo_mode(ws_meta));
+    if (ret)
+    {
+        cs.after_statement();
+        cs.after_command_before_result();
+        cs.after_command_after_result();
+        cs.close();
+        cs.cleanup();
+        return ret;
+    }
+    storage_engine_.begin_ddl(event, client.get(), ws_meta.seqno());
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    nbo_threads_.push_back(
+        boost::thread(&db::server::nbo_thread, this, client, event));
+    return 0;
+}
+
+void db::server::join_nbo_threads()
+{
+    std::vector<boost::thread> threads;
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        threads.swap(nbo_threads_);
+    }
+    for (auto& i : threads)
+    {
+        i.join();
+    }
+}
+
+void db::server::nbo_thread(std::shared_ptr<db::client> client,
+                            db::ddl_event event)
+{
+    wsrep::client_state& cs(client->client_state());
+    // Client state was opened by the applier thread which started
+    // the NBO, take it over for this thread.
+    cs.acquire_ownership();
+    event.execute();
+    const wsrep::key_array keys(event.keys());
+    if (cs.begin_nbo_phase_two(keys))
+    {
+        wsrep::log_warning() << "Failed to begin NBO phase two: "
+                             << cs.current_error();
+        storage_engine_.end_ddl(event, client.get());
+    }
+    else
+    {
+        storage_engine_.end_ddl(event, client.get());
+        cs.end_nbo_phase_two(wsrep::mutable_buffer());
+    }
+    cs.after_statement();
+    cs.after_command_before_result();
+    cs.after_command_after_result();
+    cs.close();
+    cs.cleanup();
+}
+
+void db::server::detach_xa(const wsrep::xid& xid, wsrep::client_id client_id)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(xa_mutex_);
+    detached_xa_.emplace_back(xid, client_id);
+}
+
+bool db::server::next_detached_xa(
+    wsrep::client_id client_id,
+    std::pair<wsrep::xid, wsrep::client_id>& detached)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(xa_mutex_);
+    for (auto i(detached_xa_.begin()); i != detached_xa_.end(); ++i)
+    {
+        if (client_id.get() == wsrep::client_id::undefined() ||
+            not (i->second == client_id))
+        {
+            detached = *i;
+            detached_xa_.erase(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t db::server::detached_xa_count() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(xa_mutex_);
+    return detached_xa_.size();
+}
+
+int db::server::commit_detached_xa(const wsrep::xid& xid)
+{
+    db::high_priority_service* sa(
+        static_cast<db::high_priority_service*>(
+            server_state_.find_streaming_applier(xid)));
+    if (sa == nullptr)
+    {
+        wsrep::log_warning() << "Could not find streaming applier for "
+                             << xid;
+        return 1;
+    }
+    const wsrep::id server_id(sa->transaction().server_id());
+    const wsrep::transaction_id transaction_id(sa->transaction().id());
+    int ret(sa->commit_by_xid());
+    sa->after_apply();
+    server_state_.stop_streaming_applier(server_id, transaction_id);
+    server_service_.release_high_priority_service(sa);
+    return ret;
+}
+
 wsrep::high_priority_service* db::server::streaming_applier_service()
 {
-    throw wsrep::not_implemented_error();
+    return new db::streaming_applier_service(
+        *this, std::unique_ptr<db::client>(
+            new db::client(*this, next_client_id(),
+                           wsrep::client_state::m_high_priority,
+                           simulator_.params())));
+}
+
+namespace
+{
+    // Reconstructs streaming applier from fragments read from
+    // fragment store.
+    class streaming_applier_recoverer
+        : public wsrep::streaming_applier_recovery::recoverer
+    {
+    public:
+        typedef std::map<std::pair<wsrep::id, wsrep::transaction_id>,
+                         std::vector<db::fragment_store::fragment>>
+        fragment_map;
+        streaming_applier_recoverer(db::server& server,
+                                    const wsrep::id& cluster_id,
+                                    const fragment_map& fragments)
+            : server_(server)
+            , cluster_id_(cluster_id)
+            , fragments_(fragments)
+        { }
+        wsrep::high_priority_service* recover(
+            const wsrep::streaming_applier_recovery::job& job) override
+        {
+            const auto& fragments(
+                fragments_.at(std::make_pair(job.server_id,
+                                             job.transaction_id)));
+            wsrep::high_priority_service* sa(
+                server_.streaming_applier_service());
+            for (const auto& fragment : fragments)
+            {
+                wsrep::ws_meta ws_meta(
+                    wsrep::gtid(cluster_id_, fragment.seqno),
+                    wsrep::stid(job.server_id, job.transaction_id,
+                                wsrep::client_id()),
+                    wsrep::seqno::undefined(), fragment.flags);
+                int ret(&fragment == &fragments.front()
+                        ? sa->start_transaction(
+                            wsrep::ws_handle(job.transaction_id), ws_meta)
+                        : sa->next_fragment(ws_meta));
+                wsrep::mutable_buffer err;
+                ret = ret || sa->apply_write_set(
+                    ws_meta,
+                    wsrep::const_buffer(fragment.data.data(),
+                                        fragment.data.size()),
+                    err);
+                sa->after_apply();
+                if (ret)
+                {
+                    delete sa;
+                    throw wsrep::runtime_error(
+                        "Failed to recover streaming transaction fragment");
+                }
+            }
+            return sa;
+        }
+    private:
+        db::server& server_;
+        const wsrep::id cluster_id_;
+        const fragment_map& fragments_;
+    };
+}
+
+void db::server::recover_streaming_appliers()
+{
+    streaming_applier_recoverer::fragment_map fragments;
+    std::vector<wsrep::streaming_applier_recovery::job> jobs;
+    storage_engine_.fragment_store().recover(
+        [this, &fragments, &jobs](
+            const wsrep::id& server_id,
+            wsrep::transaction_id transaction_id,
+            const std::vector<db::fragment_store::fragment>& trx_fragments)
+        {
+            if (server_state_.find_streaming_applier(server_id,
+                                                     transaction_id))
+            {
+                return;
+            }
+            fragments[std::make_pair(server_id, transaction_id)] =
+                trx_fragments;
+            jobs.push_back(wsrep::streaming_applier_recovery::job(
+                               server_id, transaction_id));
+        });
+    if (jobs.empty()) return;
+    streaming_applier_recoverer recoverer(
+        *this, storage_engine_.get_position().id(), fragments);
+    wsrep::streaming_applier_recovery recovery(
+        server_state_, simulator_.params().sr_recovery_threads, &reporter_);
+    if (recovery.run(jobs, recoverer))
+    {
+        throw wsrep::runtime_error("Failed to recover streaming appliers");
+    }
 }
 
 void db::server::log_state_change(enum wsrep::server_state::state from,
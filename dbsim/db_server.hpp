@@ -27,11 +27,18 @@
 #include "db_storage_engine.hpp"
 #include "db_server_state.hpp"
 #include "db_server_service.hpp"
+#include "db_workload.hpp"
+#include "db_load_generator.hpp"
+#include "db_ddl.hpp"
+#include "db_thread_pool.hpp"
 
 #include <boost/thread.hpp>
 
+#include <chrono>
+#include <deque>
 #include <string>
 #include <memory>
+#include <utility>
 
 namespace db
 {
@@ -43,14 +50,56 @@ namespace db
         server(simulator& simulator,
                const std::string& name,
                const std::string& address);
+        /* Pin client and applier threads to NUMA node, -1 disables. */
+        void numa_node(int node) { numa_node_ = node; }
         void applier_thread();
         void start_applier();
         void stop_applier();
         void start_clients();
         void stop_clients();
         void client_thread(const std::shared_ptr<db::client>& client);
+        /* DDL generator, null if DDL is not enabled. */
+        const db::ddl_generator* ddl_generator() const
+        { return ddl_generator_.get(); }
+        /*
+         * Start applied NBO operation. Phase one is executed in the
+         * calling applier, the rest of the operation in a separate
+         * thread.
+         */
+        int start_nbo(const wsrep::ws_meta&, const db::ddl_event&);
+        /* Wait until applied NBO operations have completed. */
+        void join_nbo_threads();
+        /* Queue prepared XA transaction which was detached from
+         * the client to be committed by xid from another client. */
+        void detach_xa(const wsrep::xid&, wsrep::client_id);
+        /*
+         * Pop detached XA transaction which was not detached by the
+         * given client. Undefined client id pops any transaction.
+         *
+         * @return False if there is no such transaction.
+         */
+        bool next_detached_xa(wsrep::client_id,
+                              std::pair<wsrep::xid, wsrep::client_id>&);
+        size_t detached_xa_count() const;
+        /* Commit storage engine transaction of XA transaction which
+         * was committed by xid and release its streaming applier. */
+        int commit_detached_xa(const wsrep::xid&);
+        /* Client thread pool, null if clients run in own threads. */
+        const db::thread_pool* thread_pool() const
+        { return thread_pool_.get(); }
+        /* Open loop load generator, null in closed loop mode. */
+        db::load_generator* load_generator() { return load_generator_.get(); }
+        /* Start time of client load in simulator. */
+        std::chrono::steady_clock::time_point clients_start() const;
         db::storage_engine& storage_engine() { return storage_engine_; }
         db::server_state& server_state() { return server_state_; }
+        const db::params& params() const;
+        const db::key_distribution& key_distribution() const
+        { return key_distribution_; }
+        wsrep::client_id next_client_id()
+        {
+            return wsrep::client_id(last_client_id_.fetch_add(1) + 1);
+        }
         wsrep::transaction_id next_transaction_id()
         {
             return wsrep::transaction_id(last_transaction_id_.fetch_add(1) + 1);
@@ -59,6 +108,9 @@ namespace db
         wsrep::client_state* local_client_state();
         void release_client_state(wsrep::client_state*);
         wsrep::high_priority_service* streaming_applier_service();
+        /* Start streaming appliers for transactions which have
+         * fragments in fragment store. */
+        void recover_streaming_appliers();
         void log_state_change(enum wsrep::server_state::state,
                               enum wsrep::server_state::state);
 
@@ -84,9 +136,11 @@ namespace db
                                           uint64_t commit_seqno);
     private:
         void start_client(size_t id);
+        void nbo_thread(std::shared_ptr<db::client>, db::ddl_event);
 
         db::simulator& simulator_;
         db::storage_engine storage_engine_;
+        const db::key_distribution key_distribution_;
         wsrep::default_mutex mutex_;
         wsrep::default_condition_variable cond_;
         db::server_service server_service_;
@@ -97,6 +151,13 @@ namespace db
         std::vector<boost::thread> appliers_;
         std::vector<std::shared_ptr<db::client>> clients_;
         std::vector<boost::thread> client_threads_;
+        std::unique_ptr<db::thread_pool> thread_pool_;
+        std::unique_ptr<db::load_generator> load_generator_;
+        std::unique_ptr<db::ddl_generator> ddl_generator_;
+        std::vector<boost::thread> nbo_threads_;
+        mutable wsrep::default_mutex xa_mutex_;
+        std::deque<std::pair<wsrep::xid, wsrep::client_id>> detached_xa_;
+        int numa_node_;
 
         wsrep::default_mutex commit_mutex_;
         uint64_t next_commit_seqno_;
@@ -31,13 +31,13 @@ db::server_service::server_service(db::server& server)
 wsrep::storage_service* db::server_service::storage_service(
     wsrep::client_service&)
 {
-    return new db::storage_service();
+    return new db::storage_service(server_);
 }
 
 wsrep::storage_service* db::server_service::storage_service(
     wsrep::high_priority_service&)
 {
-    return new db::storage_service();
+    return new db::storage_service(server_);
 }
 
 void db::server_service::release_storage_service(
@@ -116,11 +116,13 @@ void db::server_service::log_view(wsrep::high_priority_service*,
 void db::server_service::recover_streaming_appliers(
     wsrep::client_service&)
 {
+    server_.recover_streaming_appliers();
 }
 
 void db::server_service::recover_streaming_appliers(
     wsrep::high_priority_service&)
 {
+    server_.recover_streaming_appliers();
 }
 
 wsrep::view db::server_service::get_view(wsrep::client_service&,
@@ -25,6 +25,8 @@
 #include "wsrep/logger.hpp"
 
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
 #include <sstream>
 
 static db::ti thread_instrumentation;
@@ -90,9 +92,75 @@ std::string db::simulator::stats() const
                       clients_stop_ - clients_start_).count());
     long long transactions(stats_.commits + stats_.rollbacks);
     long long bf_aborts(0);
+    long long bulk_bf_aborts(0);
+    long long bulk_bf_abort_usec(0);
+    long long bulk_bf_abort_max_usec(0);
+    size_t causal_reads_issued(0);
+    size_t causal_reads_coalesced(0);
+    size_t hot_key_conflicts(0);
+    size_t hot_key_serialized(0);
+    size_t hot_key_lock_waits(0);
+    long long wal_records(0);
+    long long wal_syncs(0);
+    long long fragments_appended(0);
+    long long ddl_issued(0);
+    long long ddl_failed(0);
+    long long ddl_bf_aborts(0);
+    db::histogram ddl_latency;
+    long long pool_steps(0);
+    long long pool_migrations(0);
+    size_t pool_max_queue_length(0);
+    db::histogram pool_queue_wait;
+    long long fragments_removed(0);
+    long long row_lock_conflicts(0);
+    long long row_bf_lock_conflicts(0);
+    long long row_bf_lock_aborts(0);
     for (const auto& s : servers_)
     {
-        bf_aborts += s.second->storage_engine().bf_aborts();
+        if (const wsrep::hot_key_detector* detector =
+            s.second->server_state().hot_key_detector())
+        {
+            hot_key_conflicts += detector->conflicts();
+            hot_key_serialized += detector->serialized();
+            hot_key_lock_waits += detector->lock_waits();
+        }
+        causal_reads_issued += s.second->server_state().causal_reads_issued();
+        causal_reads_coalesced +=
+            s.second->server_state().causal_reads_coalesced();
+        const db::storage_engine& se(s.second->storage_engine());
+        bf_aborts += se.bf_aborts();
+        bulk_bf_aborts += se.bulk_bf_aborts();
+        bulk_bf_abort_usec += se.bulk_bf_abort_usec();
+        bulk_bf_abort_max_usec = std::max(bulk_bf_abort_max_usec,
+                                          se.bulk_bf_abort_max_usec());
+        if (const db::wal* wal = se.wal())
+        {
+            wal_records += wal->records();
+            wal_syncs += wal->syncs();
+        }
+        if (const db::ddl_generator* ddl = s.second->ddl_generator())
+        {
+            ddl_issued += ddl->issued();
+            ddl_failed += ddl->failed();
+            ddl_latency.merge(ddl->latency());
+        }
+        ddl_bf_aborts += se.ddl_bf_aborts();
+        if (const db::thread_pool* pool = s.second->thread_pool())
+        {
+            pool_steps += pool->steps();
+            pool_migrations += pool->migrations();
+            pool_max_queue_length = std::max(pool_max_queue_length,
+                                             pool->max_queue_length());
+            pool_queue_wait.merge(pool->queue_wait());
+        }
+        fragments_appended += se.fragment_store().appended();
+        fragments_removed += se.fragment_store().removed();
+        if (const db::row_store* rs = se.row_store())
+        {
+            row_lock_conflicts += rs->lock_conflicts();
+            row_bf_lock_conflicts += rs->bf_lock_conflicts();
+            row_bf_lock_aborts += rs->bf_lock_aborts();
+        }
     }
     std::ostringstream os;
     os << "Number of transactions: " << transactions
@@ -103,7 +171,128 @@ std::string db::simulator::stats() const
        << "\n"
        << "BF aborts: "
        << bf_aborts
-       << "\n"
+       << "\n";
+    if (stats_.trx_latency.count())
+    {
+        os << "Measured transactions per second: "
+           << double(stats_.trx_latency.count())/measured_seconds()
+           << "\n"
+           << "Transaction latency usec p50/p90/p99/p99.9/max: ";
+        stats_.trx_latency.print(os);
+        os << "\n"
+           << "Commit latency usec p50/p90/p99/p99.9/max: ";
+        stats_.commit_latency.print(os);
+        os << "\n";
+    }
+    if (params_.thread_pool_size)
+    {
+        os << "Thread pool steps: " << pool_steps
+           << "\n"
+           << "Thread pool migrations: " << pool_migrations
+           << "\n"
+           << "Thread pool max queue length: " << pool_max_queue_length
+           << "\n"
+           << "Thread pool queue wait usec p50/p90/p99/p99.9/max: ";
+        pool_queue_wait.print(os);
+        os << "\n";
+    }
+    if (params_.hot_key_detector)
+    {
+        os << "Hot key conflicts: " << hot_key_conflicts
+           << "\n"
+           << "Hot key serialized transactions: " << hot_key_serialized
+           << "\n"
+           << "Hot key lock waits: " << hot_key_lock_waits
+           << "\n";
+    }
+    if (params_.wal)
+    {
+        os << "WAL records: " << wal_records
+           << "\n"
+           << "WAL syncs: " << wal_syncs
+           << "\n"
+           << "WAL records per sync: "
+           << (wal_syncs ? double(wal_records)/double(wal_syncs) : 0.)
+           << "\n";
+    }
+    if (params_.ddl_rate > 0.)
+    {
+        os << "DDL operations: " << ddl_issued
+           << "\n"
+           << "DDL failures: " << ddl_failed
+           << "\n"
+           << "DDL BF aborts: " << ddl_bf_aborts
+           << "\n"
+           << "DDL latency usec p50/p90/p99/p99.9/max: ";
+        ddl_latency.print(os);
+        os << "\n"
+           << "Transactions overlapping DDL: "
+           << stats_.ddl_trx_latency.count()
+           << "\n"
+           << "Transaction latency overlapping DDL usec "
+           << "p50/p90/p99/p99.9/max: ";
+        stats_.ddl_trx_latency.print(os);
+        os << "\n";
+    }
+    if (params_.large_trx_clients > 0.)
+    {
+        os << "Large transaction commits: " << stats_.large_commits
+           << "\n"
+           << "Large transaction rollbacks: " << stats_.large_rollbacks
+           << "\n";
+    }
+    if (params_.xa_clients > 0.)
+    {
+        os << "XA prepares: " << stats_.xa_prepares
+           << "\n"
+           << "XA commits by xid: " << stats_.xa_commits_by_xid
+           << "\n"
+           << "XA commit by xid failures: "
+           << stats_.xa_commit_by_xid_failures
+           << "\n"
+           << "XA prepare latency usec p50/p90/p99/p99.9/max: ";
+        stats_.xa_prepare_latency.print(os);
+        os << "\n"
+           << "XA commit latency usec p50/p90/p99/p99.9/max: ";
+        stats_.xa_commit_latency.print(os);
+        os << "\n"
+           << "XA commit by xid latency usec p50/p90/p99/p99.9/max: ";
+        stats_.xa_commit_by_xid_latency.print(os);
+        os << "\n";
+    }
+    if (fragments_appended)
+    {
+        os << "SR fragments stored: " << fragments_appended
+           << "\n"
+           << "SR fragments removed: " << fragments_removed
+           << "\n";
+    }
+    if (params_.row_store)
+    {
+        os << "Row lock conflicts: " << row_lock_conflicts
+           << "\n"
+           << "Row lock BF conflicts: " << row_bf_lock_conflicts
+           << "\n"
+           << "Row lock BF aborts: " << row_bf_lock_aborts
+           << "\n";
+    }
+    if (causal_reads_issued)
+    {
+        os << "Causal reads issued: " << causal_reads_issued
+           << "\n"
+           << "Causal reads coalesced: " << causal_reads_coalesced
+           << "\n";
+    }
+    if (bulk_bf_aborts)
+    {
+        os << "Bulk BF aborts: " << bulk_bf_aborts
+           << "\n"
+           << "Bulk BF abort latency avg/max usec: "
+           << double(bulk_bf_abort_usec)/double(bulk_bf_aborts)
+           << "/" << bulk_bf_abort_max_usec
+           << "\n";
+    }
+    os
        << "Client commits: " << stats_.commits
        << "\n"
        << "Client rollbacks: " << stats_.rollbacks
@@ -147,9 +336,14 @@ void db::simulator::start()
         }
         boost::filesystem::path dir("dbsim_" + id_os.str() + "_data");
         boost::filesystem::create_directory(dir);
+        it.first->second->storage_engine().open(dir.string());
 
         db::server& server(*it.first->second);
         server.server_state().debug_log_level(params_.debug_log_level);
+        if (params_.pin_threads)
+        {
+            server.numa_node(static_cast<int>(i % size_t(db::ti::numa_nodes())));
+        }
         std::string server_options(params_.wsrep_provider_options);
 
         wsrep::provider::services services;
@@ -210,10 +404,22 @@ void db::simulator::stop()
         server.stop_clients();
     }
     clients_stop_ = std::chrono::steady_clock::now();
+    for (auto& i : servers_)
+    {
+        i.second->join_nbo_threads();
+    }
     wsrep::log_info() << "######## Stats ############";
     wsrep::log_info()  << stats();
     std::cout << db::ti::stats() << std::endl;
     wsrep::log_info() << "######## Stats ############";
+    if (params_.results_json.size())
+    {
+        write_results_json(params_.results_json);
+    }
+    if (params_.results_csv.size())
+    {
+        write_results_csv(params_.results_csv);
+    }
     if (params_.fast_exit)
     {
         exit(0);
@@ -265,3 +471,67 @@ std::string db::simulator::build_cluster_address() const
     }
     return ret;
 }
+
+double db::simulator::measured_seconds() const
+{
+    const double ret(std::chrono::duration<double>(
+                         clients_stop_ - clients_start_).count()
+                     - double(params_.warmup));
+    return (ret > 0. ? ret : 1.);
+}
+
+void db::simulator::write_results_json(const std::string& file) const
+{
+    std::ofstream os(file);
+    os << "{\n"
+       << "  \"servers\": " << params_.n_servers << ",\n"
+       << "  \"clients\": " << params_.n_clients << ",\n"
+       << "  \"warmup\": " << params_.warmup << ",\n"
+       << "  \"seconds\": " << measured_seconds() << ",\n"
+       << "  \"commits\": " << stats_.commits << ",\n"
+       << "  \"rollbacks\": " << stats_.rollbacks << ",\n"
+       << "  \"replays\": " << stats_.replays << ",\n"
+       << "  \"measured_transactions\": " << stats_.trx_latency.count()
+       << ",\n"
+       << "  \"transactions_per_second\": "
+       << double(stats_.trx_latency.count())/measured_seconds() << ",\n"
+       << "  \"trx_latency_usec\": ";
+    stats_.trx_latency.print_json(os);
+    os << ",\n"
+       << "  \"commit_latency_usec\": ";
+    stats_.commit_latency.print_json(os);
+    os << ",\n"
+       << "  \"throughput\": [";
+    for (size_t i(0); i < stats_.throughput.seconds(); ++i)
+    {
+        os << (i ? ",\n" : "\n")
+           << "    { \"second\": " << i
+           << ", \"commits\": " << stats_.throughput.commits(i)
+           << ", \"rollbacks\": " << stats_.throughput.rollbacks(i)
+           << ", \"warmup\": " << (i < params_.warmup ? "true" : "false")
+           << " }";
+    }
+    os << "\n  ]\n"
+       << "}\n";
+    if (not os)
+    {
+        wsrep::log_error() << "Failed to write results to " << file;
+    }
+}
+
+void db::simulator::write_results_csv(const std::string& file) const
+{
+    std::ofstream os(file);
+    os << "second,commits,rollbacks,warmup\n";
+    for (size_t i(0); i < stats_.throughput.seconds(); ++i)
+    {
+        os << i << ","
+           << stats_.throughput.commits(i) << ","
+           << stats_.throughput.rollbacks(i) << ","
+           << (i < params_.warmup ? 1 : 0) << "\n";
+    }
+    if (not os)
+    {
+        wsrep::log_error() << "Failed to write results to " << file;
+    }
+}
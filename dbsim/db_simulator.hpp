@@ -26,6 +26,7 @@
 
 #include "db_params.hpp"
 #include "db_server.hpp"
+#include "db_stats.hpp"
 
 #include <memory>
 #include <chrono>
@@ -53,11 +54,17 @@ namespace db
         const db::params& params() const
         { return params_; }
         std::string stats() const;
+        /* Start time of client load. */
+        std::chrono::time_point<std::chrono::steady_clock>
+        clients_start() const { return clients_start_; }
     private:
         void start();
         void stop();
         std::string server_port(size_t i) const;
         std::string build_cluster_address() const;
+        double measured_seconds() const;
+        void write_results_json(const std::string& file) const;
+        void write_results_csv(const std::string& file) const;
 
         wsrep::default_mutex mutex_;
         const db::params& params_;
@@ -70,10 +77,34 @@ namespace db
             long long commits;
             long long rollbacks;
             long long replays;
+            long long large_commits;
+            long long large_rollbacks;
+            long long xa_prepares;
+            long long xa_commits_by_xid;
+            long long xa_commit_by_xid_failures;
+            db::histogram trx_latency;
+            db::histogram commit_latency;
+            db::histogram ddl_trx_latency;
+            db::histogram xa_prepare_latency;
+            db::histogram xa_commit_latency;
+            db::histogram xa_commit_by_xid_latency;
+            db::time_series throughput;
             stats()
                 : commits(0)
                 , rollbacks(0)
                 , replays(0)
+                , large_commits(0)
+                , large_rollbacks(0)
+                , xa_prepares(0)
+                , xa_commits_by_xid(0)
+                , xa_commit_by_xid_failures(0)
+                , trx_latency()
+                , commit_latency()
+                , ddl_trx_latency()
+                , xa_prepare_latency()
+                , xa_commit_latency()
+                , xa_commit_by_xid_latency()
+                , throughput()
             { }
         } stats_;
     };
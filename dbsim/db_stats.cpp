@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Number of sub-buckets per power of two is 1 << sub_bucket_bits.
+    const unsigned int sub_bucket_bits(5);
+    const uint64_t sub_buckets(1ULL << sub_bucket_bits);
+    const size_t n_buckets((64 - sub_bucket_bits + 1) * sub_buckets);
+}
+
+db::histogram::histogram()
+    : buckets_(n_buckets)
+    , count_()
+    , max_()
+    , sum_()
+{ }
+
+void db::histogram::record(uint64_t value)
+{
+    ++buckets_[index(value)];
+    ++count_;
+    max_ = std::max(max_, value);
+    sum_ += value;
+}
+
+void db::histogram::merge(const histogram& other)
+{
+    for (size_t i(0); i < buckets_.size(); ++i)
+    {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+double db::histogram::mean() const
+{
+    return (count_ ? double(sum_)/double(count_) : 0.);
+}
+
+uint64_t db::histogram::percentile(double p) const
+{
+    if (count_ == 0) return 0;
+    uint64_t rank(static_cast<uint64_t>(std::ceil(p/100. * double(count_))));
+    if (rank == 0) rank = 1;
+    uint64_t seen(0);
+    for (size_t i(0); i < buckets_.size(); ++i)
+    {
+        seen += buckets_[i];
+        if (seen >= rank)
+        {
+            return std::min(highest_equivalent(i), max_);
+        }
+    }
+    return max_;
+}
+
+void db::histogram::print(std::ostream& os) const
+{
+    os << percentile(50) << "/" << percentile(90) << "/"
+       << percentile(99) << "/" << percentile(99.9) << "/" << max_;
+}
+
+void db::histogram::print_json(std::ostream& os) const
+{
+    os << "{ \"count\": " << count_
+       << ", \"mean\": " << mean()
+       << ", \"p50\": " << percentile(50)
+       << ", \"p90\": " << percentile(90)
+       << ", \"p99\": " << percentile(99)
+       << ", \"p99.9\": " << percentile(99.9)
+       << ", \"max\": " << max_ << " }";
+}
+
+size_t db::histogram::index(uint64_t value)
+{
+    if (value < 2*sub_buckets) return static_cast<size_t>(value);
+    // Shift value so that it has sub_bucket_bits + 1 significant bits,
+    // buckets for each shift follow the exact buckets.
+    const unsigned int msb(63U - unsigned(__builtin_clzll(value)));
+    const unsigned int shift(msb - sub_bucket_bits);
+    return static_cast<size_t>(shift*sub_buckets + (value >> shift));
+}
+
+uint64_t db::histogram::highest_equivalent(size_t index)
+{
+    if (index < 2*sub_buckets) return index;
+    const unsigned int shift(unsigned(index/sub_buckets) - 1);
+    const uint64_t mantissa(index - shift*sub_buckets);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void db::time_series::record(size_t second, bool committed)
+{
+    if (second >= commits_.size())
+    {
+        commits_.resize(second + 1);
+        rollbacks_.resize(second + 1);
+    }
+    ++(committed ? commits_ : rollbacks_)[second];
+}
+
+void db::time_series::merge(const time_series& other)
+{
+    if (other.commits_.size() > commits_.size())
+    {
+        commits_.resize(other.commits_.size());
+        rollbacks_.resize(other.rollbacks_.size());
+    }
+    for (size_t i(0); i < other.commits_.size(); ++i)
+    {
+        commits_[i] += other.commits_[i];
+        rollbacks_[i] += other.rollbacks_[i];
+    }
+}
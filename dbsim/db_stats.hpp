@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_stats.hpp
+ *
+ * Latency histogram and throughput time series for dbsim clients.
+ */
+
+#ifndef WSREP_DB_STATS_HPP
+#define WSREP_DB_STATS_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace db
+{
+    /**
+     * Log-linear histogram. Values are stored in buckets with 32
+     * sub-buckets per power of two, which bounds the relative error
+     * of reported percentiles to about 3%. Values below 64 are
+     * recorded exactly.
+     *
+     * Histograms are not thread safe, each client records to its own
+     * histogram and histograms are merged after clients have stopped.
+     */
+    class histogram
+    {
+    public:
+        histogram();
+        void record(uint64_t value);
+        void merge(const histogram& other);
+        uint64_t count() const { return count_; }
+        uint64_t max() const { return max_; }
+        double mean() const;
+        /**
+         * Return the value at the given percentile. The result
+         * is the highest value equivalent to the bucket which contains
+         * the percentile, capped by the maximum recorded value.
+         *
+         * @param p Percentile in range [0, 100].
+         */
+        uint64_t percentile(double p) const;
+        /**
+         * Print percentiles as p50/p90/p99/p99.9/max.
+         */
+        void print(std::ostream& os) const;
+        /**
+         * Print percentiles as a JSON object.
+         */
+        void print_json(std::ostream& os) const;
+    private:
+        static size_t index(uint64_t value);
+        static uint64_t highest_equivalent(size_t index);
+        std::vector<uint64_t> buckets_;
+        uint64_t count_;
+        uint64_t max_;
+        uint64_t sum_;
+    };
+
+    /**
+     * Per second counts of committed and rolled back transactions.
+     */
+    class time_series
+    {
+    public:
+        time_series()
+            : commits_()
+            , rollbacks_()
+        { }
+        void record(size_t second, bool committed);
+        void merge(const time_series& other);
+        size_t seconds() const { return commits_.size(); }
+        long long commits(size_t second) const { return commits_[second]; }
+        long long rollbacks(size_t second) const
+        { return rollbacks_[second]; }
+    private:
+        std::vector<long long> commits_;
+        std::vector<long long> rollbacks_;
+    };
+}
+
+#endif // WSREP_DB_STATS_HPP
@@ -20,68 +20,373 @@
 #include "db_storage_engine.hpp"
 #include "db_client.hpp"
 
+#include "wsrep/server_state.hpp"
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+template <class F>
+void db::storage_engine::for_each_row_image(const char* ptr,
+                                            const char* end, F f)
+{
+    while (ptr + sizeof(db::row_store::row_id) + sizeof(uint32_t) <= end)
+    {
+        db::row_store::row_id row;
+        uint32_t len;
+        ::memcpy(&row, ptr, sizeof(row));
+        ptr += sizeof(row);
+        ::memcpy(&len, ptr, sizeof(len));
+        ptr += sizeof(len);
+        assert(ptr + len <= end);
+        f(row, std::string(ptr, len));
+        ptr += len;
+    }
+}
 
 void db::storage_engine::transaction::start(db::client* cc)
 {
     wsrep::unique_lock<wsrep::mutex> lock(se_.mutex_);
+    // Table is locked by DDL, appliers are ordered by provider.
+    while (se_.table_ddl_ &&
+           cc->client_state().mode() == wsrep::client_state::m_local)
+    {
+        se_.ddl_cond_.wait(lock);
+    }
     if (se_.transactions_.insert(cc).second == false)
     {
         ::abort();
     }
     cc_ = cc;
+    remove_fragments_ = false;
+}
+
+void db::storage_engine::transaction::adopt(db::client* cc,
+                                            transaction& other)
+{
+    assert(not active());
+    assert(other.active());
+    if (se_.row_store_)
+    {
+        for (auto row : other.locks_)
+        {
+            se_.row_store_->transfer(row, other.cc_, cc);
+        }
+    }
+    locks_ = std::move(other.locks_);
+    writes_ = std::move(other.writes_);
+    other.locks_.clear();
+    other.writes_.clear();
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(se_.mutex_);
+        se_.transactions_.erase(other.cc_);
+        if (se_.transactions_.insert(cc).second == false)
+        {
+            ::abort();
+        }
+    }
+    cc_ = cc;
+    other.cc_ = nullptr;
+}
+
+int db::storage_engine::transaction::write_row(
+    db::row_store::row_id row, const std::string& value)
+{
+    assert(cc_);
+    assert(se_.row_store_);
+    if (std::find(locks_.begin(), locks_.end(), row) == locks_.end())
+    {
+        if (se_.row_store_->try_lock(row, cc_))
+        {
+            return 1;
+        }
+        locks_.push_back(row);
+    }
+    writes_.emplace_back(row, value);
+    return 0;
 }
 
 void db::storage_engine::transaction::apply(
-    const wsrep::transaction& transaction)
+    const wsrep::transaction& transaction,
+    const wsrep::const_buffer& data)
 {
     assert(cc_);
+    if (se_.row_store_)
+    {
+        for_each_row_image(
+            data.data(), data.data() + data.size(),
+            [this, &transaction](db::row_store::row_id row,
+                                 std::string&& value)
+            {
+                if (std::find(locks_.begin(), locks_.end(), row) ==
+                    locks_.end())
+                {
+                    se_.row_store_->lock_bf(row, cc_, transaction.seqno());
+                    locks_.push_back(row);
+                }
+                writes_.emplace_back(row, std::move(value));
+            });
+    }
     se_.bf_abort_some(transaction);
 }
 
+void db::storage_engine::transaction::remove_fragments(
+    const wsrep::id& server_id, wsrep::transaction_id transaction_id)
+{
+    if (not active())
+    {
+        // No commit follows, for example when replay fails
+        // certification after the transaction was rolled back.
+        se_.fragment_store_.remove(server_id, transaction_id);
+        return;
+    }
+    remove_fragments_ = true;
+    remove_server_id_ = server_id;
+    remove_transaction_id_ = transaction_id;
+}
+
 void db::storage_engine::transaction::commit(const wsrep::gtid& gtid)
 {
+    if (remove_fragments_)
+    {
+        se_.fragment_store_.remove(remove_server_id_, remove_transaction_id_);
+        remove_fragments_ = false;
+    }
     if (cc_)
     {
+        wsrep::gtid version(gtid);
+        if (version.is_undefined())
+        {
+            wsrep::unique_lock<wsrep::mutex> lock(se_.mutex_);
+            version = se_.position_;
+        }
+        if (se_.wal_)
+        {
+            std::string rows;
+            for (const auto& w : writes_)
+            {
+                append_row_image(rows, w.first, w.second);
+            }
+            lsn_ = se_.wal_->append(version, rows);
+        }
+        if (se_.row_store_)
+        {
+            for (const auto& w : writes_)
+            {
+                se_.row_store_->write(w.first, cc_, version.seqno(),
+                                      w.second);
+            }
+            release_rows();
+        }
         wsrep::unique_lock<wsrep::mutex> lock(se_.mutex_);
         se_.transactions_.erase(cc_);
-        se_.store_position(gtid);
+        if (not gtid.is_undefined()) se_.store_position(gtid);
     }
     cc_ = nullptr;
 }
 
 
+void db::storage_engine::transaction::wait_durable()
+{
+    if (lsn_)
+    {
+        se_.wal_->sync(lsn_);
+        lsn_ = 0;
+    }
+}
+
 void db::storage_engine::transaction::rollback()
 {
+    remove_fragments_ = false;
     if (cc_)
     {
+        release_rows();
         wsrep::unique_lock<wsrep::mutex> lock(se_.mutex_);
         se_.transactions_.erase(cc_);
     }
     cc_ = nullptr;
 }
 
+void db::storage_engine::transaction::release_rows()
+{
+    for (auto row : locks_)
+    {
+        se_.row_store_->unlock(row, cc_);
+    }
+    locks_.clear();
+    writes_.clear();
+}
+
+void db::storage_engine::append_row_image(std::string& buf,
+                                          db::row_store::row_id row,
+                                          const std::string& value)
+{
+    const uint32_t len(static_cast<uint32_t>(value.size()));
+    buf.append(reinterpret_cast<const char*>(&row), sizeof(row));
+    buf.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    buf.append(value);
+}
+
+void db::storage_engine::open(const std::string& dir)
+{
+    fragment_store_.open(dir + "/sr_fragments.log");
+    if (not wal_) return;
+    wsrep::gtid position(
+        wal_->open(dir + "/wal.log",
+                   [this](const wsrep::gtid& gtid, const std::string& rows)
+                   {
+                       if (not row_store_) return;
+                       for_each_row_image(
+                           rows.data(), rows.data() + rows.size(),
+                           [this, &gtid](db::row_store::row_id row,
+                                         std::string&& value)
+                           {
+                               row_store_->write(row, nullptr,
+                                                 gtid.seqno(), value);
+                           });
+                   }));
+    if (not position.is_undefined())
+    {
+        position_ = position;
+    }
+}
+
+void db::storage_engine::begin_ddl(const db::ddl_event& event,
+                                   db::client* cc,
+                                   wsrep::seqno seqno)
+{
+    ++ddl_events_;
+    ++ddl_active_;
+    if (event.scope == db::ddl_event::sc_table)
+    {
+        std::vector<wsrep::client_state*> victims;
+        {
+            wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+            ++table_ddl_;
+            for (auto victim : transactions_)
+            {
+                wsrep::client_state& vcs(victim->client_state());
+                if (vcs.mode() == wsrep::client_state::m_local)
+                {
+                    victims.push_back(&vcs);
+                }
+            }
+        }
+        if (not victims.empty())
+        {
+            ddl_bf_aborts_ += static_cast<long long>(
+                victims.front()->server_state().bf_abort(
+                    victims, seqno, true));
+        }
+    }
+    else if (event.scope == db::ddl_event::sc_row && row_store_)
+    {
+        row_store_->lock_bf(db::row_store::id(event.keys().front()),
+                            cc, seqno);
+    }
+}
+
+void db::storage_engine::end_ddl(const db::ddl_event& event,
+                                 db::client* cc)
+{
+    if (event.scope == db::ddl_event::sc_table)
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        if (--table_ddl_ == 0) ddl_cond_.notify_all();
+    }
+    else if (event.scope == db::ddl_event::sc_row && row_store_)
+    {
+        row_store_->unlock(db::row_store::id(event.keys().front()), cc);
+    }
+    --ddl_active_;
+}
+
 void db::storage_engine::bf_abort_some(const wsrep::transaction& txc)
 {
     std::uniform_int_distribution<size_t> uniform_dist(0, alg_freq_);
+    const size_t max_victims(bf_abort_batch_ ? bf_abort_batch_ : 1);
     wsrep::unique_lock<wsrep::mutex> lock(mutex_);
-    if (alg_freq_ && uniform_dist(random_engine_) == 0)
+    if (alg_freq_ == 0 || uniform_dist(random_engine_) != 0)
     {
-        if (transactions_.empty() == false)
-        {
-            for (auto victim : transactions_)
+        return;
+    }
+    if (client_registry_)
+    {
+        // Victims are looked up from the registry without holding
+        // the storage engine mutex. The registry entries are kept
+        // locked while aborting, so that the victim transactions
+        // cannot be cleaned up and the clients released meanwhile.
+        lock.unlock();
+        std::vector<wsrep::transaction_id> victim_ids;
+        client_registry_->for_each(
+            [&victim_ids, max_victims](wsrep::client_state& cc)
             {
-                wsrep::client_state& cc(victim->client_state());
-                if (cc.mode() == wsrep::client_state::m_local)
+                if (victim_ids.size() < max_victims &&
+                    cc.mode() == wsrep::client_state::m_local)
                 {
-                    if (victim->bf_abort(txc.seqno()))
-                    {
-                        ++bf_aborts_;
-                    }
-                    break;
+                    victim_ids.push_back(cc.transaction().id());
                 }
+            });
+        if (victim_ids.empty()) return;
+        client_registry_->with_transactions(
+            victim_ids,
+            [this, &txc](const std::vector<wsrep::client_state*>& victims)
+            {
+                bf_abort_victims(victims, txc);
+            });
+    }
+    else
+    {
+        std::vector<wsrep::client_state*> victims;
+        for (auto victim : transactions_)
+        {
+            wsrep::client_state& cc(victim->client_state());
+            if (cc.mode() == wsrep::client_state::m_local)
+            {
+                victims.push_back(&cc);
+                if (victims.size() == max_victims) break;
             }
         }
+        bf_abort_victims(victims, txc);
+    }
+}
+
+void db::storage_engine::bf_abort_victims(
+    const std::vector<wsrep::client_state*>& victims,
+    const wsrep::transaction& txc)
+{
+    if (victims.empty()) return;
+
+    if (bf_abort_batch_ <= 1)
+    {
+        if (victims.front()->bf_abort(txc.seqno()))
+        {
+            ++bf_aborts_;
+        }
+    }
+    else
+    {
+        bf_abort_batch(victims, txc);
+    }
+}
+
+void db::storage_engine::bf_abort_batch(
+    const std::vector<wsrep::client_state*>& victims,
+    const wsrep::transaction& txc)
+{
+    auto start(std::chrono::steady_clock::now());
+    size_t aborted(victims.front()->server_state().bf_abort(
+                       victims, txc.seqno(), false));
+    long long usec(std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start).count());
+    bf_aborts_ += static_cast<long long>(aborted);
+    ++bulk_bf_aborts_;
+    bulk_bf_abort_usec_ += usec;
+    if (usec > bulk_bf_abort_max_usec_)
+    {
+        bulk_bf_abort_max_usec_ = usec;
     }
 }
 
@@ -20,15 +20,25 @@
 #ifndef WSREP_DB_STORAGE_ENGINE_HPP
 #define WSREP_DB_STORAGE_ENGINE_HPP
 
+#include "db_ddl.hpp"
+#include "db_fragment_store.hpp"
 #include "db_params.hpp"
+#include "db_row_store.hpp"
+#include "db_wal.hpp"
 
 #include "wsrep/mutex.hpp"
+#include "wsrep/condition_variable.hpp"
 #include "wsrep/view.hpp"
 #include "wsrep/transaction.hpp"
+#include "wsrep/client_registry.hpp"
 
 #include <atomic>
+#include <memory>
 #include <unordered_set>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace db
 {
@@ -38,9 +48,22 @@ namespace db
     public:
         storage_engine(const params& params)
             : mutex_()
+            , ddl_cond_()
             , transactions_()
             , alg_freq_(params.alg_freq)
+            , bf_abort_batch_(params.bf_abort_batch)
+            , client_registry_()
             , bf_aborts_()
+            , bulk_bf_aborts_()
+            , bulk_bf_abort_usec_()
+            , bulk_bf_abort_max_usec_()
+            , row_store_(params.row_store ? new db::row_store() : nullptr)
+            , wal_(params.wal ? new db::wal(params.wal_fsync) : nullptr)
+            , fragment_store_(params.fragment_fsync)
+            , table_ddl_()
+            , ddl_active_()
+            , ddl_events_()
+            , ddl_bf_aborts_()
             , position_()
             , view_()
             , random_device_()
@@ -53,6 +76,12 @@ namespace db
             transaction(storage_engine& se)
                 : se_(se)
                 , cc_()
+                , locks_()
+                , writes_()
+                , lsn_()
+                , remove_fragments_()
+                , remove_server_id_()
+                , remove_transaction_id_()
             { }
             ~transaction()
             {
@@ -60,28 +89,134 @@ namespace db
             }
             bool active() const { return cc_ != nullptr; }
             void start(client* cc);
-            void apply(const wsrep::transaction&);
+            /*
+             * Take over active transaction of another client, row
+             * locks are transferred to cc. Used when prepared XA
+             * transaction is detached from the client.
+             */
+            void adopt(client* cc, transaction& other);
+            /*
+             * Lock and write row for local transaction.
+             * Returns non-zero on lock conflict, in which case
+             * the transaction must be rolled back.
+             */
+            int write_row(db::row_store::row_id, const std::string& value);
+            void apply(const wsrep::transaction&,
+                       const wsrep::const_buffer& data);
+            /*
+             * Remove fragments of streaming transaction from fragment
+             * store when this transaction commits, or immediately if
+             * the transaction is not active.
+             */
+            void remove_fragments(const wsrep::id& server_id,
+                                  wsrep::transaction_id transaction_id);
+            /*
+             * Commit transaction. Undefined gtid commits without
+             * updating the position, rows are versioned with the
+             * current position.
+             */
             void commit(const wsrep::gtid&);
+            /*
+             * Wait until the last commit is durable in WAL. Called
+             * after leaving commit order critical section so that
+             * concurrent commits can be synced as a group.
+             */
+            void wait_durable();
             void rollback();
             db::client* client() { return cc_; }
             transaction(const transaction&) = delete;
             transaction& operator=(const transaction&) = delete;
         private:
+            void release_rows();
             db::storage_engine& se_;
             db::client* cc_;
+            std::vector<db::row_store::row_id> locks_;
+            std::vector<std::pair<db::row_store::row_id, std::string>> writes_;
+            db::wal::lsn lsn_;
+            bool remove_fragments_;
+            wsrep::id remove_server_id_;
+            wsrep::transaction_id remove_transaction_id_;
         };
+        /* Select BF abort victims from client registry instead of
+         * the storage engine transaction set. */
+        void client_registry(const wsrep::client_registry* registry)
+        {
+            client_registry_ = registry;
+        }
+        /*
+         * Open WAL and fragment store in data directory. Position and
+         * rows are recovered from WAL if it is enabled.
+         */
+        void open(const std::string& dir);
+        /* WAL, null if not enabled. */
+        const db::wal* wal() const { return wal_.get(); }
+        /* Streaming replication fragment store. */
+        db::fragment_store& fragment_store() { return fragment_store_; }
+        const db::fragment_store& fragment_store() const
+        { return fragment_store_; }
+        /* Row store, null if not enabled. */
+        const db::row_store* row_store() const { return row_store_.get(); }
+        /*
+         * Serialize row image into write set data. Row images are
+         * parsed from the write set in transaction::apply().
+         */
+        static void append_row_image(std::string& buf,
+                                     db::row_store::row_id,
+                                     const std::string& value);
+        /*
+         * Begin executing DDL event. Table scope DDL BF aborts local
+         * transactions in total order and blocks starting new local
+         * transactions until end_ddl(). Row scope DDL locks the row
+         * if row store is enabled.
+         */
+        void begin_ddl(const db::ddl_event&, db::client*, wsrep::seqno);
+        void end_ddl(const db::ddl_event&, db::client*);
+        /* Number of DDL events begun and number of events in progress.
+         * Clients use these to detect transactions overlapping DDL. */
+        long long ddl_events() const { return ddl_events_; }
+        int ddl_active() const { return ddl_active_; }
+        /* Number of local transactions BF aborted by DDL. */
+        long long ddl_bf_aborts() const { return ddl_bf_aborts_; }
         void bf_abort_some(const wsrep::transaction& tc);
         long long bf_aborts() const { return bf_aborts_; }
+        /* Number of bulk BF aborts and time spent from the start of
+         * the abort until all victims were marked and handed to
+         * rollback. */
+        long long bulk_bf_aborts() const { return bulk_bf_aborts_; }
+        long long bulk_bf_abort_usec() const { return bulk_bf_abort_usec_; }
+        long long bulk_bf_abort_max_usec() const
+        { return bulk_bf_abort_max_usec_; }
         void store_position(const wsrep::gtid& gtid);
         wsrep::gtid get_position() const;
         void store_view(const wsrep::view& view);
         wsrep::view get_view() const;
     private:
+        template <class F>
+        static void for_each_row_image(const char* ptr, const char* end, F f);
+        void bf_abort_victims(const std::vector<wsrep::client_state*>&,
+                              const wsrep::transaction& tc);
+        void bf_abort_batch(const std::vector<wsrep::client_state*>&,
+                            const wsrep::transaction& tc);
         void validate_position(const wsrep::gtid& gtid) const;
         wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable ddl_cond_;
         std::unordered_set<db::client*> transactions_;
         size_t alg_freq_;
+        size_t bf_abort_batch_;
+        const wsrep::client_registry* client_registry_;
         std::atomic<long long> bf_aborts_;
+        std::atomic<long long> bulk_bf_aborts_;
+        std::atomic<long long> bulk_bf_abort_usec_;
+        std::atomic<long long> bulk_bf_abort_max_usec_;
+        std::unique_ptr<db::row_store> row_store_;
+        std::unique_ptr<db::wal> wal_;
+        db::fragment_store fragment_store_;
+        /* Number of table scope DDL events in progress, protected
+         * by mutex_. */
+        size_t table_ddl_;
+        std::atomic<int> ddl_active_;
+        std::atomic<long long> ddl_events_;
+        std::atomic<long long> ddl_bf_aborts_;
         wsrep::gtid position_;
         wsrep::view view_;
         std::random_device random_device_;
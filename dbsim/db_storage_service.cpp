@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_storage_service.hpp"
+#include "db_server.hpp"
+#include "db_client.hpp"
+
+db::storage_service::storage_service(db::server& server)
+    : server_(server)
+    , client_(new db::client(server, server.next_client_id(),
+                             wsrep::client_state::m_high_priority,
+                             server.params()))
+    , append_()
+    , server_id_()
+    , transaction_id_()
+    , seqno_()
+    , flags_()
+    , data_()
+    , remove_()
+{
+    wsrep::client_state& cs(client_->client_state());
+    cs.open(cs.id());
+    cs.before_command();
+}
+
+db::storage_service::~storage_service()
+{
+    wsrep::client_state& cs(client_->client_state());
+    cs.after_command_before_result();
+    cs.after_command_after_result();
+    cs.close();
+    cs.cleanup();
+}
+
+int db::storage_service::start_transaction(const wsrep::ws_handle& ws_handle)
+{
+    return client_->client_state().start_transaction(
+        ws_handle.transaction_id());
+}
+
+void db::storage_service::adopt_transaction(
+    const wsrep::transaction& transaction)
+{
+    client_->client_state().adopt_transaction(transaction);
+    server_id_ = transaction.server_id();
+    transaction_id_ = transaction.id();
+}
+
+int db::storage_service::append_fragment(const wsrep::id& server_id,
+                                         wsrep::transaction_id transaction_id,
+                                         int flags,
+                                         const wsrep::const_buffer& data,
+                                         const wsrep::xid&)
+{
+    append_ = true;
+    server_id_ = server_id;
+    transaction_id_ = transaction_id;
+    flags_ = flags;
+    data_.assign(data.data(), data.size());
+    return 0;
+}
+
+int db::storage_service::update_fragment_meta(const wsrep::ws_meta& ws_meta)
+{
+    seqno_ = ws_meta.seqno();
+    return 0;
+}
+
+int db::storage_service::remove_fragments()
+{
+    remove_ = true;
+    return 0;
+}
+
+int db::storage_service::commit(const wsrep::ws_handle& ws_handle,
+                                const wsrep::ws_meta& ws_meta)
+{
+    wsrep::client_state& cs(client_->client_state());
+    int ret(0);
+    const bool is_ordered(not ws_meta.seqno().is_undefined());
+    if (is_ordered)
+    {
+        ret = cs.prepare_for_ordering(ws_handle, ws_meta, true) ||
+            cs.before_commit();
+        if (ret == 0) write_fragments();
+        ret = ret || cs.ordered_commit() || cs.after_commit();
+        if (ret)
+        {
+            cs.prepare_for_ordering(wsrep::ws_handle(), wsrep::ws_meta(),
+                                    false);
+        }
+    }
+    else
+    {
+        // Removal of fragments after the transaction has been
+        // committed or rolled back is not ordered.
+        write_fragments();
+        cs.before_rollback();
+        cs.after_rollback();
+    }
+    cs.after_applying();
+    reset();
+    return ret;
+}
+
+int db::storage_service::rollback(const wsrep::ws_handle& ws_handle,
+                                  const wsrep::ws_meta& ws_meta)
+{
+    wsrep::client_state& cs(client_->client_state());
+    int ret(cs.prepare_for_ordering(ws_handle, ws_meta, false) ||
+            cs.before_rollback() ||
+            cs.after_rollback());
+    cs.after_applying();
+    reset();
+    return ret;
+}
+
+void db::storage_service::write_fragments()
+{
+    db::fragment_store& store(server_.storage_engine().fragment_store());
+    if (append_)
+    {
+        store.append(server_id_, transaction_id_, seqno_, flags_,
+                     wsrep::const_buffer(data_.data(), data_.size()));
+    }
+    if (remove_)
+    {
+        store.remove(server_id_, transaction_id_);
+    }
+}
+
+void db::storage_service::reset()
+{
+    append_ = false;
+    remove_ = false;
+    data_.clear();
+}
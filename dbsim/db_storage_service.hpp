@@ -21,33 +21,58 @@
 #define WSREP_DB_STORAGE_SERVICE_HPP
 
 #include "wsrep/storage_service.hpp"
-#include "wsrep/exception.hpp"
+#include "wsrep/id.hpp"
+#include "wsrep/seqno.hpp"
+#include "wsrep/transaction_id.hpp"
+
+#include <memory>
+#include <string>
 
 namespace db
 {
+    class server;
+    class client;
+    /*
+     * Storage service for streaming replication fragments of local
+     * transactions. Fragment appends and removals are buffered and
+     * written to storage engine fragment store on commit, inside
+     * the commit order critical section if the commit is ordered.
+     */
     class storage_service : public wsrep::storage_service
     {
-        int start_transaction(const wsrep::ws_handle&) override
-        { throw wsrep::not_implemented_error(); }
-        void adopt_transaction(const wsrep::transaction&) override
-        { throw wsrep::not_implemented_error(); }
+    public:
+        storage_service(db::server& server);
+        ~storage_service() override;
+        int start_transaction(const wsrep::ws_handle&) override;
+        void adopt_transaction(const wsrep::transaction&) override;
         int append_fragment(const wsrep::id&,
                             wsrep::transaction_id,
                             int,
                             const wsrep::const_buffer&,
-                            const wsrep::xid&) override
-        { throw wsrep::not_implemented_error(); }
-        int update_fragment_meta(const wsrep::ws_meta&) override
-        { throw wsrep::not_implemented_error(); }
-        int remove_fragments() override
-        { throw wsrep::not_implemented_error(); }
-        int commit(const wsrep::ws_handle&, const wsrep::ws_meta&) override
-        { throw wsrep::not_implemented_error(); }
+                            const wsrep::xid&) override;
+        int update_fragment_meta(const wsrep::ws_meta&) override;
+        int remove_fragments() override;
+        int commit(const wsrep::ws_handle&, const wsrep::ws_meta&) override;
         int rollback(const wsrep::ws_handle&, const wsrep::ws_meta&)
-            override
-        { throw wsrep::not_implemented_error(); }
+            override;
         void store_globals() override { }
         void reset_globals() override { }
+    private:
+        storage_service(const storage_service&);
+        storage_service& operator=(const storage_service&);
+        void write_fragments();
+        void reset();
+        db::server& server_;
+        std::unique_ptr<db::client> client_;
+        /* Fragment appended in this storage transaction. */
+        bool append_;
+        wsrep::id server_id_;
+        wsrep::transaction_id transaction_id_;
+        wsrep::seqno seqno_;
+        int flags_;
+        std::string data_;
+        /* Fragments of adopted transaction are removed on commit. */
+        bool remove_;
     };
 }
 
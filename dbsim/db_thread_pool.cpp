@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_thread_pool.hpp"
+#include "db_client.hpp"
+#include "db_threads.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+db::thread_pool::thread_pool(size_t n_workers, int numa_node)
+    : n_workers_(n_workers)
+    , numa_node_(numa_node)
+    , mutex_()
+    , cond_()
+    , queue_()
+    , sessions_()
+    , steps_()
+    , migrations_()
+    , max_queue_length_()
+    , queue_wait_()
+    , workers_()
+{ }
+
+db::thread_pool::~thread_pool()
+{
+    join();
+}
+
+void db::thread_pool::submit(db::client* client)
+{
+    assert(workers_.empty());
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    entry e = { client, clock::now(), -1 };
+    queue_.push_back(e);
+    ++sessions_;
+    max_queue_length_ = std::max(max_queue_length_, queue_.size());
+}
+
+void db::thread_pool::start()
+{
+    for (size_t i(0); i < n_workers_; ++i)
+    {
+        workers_.push_back(boost::thread(&db::thread_pool::run, this,
+                                         long(i)));
+    }
+}
+
+void db::thread_pool::join()
+{
+    for (auto& i : workers_)
+    {
+        if (i.joinable()) i.join();
+    }
+}
+
+long long db::thread_pool::steps() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return steps_;
+}
+
+long long db::thread_pool::migrations() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return migrations_;
+}
+
+size_t db::thread_pool::max_queue_length() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return max_queue_length_;
+}
+
+db::histogram db::thread_pool::queue_wait() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return queue_wait_;
+}
+
+void db::thread_pool::run(long worker)
+{
+    if (numa_node_ >= 0) (void)db::ti::pin_self(numa_node_);
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    for (;;)
+    {
+        while (queue_.empty() && sessions_ > 0)
+        {
+            cond_.wait(lock);
+        }
+        if (queue_.empty()) break;
+        entry e(queue_.front());
+        queue_.pop_front();
+        ++steps_;
+        if (e.worker >= 0 && e.worker != worker) ++migrations_;
+        queue_wait_.record(
+            uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                         clock::now() - e.enqueued).count()));
+        lock.unlock();
+        const bool more(e.client->step());
+        lock.lock();
+        if (more)
+        {
+            e.enqueued = clock::now();
+            e.worker = worker;
+            queue_.push_back(e);
+            max_queue_length_ = std::max(max_queue_length_, queue_.size());
+            cond_.notify_one();
+        }
+        else if (--sessions_ == 0)
+        {
+            // Wake up idle workers to exit.
+            cond_.notify_all();
+        }
+    }
+}
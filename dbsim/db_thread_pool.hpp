@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_thread_pool.hpp
+ *
+ * Thread pool for executing dbsim client sessions.
+ *
+ * Client sessions are kept in a run queue and a fixed number of
+ * workers execute one client command of a session at a time, see
+ * db::client::step(). After the command the session is queued again,
+ * so that the next command may run on a different worker. This
+ * exercises handing over client state ownership between threads.
+ */
+
+#ifndef WSREP_DB_THREAD_POOL_HPP
+#define WSREP_DB_THREAD_POOL_HPP
+
+#include "db_stats.hpp"
+
+#include "wsrep/mutex.hpp"
+#include "wsrep/condition_variable.hpp"
+
+#include <boost/thread.hpp>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace db
+{
+    class client;
+
+    class thread_pool
+    {
+    public:
+        /*
+         * Constructor.
+         *
+         * @param n_workers Number of worker threads.
+         * @param numa_node NUMA node to pin workers to, -1 disables.
+         */
+        thread_pool(size_t n_workers, int numa_node);
+        ~thread_pool();
+        /* Queue client session. Sessions must be submitted before
+         * the pool is started. */
+        void submit(db::client* client);
+        void start();
+        /* Wait until all submitted sessions have been closed. */
+        void join();
+        /* Number of executed steps and steps which executed on a
+         * different worker than the previous step of the session. */
+        long long steps() const;
+        long long migrations() const;
+        size_t max_queue_length() const;
+        /* Time sessions spent in the run queue in microseconds. */
+        db::histogram queue_wait() const;
+    private:
+        thread_pool(const thread_pool&);
+        thread_pool& operator=(const thread_pool&);
+        typedef std::chrono::steady_clock clock;
+        struct entry
+        {
+            db::client* client;
+            clock::time_point enqueued;
+            /* Worker which executed the previous step, -1 if none. */
+            long worker;
+        };
+        void run(long worker);
+
+        const size_t n_workers_;
+        const int numa_node_;
+        mutable wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable cond_;
+        std::deque<entry> queue_;
+        /* Sessions which have not been closed. */
+        size_t sessions_;
+        long long steps_;
+        long long migrations_;
+        size_t max_queue_length_;
+        db::histogram queue_wait_;
+        std::vector<boost::thread> workers_;
+    };
+}
+
+#endif // WSREP_DB_THREAD_POOL_HPP
@@ -22,13 +22,16 @@
 #include "wsrep/logger.hpp"
 
 #include <cassert>
+#include <cerrno>
 #include <cstdint>
 #include <pthread.h>
+#include <sched.h>
 
 #include <algorithm>
 #include <atomic>
 #include <array>
 #include <chrono>
+#include <fstream>
 #include <map>
 #include <mutex>
 #include <ostream>
@@ -224,6 +227,20 @@ namespace
             return pthread_getschedparam(th_, policy, param);
         }
 
+#if defined(__linux__)
+        int setaffinity(size_t cpuset_size, const cpu_set_t* cpuset)
+        {
+            return pthread_setaffinity_np(th_, cpuset_size, cpuset);
+        }
+
+        int getaffinity(size_t cpuset_size, cpu_set_t* cpuset)
+        {
+            return pthread_getaffinity_np(th_, cpuset_size, cpuset);
+        }
+#endif /* __linux__ */
+
+        void attach_self() { th_ = pthread_self(); }
+
         int equal(ti_thread* other)
         {
             return pthread_equal(th_, other->th_);
@@ -243,6 +260,7 @@ namespace
             = reinterpret_cast<const wsrep::thread_service::thread_key*>(
                 append_key("main", "thread"));
         static ti_thread main_thread(main_thread_key);
+        main_thread.attach_self();
         this_ti_thread = &main_thread;
         return true;
     }
@@ -566,6 +584,142 @@ int db::ti::getschedparam(wsrep::thread_service::thread* thread,
     return reinterpret_cast<ti_thread*>(thread)->getschedparam(policy, param);
 }
 
+#if defined(__linux__)
+namespace
+{
+    // CPUs the process was allowed to run on at startup.
+    cpu_set_t process_cpuset()
+    {
+        static cpu_set_t cpuset;
+        static bool init(false);
+        if (not init)
+        {
+            CPU_ZERO(&cpuset);
+            if (sched_getaffinity(0, sizeof(cpuset), &cpuset))
+            {
+                for (int i(0); i < CPU_SETSIZE; ++i) CPU_SET(i, &cpuset);
+            }
+            init = true;
+        }
+        return cpuset;
+    }
+    static const cpu_set_t process_cpuset_init(process_cpuset());
+
+    // Read CPUs of NUMA node from sysfs cpulist, e.g. "0-3,8-11".
+    int node_cpuset(int node, cpu_set_t& cpuset)
+    {
+        if (node < 0)
+        {
+            cpuset = process_cpuset();
+            return 0;
+        }
+        std::ifstream cpulist("/sys/devices/system/node/node"
+                              + std::to_string(node) + "/cpulist");
+        if (not cpulist)
+        {
+            if (node == 0)
+            {
+                // No NUMA information, treat the system as one node.
+                cpuset = process_cpuset();
+                return 0;
+            }
+            return EINVAL;
+        }
+        CPU_ZERO(&cpuset);
+        std::string range;
+        while (std::getline(cpulist, range, ','))
+        {
+            int first(0), last(0);
+            char dash(0);
+            std::istringstream is(range);
+            is >> first;
+            if (not is) continue;
+            if (is >> dash >> last)
+            {
+                if (dash != '-') return EINVAL;
+            }
+            else
+            {
+                last = first;
+            }
+            for (int cpu(first); cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+            {
+                CPU_SET(cpu, &cpuset);
+            }
+        }
+        return CPU_COUNT(&cpuset) ? 0 : EINVAL;
+    }
+}
+#endif /* __linux__ */
+
+int db::ti::setaffinity(wsrep::thread_service::thread* thread,
+                        size_t cpuset_size, const void* cpuset) WSREP_NOEXCEPT
+{
+#if defined(__linux__)
+    return reinterpret_cast<ti_thread*>(thread)->setaffinity(
+        cpuset_size, static_cast<const cpu_set_t*>(cpuset));
+#else
+    (void)thread; (void)cpuset_size; (void)cpuset;
+    return ENOTSUP;
+#endif /* __linux__ */
+}
+
+int db::ti::getaffinity(wsrep::thread_service::thread* thread,
+                        size_t cpuset_size, void* cpuset) WSREP_NOEXCEPT
+{
+#if defined(__linux__)
+    return reinterpret_cast<ti_thread*>(thread)->getaffinity(
+        cpuset_size, static_cast<cpu_set_t*>(cpuset));
+#else
+    (void)thread; (void)cpuset_size; (void)cpuset;
+    return ENOTSUP;
+#endif /* __linux__ */
+}
+
+int db::ti::set_numa_node(wsrep::thread_service::thread* thread,
+                          int node) WSREP_NOEXCEPT
+{
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    int ret(node_cpuset(node, cpuset));
+    if (ret) return ret;
+    // Memory follows the thread with the default first touch policy.
+    return reinterpret_cast<ti_thread*>(thread)->setaffinity(
+        sizeof(cpuset), &cpuset);
+#else
+    (void)thread; (void)node;
+    return ENOTSUP;
+#endif /* __linux__ */
+}
+
+int db::ti::numa_nodes()
+{
+#if defined(__linux__)
+    int nodes(0);
+    while (std::ifstream("/sys/devices/system/node/node"
+                         + std::to_string(nodes) + "/cpulist"))
+    {
+        ++nodes;
+    }
+    return std::max(nodes, 1);
+#else
+    return 1;
+#endif /* __linux__ */
+}
+
+int db::ti::pin_self(int node)
+{
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    int ret(node_cpuset(node, cpuset));
+    if (ret) return ret;
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#else
+    (void)node;
+    return ENOTSUP;
+#endif /* __linux__ */
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //                                Mutex                                     //
 //////////////////////////////////////////////////////////////////////////////
@@ -47,6 +47,12 @@ namespace db
                           const struct sched_param*) WSREP_NOEXCEPT override;
         int getschedparam(wsrep::thread_service::thread*, int*,
                           struct sched_param*) WSREP_NOEXCEPT override;
+        int setaffinity(wsrep::thread_service::thread*, size_t,
+                        const void*) WSREP_NOEXCEPT override;
+        int getaffinity(wsrep::thread_service::thread*, size_t,
+                        void*) WSREP_NOEXCEPT override;
+        int set_numa_node(wsrep::thread_service::thread*,
+                          int) WSREP_NOEXCEPT override;
 
         /* Mutex */
         const wsrep::thread_service::mutex_key*
@@ -76,6 +82,11 @@ namespace db
         static void level(int level);
         static void cond_checks(bool cond_checks);
         static std::string stats();
+
+        /* Return number of NUMA nodes in the system, at least one. */
+        static int numa_nodes();
+        /* Pin the calling thread to CPUs of NUMA node. */
+        static int pin_self(int node);
     };
 
 
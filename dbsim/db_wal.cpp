@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_wal.hpp"
+
+#include "wsrep/exception.hpp"
+#include "wsrep/logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t header_size(2*sizeof(uint32_t));
+    const size_t gtid_size(sizeof(wsrep::id::native_type) + sizeof(int64_t));
+
+    uint32_t checksum(const char* ptr, size_t len)
+    {
+        // FNV-1a
+        uint32_t ret(2166136261U);
+        for (size_t i(0); i < len; ++i)
+        {
+            ret = (ret ^ static_cast<unsigned char>(ptr[i])) * 16777619U;
+        }
+        return ret;
+    }
+
+    void write_all(int fd, const char* ptr, size_t len)
+    {
+        while (len)
+        {
+            ssize_t ret(::write(fd, ptr, len));
+            if (ret < 0)
+            {
+                if (errno == EINTR) continue;
+                throw wsrep::runtime_error(
+                    std::string("WAL write failed: ") + ::strerror(errno));
+            }
+            ptr += ret;
+            len -= size_t(ret);
+        }
+    }
+}
+
+db::wal::wal(bool fsync)
+    : mutex_()
+    , cond_()
+    , fsync_(fsync)
+    , fd_(-1)
+    , written_()
+    , synced_()
+    , sync_in_progress_()
+    , records_()
+    , syncs_()
+{ }
+
+db::wal::~wal()
+{
+    if (fd_ >= 0) ::close(fd_);
+}
+
+wsrep::gtid db::wal::open(
+    const std::string& file,
+    const std::function<void(const wsrep::gtid&,
+                             const std::string&)>& apply)
+{
+    fd_ = ::open(file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+    {
+        throw wsrep::runtime_error(
+            "Failed to open WAL " + file + ": " + ::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd_, &st))
+    {
+        throw wsrep::runtime_error(
+            std::string("WAL stat failed: ") + ::strerror(errno));
+    }
+    std::vector<char> buf(size_t(st.st_size));
+    if (buf.size() &&
+        ::pread(fd_, buf.data(), buf.size(), 0) != ssize_t(buf.size()))
+    {
+        throw wsrep::runtime_error(
+            std::string("WAL read failed: ") + ::strerror(errno));
+    }
+
+    wsrep::gtid ret;
+    size_t pos(0);
+    while (pos + header_size <= buf.size())
+    {
+        uint32_t size, sum;
+        ::memcpy(&size, buf.data() + pos, sizeof(size));
+        ::memcpy(&sum, buf.data() + pos + sizeof(size), sizeof(sum));
+        const char* payload(buf.data() + pos + header_size);
+        if (size < gtid_size || pos + header_size + size > buf.size() ||
+            checksum(payload, size) != sum)
+        {
+            break;
+        }
+        int64_t seqno;
+        ::memcpy(&seqno, payload + sizeof(wsrep::id::native_type),
+                 sizeof(seqno));
+        ret = wsrep::gtid(wsrep::id(payload, sizeof(wsrep::id::native_type)),
+                          wsrep::seqno(seqno));
+        apply(ret, std::string(payload + gtid_size, size - gtid_size));
+        pos += header_size + size;
+        ++records_;
+    }
+    if (pos != buf.size())
+    {
+        wsrep::log_warning() << "Truncating WAL " << file << " from "
+                             << buf.size() << " to " << pos << " bytes";
+        if (::ftruncate(fd_, off_t(pos)))
+        {
+            throw wsrep::runtime_error(
+                std::string("WAL truncate failed: ") + ::strerror(errno));
+        }
+    }
+    if (::lseek(fd_, off_t(pos), SEEK_SET) < 0)
+    {
+        throw wsrep::runtime_error(
+            std::string("WAL seek failed: ") + ::strerror(errno));
+    }
+    written_ = synced_ = pos;
+    wsrep::log_info() << "Recovered " << records_ << " records from WAL "
+                      << file << ", position " << ret;
+    return ret;
+}
+
+db::wal::lsn db::wal::append(const wsrep::gtid& gtid, const std::string& rows)
+{
+    std::string record(header_size + gtid_size, '\0');
+    const uint32_t size(static_cast<uint32_t>(gtid_size + rows.size()));
+    const int64_t seqno(gtid.seqno().get());
+    ::memcpy(&record[0], &size, sizeof(size));
+    ::memcpy(&record[header_size], gtid.id().data(), gtid.id().size());
+    ::memcpy(&record[header_size + gtid.id().size()], &seqno, sizeof(seqno));
+    record += rows;
+    const uint32_t sum(checksum(&record[header_size], size));
+    ::memcpy(&record[sizeof(size)], &sum, sizeof(sum));
+
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    write_all(fd_, record.data(), record.size());
+    written_ += record.size();
+    ++records_;
+    return written_;
+}
+
+void db::wal::sync(lsn target)
+{
+    if (not fsync_) return;
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    while (synced_ < target)
+    {
+        if (sync_in_progress_)
+        {
+            cond_.wait(lock);
+            continue;
+        }
+        // Become the leader and sync everything written so far on
+        // behalf of the followers.
+        sync_in_progress_ = true;
+        const lsn written(written_);
+        lock.unlock();
+        const int err(::fdatasync(fd_) ? errno : 0);
+        lock.lock();
+        sync_in_progress_ = false;
+        if (err)
+        {
+            cond_.notify_all();
+            throw wsrep::runtime_error(
+                std::string("WAL sync failed: ") + ::strerror(err));
+        }
+        synced_ = written;
+        ++syncs_;
+        cond_.notify_all();
+    }
+}
+
+long long db::wal::records() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return records_;
+}
+
+long long db::wal::syncs() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return syncs_;
+}
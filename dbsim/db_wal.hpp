@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_wal.hpp
+ *
+ * Write-ahead log for dbsim storage engine.
+ *
+ * Each committed transaction appends a record containing the commit
+ * GTID and the row images of the transaction. Records are appended
+ * in commit order while the transaction is inside the commit order
+ * critical section. Flushing the log to disk is done after leaving
+ * the critical section with group commit: the first transaction which
+ * needs to sync becomes the leader and syncs all records appended so
+ * far, transactions arriving during the sync wait for the leader and
+ * the next one of them leads the following sync.
+ *
+ * Record format:
+ *   uint32 payload size
+ *   uint32 payload checksum
+ *   payload: GTID id (16 bytes), GTID seqno (int64), row images
+ */
+
+#ifndef WSREP_DB_WAL_HPP
+#define WSREP_DB_WAL_HPP
+
+#include "wsrep/condition_variable.hpp"
+#include "wsrep/gtid.hpp"
+#include "wsrep/mutex.hpp"
+
+#include <functional>
+#include <string>
+
+namespace db
+{
+    class wal
+    {
+    public:
+        typedef uint64_t lsn;
+        /**
+         * Constructor.
+         *
+         * @param fsync If false, records are written but not synced.
+         */
+        explicit wal(bool fsync);
+        ~wal();
+
+        /**
+         * Open log file, creating it if it does not exist, and
+         * recover committed records. Incomplete or corrupted records
+         * at the end of the log are truncated.
+         *
+         * @param file Path to log file.
+         * @param apply Callback called for each recovered record with
+         *              the GTID and row images.
+         *
+         * @return GTID of the last recovered record, undefined if
+         *         the log was empty.
+         *
+         * @throw wsrep::runtime_error If the file cannot be opened.
+         */
+        wsrep::gtid open(
+            const std::string& file,
+            const std::function<void(const wsrep::gtid&,
+                                     const std::string&)>& apply);
+
+        /**
+         * Append record to log.
+         *
+         * @return Log sequence number which must be passed to sync()
+         *         to make the record durable.
+         */
+        lsn append(const wsrep::gtid& gtid, const std::string& rows);
+
+        /**
+         * Wait until the log is durable up to given log sequence
+         * number.
+         */
+        void sync(lsn);
+
+        /** Number of appended records and number of syncs done. */
+        long long records() const;
+        long long syncs() const;
+    private:
+        wal(const wal&);
+        wal& operator=(const wal&);
+
+        mutable wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable cond_;
+        const bool fsync_;
+        int fd_;
+        lsn written_;
+        lsn synced_;
+        bool sync_in_progress_;
+        long long records_;
+        long long syncs_;
+    };
+}
+
+#endif // WSREP_DB_WAL_HPP
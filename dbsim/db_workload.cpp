@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "db_workload.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+static enum db::key_distribution::type distribution_type(
+    const std::string& name)
+{
+    if (name == "uniform") return db::key_distribution::uniform;
+    if (name == "zipfian") return db::key_distribution::zipfian;
+    if (name == "hotspot") return db::key_distribution::hotspot;
+    throw std::invalid_argument("Invalid key distribution: " + name);
+}
+
+bool db::key_distribution::valid_name(const std::string& name)
+{
+    return (name == "uniform" || name == "zipfian" || name == "hotspot");
+}
+
+db::key_distribution::key_distribution(const db::params& params)
+    : type_(distribution_type(params.key_distribution))
+    , rows_(params.n_rows ? params.n_rows : 1)
+    , theta_(params.zipf_theta)
+    , alpha_()
+    , zeta_n_()
+    , eta_()
+    , half_pow_theta_()
+    , hot_rows_()
+    , hot_probability_(params.hotspot_probability)
+{
+    if (type_ == zipfian && rows_ > 1)
+    {
+        // Precomputed constants for the generator of Gray et al.,
+        // "Quickly Generating Billion-Record Synthetic Databases".
+        for (size_t i(1); i <= rows_; ++i)
+        {
+            zeta_n_ += 1./std::pow(double(i), theta_);
+        }
+        const double zeta_2(1. + 1./std::pow(2., theta_));
+        alpha_ = 1./(1. - theta_);
+        eta_ = (1. - std::pow(2./double(rows_), 1. - theta_))
+            / (1. - zeta_2/zeta_n_);
+        half_pow_theta_ = std::pow(0.5, theta_);
+    }
+    else if (type_ == hotspot)
+    {
+        hot_rows_ = static_cast<size_t>(
+            double(rows_) * params.hotspot_fraction);
+        if (hot_rows_ == 0) hot_rows_ = 1;
+        if (hot_rows_ > rows_) hot_rows_ = rows_;
+    }
+}
+
+size_t db::key_distribution::operator()(
+    std::default_random_engine& engine) const
+{
+    switch (type_)
+    {
+    case uniform:
+        break;
+    case zipfian:
+        return zipfian_row(engine);
+    case hotspot:
+        if (hot_rows_ == rows_ ||
+            std::uniform_real_distribution<double>(0., 1.)(engine) <
+            hot_probability_)
+        {
+            return std::uniform_int_distribution<size_t>(
+                0, hot_rows_ - 1)(engine);
+        }
+        return std::uniform_int_distribution<size_t>(
+            hot_rows_, rows_ - 1)(engine);
+    }
+    return std::uniform_int_distribution<size_t>(0, rows_ - 1)(engine);
+}
+
+size_t db::key_distribution::zipfian_row(
+    std::default_random_engine& engine) const
+{
+    if (rows_ == 1) return 0;
+    const double u(std::uniform_real_distribution<double>(0., 1.)(engine));
+    const double uz(u * zeta_n_);
+    if (uz < 1.) return 0;
+    if (uz < 1. + half_pow_theta_) return 1;
+    const size_t ret(static_cast<size_t>(
+                         double(rows_) * std::pow(eta_*u - eta_ + 1., alpha_)));
+    return (ret < rows_ ? ret : rows_ - 1);
+}
+
+db::key_type_mix::key_type_mix(const std::string& mix)
+    : weights_()
+    , total_()
+{
+    std::istringstream is(mix);
+    std::string weight;
+    size_t i(0);
+    while (std::getline(is, weight, ','))
+    {
+        if (i == weights_.size())
+        {
+            throw std::invalid_argument("Too many key type weights: " + mix);
+        }
+        std::istringstream ws(weight);
+        if (not (ws >> weights_[i]) || not ws.eof())
+        {
+            throw std::invalid_argument("Invalid key type weight: " + weight);
+        }
+        total_ += weights_[i];
+        ++i;
+    }
+    if (i != weights_.size())
+    {
+        throw std::invalid_argument(
+            "Key type mix must have four weights: " + mix);
+    }
+}
+
+enum wsrep::key::type db::key_type_mix::operator()(
+    std::default_random_engine& engine) const
+{
+    if (total_ == 0) return wsrep::key::exclusive;
+    unsigned int value(
+        std::uniform_int_distribution<unsigned int>(0, total_ - 1)(engine));
+    for (size_t i(0); i < weights_.size(); ++i)
+    {
+        if (value < weights_[i])
+        {
+            return static_cast<enum wsrep::key::type>(i);
+        }
+        value -= weights_[i];
+    }
+    return wsrep::key::exclusive;
+}
+
+enum wsrep::streaming_context::fragment_unit
+db::fragment_unit(const std::string& unit)
+{
+    if (unit == "bytes") return wsrep::streaming_context::bytes;
+    if (unit == "rows") return wsrep::streaming_context::row;
+    if (unit == "statements") return wsrep::streaming_context::statement;
+    throw std::invalid_argument("Unknown fragment unit: " + unit);
+}
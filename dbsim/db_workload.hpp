@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file db_workload.hpp
+ *
+ * Key distributions and streaming settings for generated transactions.
+ */
+
+#ifndef WSREP_DB_WORKLOAD_HPP
+#define WSREP_DB_WORKLOAD_HPP
+
+#include "db_params.hpp"
+
+#include "wsrep/key.hpp"
+#include "wsrep/streaming_context.hpp"
+
+#include <array>
+#include <random>
+#include <string>
+
+namespace db
+{
+    /**
+     * Row number generator. Rows are drawn from [0, rows) using
+     * one of the distributions:
+     *
+     * - uniform: All rows are equally likely.
+     * - zipfian: Row of rank i is drawn with probability proportional
+     *   to 1/(i + 1)^theta, row 0 being the most popular.
+     * - hotspot: Rows in the first hot fraction of the table are
+     *   drawn with the hot probability, the rest uniformly otherwise.
+     *
+     * The generator is immutable after construction and may be shared
+     * between clients, each client supplies its own random engine.
+     */
+    class key_distribution
+    {
+    public:
+        enum type
+        {
+            uniform,
+            zipfian,
+            hotspot
+        };
+
+        explicit key_distribution(const db::params& params);
+
+        size_t operator()(std::default_random_engine& engine) const;
+
+        enum type type() const { return type_; }
+        size_t rows() const { return rows_; }
+
+        /** Return true if the name is a valid distribution name. */
+        static bool valid_name(const std::string& name);
+    private:
+        size_t zipfian_row(std::default_random_engine& engine) const;
+
+        enum type type_;
+        size_t rows_;
+        // Zipfian
+        double theta_;
+        double alpha_;
+        double zeta_n_;
+        double eta_;
+        double half_pow_theta_;
+        // Hotspot
+        size_t hot_rows_;
+        double hot_probability_;
+    };
+
+    /**
+     * Weighted mix of key types appended by generated transactions.
+     */
+    class key_type_mix
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * @param mix Comma separated weights for shared, reference,
+         *            update and exclusive keys, e.g. "1,0,0,1".
+         *
+         * @throw std::invalid_argument If the mix cannot be parsed.
+         */
+        explicit key_type_mix(const std::string& mix);
+
+        enum wsrep::key::type operator()(
+            std::default_random_engine& engine) const;
+    private:
+        std::array<unsigned int, 4> weights_;
+        unsigned int total_;
+    };
+
+    /**
+     * Parse streaming replication fragment unit.
+     *
+     * @param unit One of "bytes", "rows" or "statements".
+     *
+     * @throw std::invalid_argument If the unit is not known.
+     */
+    enum wsrep::streaming_context::fragment_unit
+    fragment_unit(const std::string& unit);
+}
+
+#endif // WSREP_DB_WORKLOAD_HPP
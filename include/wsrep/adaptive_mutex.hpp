@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file adaptive_mutex.hpp
+ *
+ * Spin-then-park mutex and matching condition variable.
+ *
+ * Client state mutexes are held only for short state checks and
+ * transitions, but are contended when appliers BF abort the client
+ * or the rollbacker takes over the transaction. The adaptive mutex
+ * spins for a bounded number of rounds before parking the thread,
+ * so that short critical sections do not cause context switches.
+ *
+ * Threads are parked on futex on Linux. On other platforms parked
+ * threads yield the processor until woken up.
+ *
+ * The adaptive mutex does not have a pthread mutex handle, it must
+ * be paired with wsrep::adaptive_condition_variable instead of
+ * wsrep::default_condition_variable.
+ */
+
+#ifndef WSREP_ADAPTIVE_MUTEX_HPP
+#define WSREP_ADAPTIVE_MUTEX_HPP
+
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+
+#include <atomic>
+
+namespace wsrep
+{
+    class adaptive_mutex WSREP_FINAL : public wsrep::mutex
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * @param spins Number of spin rounds before parking.
+         */
+        explicit adaptive_mutex(unsigned int spins = 100)
+            : wsrep::mutex()
+            , state_(unlocked)
+            , spins_(spins)
+        { }
+
+        void lock() WSREP_OVERRIDE
+        {
+            int expected(unlocked);
+            if (not state_.compare_exchange_strong(
+                    expected, locked, std::memory_order_acquire))
+            {
+                lock_contended();
+            }
+        }
+
+        void unlock() WSREP_OVERRIDE
+        {
+            if (state_.exchange(unlocked, std::memory_order_release) ==
+                contended)
+            {
+                wake();
+            }
+        }
+
+        void* native() WSREP_OVERRIDE { return &state_; }
+
+    private:
+        enum { unlocked, locked, contended };
+        void lock_contended();
+        void wake();
+
+        std::atomic<int> state_;
+        const unsigned int spins_;
+    };
+
+    /**
+     * Condition variable for adaptive mutex. Waiters are parked
+     * on a sequence number which is incremented by notifications.
+     * Can be used with any wsrep::mutex implementation.
+     */
+    class adaptive_condition_variable WSREP_FINAL
+        : public wsrep::condition_variable
+    {
+    public:
+        adaptive_condition_variable()
+            : seq_()
+        { }
+        void notify_one() WSREP_OVERRIDE;
+        void notify_all() WSREP_OVERRIDE;
+        void wait(wsrep::unique_lock<wsrep::mutex>& lock) WSREP_OVERRIDE;
+    private:
+        std::atomic<int> seq_;
+    };
+}
+
+#endif // WSREP_ADAPTIVE_MUTEX_HPP
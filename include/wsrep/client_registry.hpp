@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file client_registry.hpp
+ *
+ * Registry of local clients with an active transaction.
+ *
+ * When enabled in server state, the registry is populated by
+ * wsrep::transaction when a local transaction starts and
+ * cleaned up when the transaction is cleaned up. BF aborters
+ * may use the registry to look up the victim by transaction or
+ * client id, and TOI operations may iterate over it to select
+ * victims.
+ *
+ * The registry is split into shards, each protected by its own
+ * mutex, so that concurrent transaction starts, cleanups and
+ * lookups contend only when they hash into the same shard.
+ * Lookups are not lock-free: a client state found from the registry
+ * may be cleaned up and released by its owner at any time, and the
+ * shard mutex is what keeps the entry valid while the caller
+ * operates on it.
+ *
+ * Lock ordering: registry shard mutex before client state mutex.
+ * The registry is modified with the client state mutex released,
+ * shard mutexes are never acquired while holding a client state
+ * mutex. Functions passed to for_each() are called with the shard
+ * mutex held, they may lock client state mutexes but must not call
+ * back into the registry.
+ */
+
+#ifndef WSREP_CLIENT_REGISTRY_HPP
+#define WSREP_CLIENT_REGISTRY_HPP
+
+#include "client_id.hpp"
+#include "transaction_id.hpp"
+#include "mutex.hpp"
+#include "lock.hpp"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <cstddef>
+
+namespace wsrep
+{
+    class client_state;
+
+    class client_registry
+    {
+    public:
+        /**
+         * Constructor.
+         *
+         * @param n_shards Number of shards. Zero is treated as one.
+         */
+        explicit client_registry(size_t n_shards = 16);
+        ~client_registry();
+
+        /**
+         * Register client with an active transaction.
+         */
+        void insert(wsrep::client_id client_id,
+                    wsrep::transaction_id transaction_id,
+                    wsrep::client_state* client_state);
+
+        /**
+         * Unregister client and its transaction.
+         */
+        void erase(wsrep::client_id client_id,
+                   wsrep::transaction_id transaction_id);
+
+        /**
+         * Find client state by transaction id.
+         *
+         * The returned pointer is valid only as long as the caller
+         * can guarantee that the client state is not destroyed,
+         * the registry does not pin the client state.
+         *
+         * @return Pointer to client state or null if not found.
+         */
+        wsrep::client_state* find(wsrep::transaction_id) const;
+
+        /**
+         * Find client state by client id.
+         *
+         * @return Pointer to client state or null if not found.
+         */
+        wsrep::client_state* find(wsrep::client_id) const;
+
+        /**
+         * Call f(wsrep::client_state&) for each registered client.
+         * Shards are locked one at the time, so the iteration does
+         * not provide a consistent snapshot over the whole registry.
+         */
+        template <class F> void for_each(F f) const
+        {
+            for (size_t i(0); i < n_shards_; ++i)
+            {
+                const shard& s(shards_[i]);
+                wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+                for (transaction_map::const_iterator j(s.transactions.begin());
+                     j != s.transactions.end(); ++j)
+                {
+                    f(*j->second);
+                }
+            }
+        }
+
+        /**
+         * Call f(const std::vector<wsrep::client_state*>&) with client
+         * states registered for the given transaction ids. Transactions
+         * which are not found are left out.
+         *
+         * Shards containing the transactions are locked in ascending
+         * order for the duration of the call, so the transactions
+         * cannot be unregistered and the client states passed to f
+         * stay valid and keep the given transactions active. Function
+         * f may lock client state mutexes, but it must not call back
+         * into the registry nor complete a transaction rollback
+         * synchronously.
+         */
+        template <class F>
+        void with_transactions(
+            const std::vector<wsrep::transaction_id>& transaction_ids,
+            F f) const
+        {
+            std::vector<size_t> indexes;
+            for (size_t i(0); i < transaction_ids.size(); ++i)
+            {
+                indexes.push_back(shard_index(transaction_ids[i].get()));
+            }
+            std::sort(indexes.begin(), indexes.end());
+            indexes.erase(std::unique(indexes.begin(), indexes.end()),
+                          indexes.end());
+            std::vector<wsrep::unique_lock<wsrep::mutex> > locks;
+            locks.reserve(indexes.size());
+            for (size_t i(0); i < indexes.size(); ++i)
+            {
+                locks.push_back(
+                    wsrep::unique_lock<wsrep::mutex>(
+                        shards_[indexes[i]].mutex));
+            }
+            std::vector<wsrep::client_state*> client_states;
+            for (size_t i(0); i < transaction_ids.size(); ++i)
+            {
+                const shard& s(shard_for(transaction_ids[i].get()));
+                transaction_map::const_iterator j(
+                    s.transactions.find(transaction_ids[i]));
+                if (j != s.transactions.end())
+                {
+                    client_states.push_back(j->second);
+                }
+            }
+            f(client_states);
+        }
+
+        /**
+         * Return number of registered transactions.
+         */
+        size_t size() const;
+
+    private:
+        client_registry(const client_registry&);
+        client_registry& operator=(const client_registry&);
+
+        typedef std::map<wsrep::transaction_id, wsrep::client_state*>
+        transaction_map;
+        typedef std::map<wsrep::client_id, wsrep::client_state*> client_map;
+
+        struct shard
+        {
+            shard() : mutex(), transactions(), clients() { }
+            mutable wsrep::default_mutex mutex;
+            transaction_map transactions;
+            client_map clients;
+        };
+
+        size_t shard_index(unsigned long long id) const
+        {
+            return static_cast<size_t>(id % n_shards_);
+        }
+
+        shard& shard_for(unsigned long long id) const
+        {
+            return shards_[shard_index(id)];
+        }
+
+        size_t n_shards_;
+        shard* shards_;
+    };
+}
+
+#endif // WSREP_CLIENT_REGISTRY_HPP
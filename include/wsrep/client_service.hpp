@@ -169,7 +169,8 @@ namespace wsrep
 
         /**
          * Wait until all replaying transactions have been finished
-         * replaying.
+         * replaying. Not called if the replay gate is enabled in
+         * server state.
          *
          * @todo This should not be visible to DBMS level, should be
          * handled internally by wsrep-lib.
@@ -232,6 +233,32 @@ namespace wsrep
         // Notify state change interface
         //
         virtual void notify_state_change() = 0;
+
+        /**
+         * Return true if the failed statement can be executed again
+         * via reexecute_statement(), for example if it was an
+         * autocommit statement. This is called from
+         * client_state::retry_statement() before backing off, so
+         * that statements which cannot be retried fail immediately.
+         *
+         * The default implementation does not support retrying.
+         */
+        virtual bool is_retryable_statement() { return false; }
+
+        /**
+         * Execute the failed statement again. This is called from
+         * client_state::retry_statement(). The implementation must
+         * go through the complete statement processing including
+         * client_state::before_statement() and
+         * client_state::after_statement().
+         *
+         * The default implementation does not support retrying.
+         *
+         * @return Zero if the statement was executed, non-zero if
+         *         the statement cannot be retried, for example if
+         *         it was not an autocommit statement.
+         */
+        virtual int reexecute_statement() { return 1; }
     };
 
 }
@@ -36,6 +36,8 @@
 #include "client_id.hpp"
 #include "mutex.hpp"
 #include "lock.hpp"
+#include "lazy.hpp"
+#include "state_history.hpp"
 #include "buffer.hpp"
 #include "thread.hpp"
 #include "xid.hpp"
@@ -44,6 +46,7 @@
 namespace wsrep
 {
     class client_service;
+    class client_state_lock;
     class server_state;
     class provider;
     class condition_variable;
@@ -602,6 +605,25 @@ namespace wsrep
          */
         int total_order_bf_abort(wsrep::seqno bf_seqno);
 
+        /**
+         * Brute force abort a transaction as a part of bulk BF abort,
+         * see wsrep::server_state::bf_abort(). The victim is not handed
+         * to the background rollbacker, instead deferred_rollback is
+         * set to true if background rollback is required.
+         *
+         * @param lock Lock to protect client state.
+         * @param bf_seqno Seqno of the BF aborter.
+         * @param total_order True if the BF abort is done in total order.
+         * @param[out] deferred_rollback Set to true if the victim must
+         *             be rolled back by the background rollbacker.
+         *
+         * @return Non-zero if the transaction was BF aborted.
+         */
+        int bf_abort_deferred(wsrep::unique_lock<wsrep::mutex>& lock,
+                              wsrep::seqno bf_seqno,
+                              bool total_order,
+                              bool& deferred_rollback);
+
         /**
          * Adopt a streaming transaction state. This is must be
          * called from high_priority_service::adopt_transaction()
@@ -664,7 +686,7 @@ namespace wsrep
          */
         bool in_toi() const
         {
-            return (toi_meta_.seqno().is_undefined() == false);
+            return (toi_meta_.get().seqno().is_undefined() == false);
         }
 
         /**
@@ -858,7 +880,7 @@ namespace wsrep
 
         const wsrep::ws_meta& toi_meta() const
         {
-            return toi_meta_;
+            return toi_meta_.get();
         }
 
         /**
@@ -891,6 +913,67 @@ namespace wsrep
             return last_written_gtid_;
         }
 
+        /**
+         * Retry policy for statements which were rolled back because
+         * of certification failure or BF abort.
+         */
+        struct retry_policy
+        {
+            retry_policy()
+                : max_attempts(0)
+                , backoff_min_us(1000)
+                , backoff_max_us(100000)
+            { }
+            retry_policy(size_t max_attempts_arg,
+                         unsigned long backoff_min_us_arg,
+                         unsigned long backoff_max_us_arg)
+                : max_attempts(max_attempts_arg)
+                , backoff_min_us(backoff_min_us_arg)
+                , backoff_max_us(backoff_max_us_arg)
+            { }
+            /** Maximum number of retries, zero disables retrying. */
+            size_t max_attempts;
+            /** Backoff before the first retry in microseconds. */
+            unsigned long backoff_min_us;
+            /** Upper bound for backoff in microseconds. */
+            unsigned long backoff_max_us;
+        };
+
+        /**
+         * Set statement retry policy.
+         */
+        void set_retry_policy(const struct retry_policy& policy)
+        {
+            retry_policy_ = policy;
+        }
+
+        /**
+         * Retry the statement which failed with deadlock error.
+         *
+         * This should be called after after_statement() when
+         * current_error() is wsrep::e_deadlock_error. If
+         * client_service::is_retryable_statement() returns true, the
+         * statement is executed again via
+         * client_service::reexecute_statement() after a jittered
+         * exponential backoff until it succeeds, fails with another
+         * error or the maximum number of attempts given in retry
+         * policy has been reached.
+         *
+         * @return Zero if the statement succeeded on retry, non-zero
+         *         otherwise. In case of failure current_error() returns
+         *         the error of the last attempt.
+         */
+        int retry_statement();
+
+        /** Number of statement retry attempts. */
+        size_t statement_retries() const { return statement_retries_; }
+
+        /** Number of statements which succeeded on retry. */
+        size_t statement_retry_successes() const
+        {
+            return statement_retry_successes_;
+        }
+
         /**
          * Set debug logging level.
          *
@@ -955,6 +1038,9 @@ namespace wsrep
         /**
          * Client context constuctor. This is protected so that it
          * can be called from derived class constructors only.
+         *
+         * All waits inside client state use the given condition
+         * variable.
          */
         client_state(wsrep::mutex& mutex,
                      wsrep::condition_variable& cond,
@@ -962,10 +1048,40 @@ namespace wsrep
                      wsrep::client_service& client_service,
                      const client_id& id,
                      enum mode mode)
+            : client_state(mutex, cond, cond, cond, server_state,
+                           client_service, id, mode)
+        { }
+
+        /**
+         * Client context constructor with a separate condition
+         * variable for each reason to wait inside client state, so
+         * that a notification wakes up only the thread waiting for it.
+         * The condition variables may be instrumented by the caller.
+         * Condition variables given for rollback_complete_cond and
+         * streaming_rollback_cond must not be shared with other
+         * client states.
+         *
+         * @param rollback_complete_cond Condition variable for the
+         *        owning thread waiting for the rollbacker to complete.
+         * @param streaming_rollback_cond Condition variable for threads
+         *        entering streaming rollback while another thread is
+         *        in streaming rollback.
+         */
+        client_state(wsrep::mutex& mutex,
+                     wsrep::condition_variable& cond,
+                     wsrep::condition_variable& rollback_complete_cond,
+                     wsrep::condition_variable& streaming_rollback_cond,
+                     wsrep::server_state& server_state,
+                     wsrep::client_service& client_service,
+                     const client_id& id,
+                     enum mode mode)
             : owning_thread_id_(wsrep::this_thread::get_id())
             , rollbacker_active_(false)
             , mutex_(mutex)
+            , default_mutex_()
             , cond_(cond)
+            , rollback_complete_cond_(rollback_complete_cond)
+            , streaming_rollback_cond_(streaming_rollback_cond)
             , server_state_(server_state)
             , client_service_(client_service)
             , id_(id)
@@ -983,6 +1099,10 @@ namespace wsrep
             , current_error_(wsrep::e_success)
             , current_error_status_(wsrep::provider::success)
             , keep_command_error_()
+            , retry_policy_()
+            , retry_seed_(id.get() * 0x9e3779b97f4a7c15ULL + 1)
+            , statement_retries_()
+            , statement_retry_successes_()
         { }
 
     private:
@@ -990,10 +1110,14 @@ namespace wsrep
         client_state& operator=(client_state&);
 
         friend class client_state_switch;
+        friend class client_state_lock;
         friend class high_priority_context;
         friend class transaction;
 
         void do_acquire_ownership(wsrep::unique_lock<wsrep::mutex>& lock);
+        // Notify a waiter on wait channel. All waiters are notified
+        // if the channel is shared.
+        void notify_waiter(wsrep::condition_variable& channel);
         // Wait for sync rollbacker to finish, with lock. Changes state
         // to exec.
         void do_wait_rollback_complete_and_acquire_ownership(
@@ -1024,21 +1148,34 @@ namespace wsrep
                        bool& timed_out);
         void enter_toi_common(wsrep::unique_lock<wsrep::mutex>&);
         void leave_toi_common();
+        // Return backoff in microseconds before retry attempt.
+        unsigned long retry_backoff(size_t attempt);
 
         wsrep::thread::id owning_thread_id_;
         bool rollbacker_active_;
         wsrep::mutex& mutex_;
+        // Non-null if mutex_ is wsrep::default_mutex, see
+        // client_state_lock. Resolved in open(), the mutex may not
+        // be constructed yet in the constructor.
+        wsrep::default_mutex* default_mutex_;
         wsrep::condition_variable& cond_;
+        // Wait channel for rollbacker completion, waited by the
+        // owning thread.
+        wsrep::condition_variable& rollback_complete_cond_;
+        // Wait channel for threads entering streaming rollback while
+        // another thread is in streaming rollback.
+        wsrep::condition_variable& streaming_rollback_cond_;
         wsrep::server_state& server_state_;
         wsrep::client_service& client_service_;
         wsrep::client_id id_;
         enum mode mode_;
         enum mode toi_mode_;
         enum state state_;
-        std::vector<enum state> state_hist_;
+        wsrep::state_history<enum state, 10> state_hist_;
         wsrep::transaction transaction_;
-        wsrep::ws_meta toi_meta_;
-        wsrep::ws_meta nbo_meta_;
+        // TOI and NBO meta data are allocated only while in use.
+        wsrep::lazy<wsrep::ws_meta> toi_meta_;
+        wsrep::lazy<wsrep::ws_meta> nbo_meta_;
         bool allow_dirty_reads_;
         wsrep::gtid sync_wait_gtid_;
         wsrep::gtid last_written_gtid_;
@@ -1046,6 +1183,10 @@ namespace wsrep
         enum wsrep::client_error current_error_;
         enum wsrep::provider::status current_error_status_;
         bool keep_command_error_;
+        struct retry_policy retry_policy_;
+        unsigned long long retry_seed_;
+        size_t statement_retries_;
+        size_t statement_retry_successes_;
 
         /**
          * Marks external rollbacker thread for the client
@@ -1096,6 +1237,54 @@ namespace wsrep
         return to_c_string(mode);
     }
 
+    /**
+     * Lock on client state mutex, which can be passed to functions
+     * taking wsrep::unique_lock<wsrep::mutex>&.
+     *
+     * If the client state was constructed with wsrep::default_mutex
+     * and it has been opened, the constructor locks and the destructor
+     * unlocks the mutex by calling default_mutex directly, without
+     * virtual dispatch.
+     * Unlocking and relocking through wsrep::unique_lock calls the
+     * virtual interface as usual.
+     */
+    class client_state_lock : public wsrep::unique_lock<wsrep::mutex>
+    {
+    public:
+        explicit client_state_lock(wsrep::client_state& client_state)
+            : wsrep::unique_lock<wsrep::mutex>(lock_mutex(client_state),
+                                               std::adopt_lock)
+            , default_mutex_(client_state.default_mutex_)
+        { }
+
+        ~client_state_lock()
+        {
+            if (default_mutex_ && owns_lock())
+            {
+                release();
+                default_mutex_->unlock();
+            }
+        }
+    private:
+        client_state_lock(const client_state_lock&);
+        client_state_lock& operator=(const client_state_lock&);
+
+        static wsrep::mutex& lock_mutex(wsrep::client_state& client_state)
+        {
+            if (client_state.default_mutex_)
+            {
+                client_state.default_mutex_->lock();
+            }
+            else
+            {
+                client_state.mutex_.lock();
+            }
+            return client_state.mutex_;
+        }
+
+        wsrep::default_mutex* default_mutex_;
+    };
+
     /**
      * Utility class to switch the client state to high priority
      * mode. The client is switched back to the original mode
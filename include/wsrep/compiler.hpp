@@ -32,8 +32,11 @@
  *                  it, otherwise "__attribute__((noreturn))".
  * WSREP_OVERRIDE - Set to "override" if the compiler supports it, otherwise
  *                  left empty.
+ * WSREP_FINAL - Set to "final" if the compiler supports it, otherwise
+ *               left empty.
  * WSREP_UNUSED - Can be used to mark variables which may be present in
  *                debug builds but not in release builds.
+ * WSREP_UNLIKELY - Hint that the condition is expected to be false.
  * WSREP_FALLTHROUGH - Silence implicit fallthrough warning.
  */
 
@@ -49,11 +52,14 @@
 #if __cplusplus >= 201103L
 #define WSREP_NOEXCEPT noexcept
 #define WSREP_OVERRIDE override
+#define WSREP_FINAL final
 #else
 #define WSREP_NOEXCEPT
 #define WSREP_OVERRIDE
+#define WSREP_FINAL
 #endif // __cplusplus >= 201103L
 #define WSREP_UNUSED __attribute__((unused))
+#define WSREP_UNLIKELY(x) __builtin_expect(!!(x), 0)
 
 #if __GNUC__ >= 7
 #define WSREP_FALLTHROUGH __attribute__((fallthrough))
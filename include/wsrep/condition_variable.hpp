@@ -21,9 +21,12 @@
 #define WSREP_CONDITION_VARIABLE_HPP
 
 #include "compiler.hpp"
+#include "mutex.hpp"
 #include "lock.hpp"
 
 #include <cstdlib>
+#include <cerrno>
+#include <ctime>
 
 namespace wsrep
 {
@@ -80,6 +83,29 @@ namespace wsrep
             }
         }
 
+        /**
+         * Wait until notified or until the absolute time, given in
+         * CLOCK_REALTIME, has passed.
+         *
+         * @return False if the time passed, true otherwise.
+         */
+        bool wait_until(wsrep::unique_lock<wsrep::mutex>& lock,
+                        const struct timespec& abstime)
+        {
+            pthread_mutex_t* mutex(
+                reinterpret_cast<pthread_mutex_t*>(lock.mutex()->native()));
+            const int err(pthread_cond_timedwait(&cond_, mutex, &abstime));
+            if (err == ETIMEDOUT)
+            {
+                return false;
+            }
+            if (err)
+            {
+                throw wsrep::runtime_error("Cond timed wait failed");
+            }
+            return true;
+        }
+
     private:
         pthread_cond_t cond_;
     };
@@ -46,6 +46,23 @@ namespace wsrep
         {
             return server_state_.on_apply(*this, ws_handle, ws_meta, data);
         }
+
+        /**
+         * Apply write set given as a view over provider native meta
+         * data. This is called by the provider apply callback.
+         *
+         * The default implementation constructs the complete ws_meta
+         * from the view and calls apply() above. Implementations which
+         * handle some write sets without complete meta data, for
+         * example skip write sets by seqno, may override this to
+         * avoid the conversion.
+         */
+        virtual int apply(const ws_handle& ws_handle,
+                          const ws_meta_view& ws_meta_view,
+                          const const_buffer& data)
+        {
+            return apply(ws_handle, ws_meta_view.ws_meta(), data);
+        }
         /**
          * Start a new transaction
          */
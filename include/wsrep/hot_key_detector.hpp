@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file hot_key_detector.hpp
+ *
+ * Detection of certification keys which are involved in conflicts
+ * frequently.
+ *
+ * When enabled in server state, transactions record hashes of
+ * their certification keys. The keys of transactions which are
+ * BF aborted or fail certification are fed into a count-min sketch
+ * whose counters are halved periodically, so that the estimates
+ * follow recent conflicts.
+ *
+ * Optionally local transactions which touch hot keys are serialized
+ * through local key locks before certification. Local transactions
+ * then queue for hot keys on this node instead of conflicting in
+ * the cluster.
+ *
+ * Key locks are a fixed array of slots indexed by key hash modulo
+ * the number of slots. Unrelated hot keys which map to the same slot
+ * serialize transactions accessing them. This is harmless for
+ * correctness, the number of slots is chosen large compared to the
+ * expected number of simultaneously hot keys.
+ *
+ * A transaction waiting for a key lock may hold resources which
+ * an applier needs. The applier BF aborts the waiter and BF abort
+ * interrupts the wait, see interrupt().
+ */
+
+#ifndef WSREP_HOT_KEY_DETECTOR_HPP
+#define WSREP_HOT_KEY_DETECTOR_HPP
+
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+namespace wsrep
+{
+    class key;
+    class transaction;
+
+    class hot_key_detector
+    {
+    public:
+        typedef unsigned long long hash_type;
+
+        /**
+         * Constructor.
+         *
+         * @param threshold Conflict count estimate at which the key
+         *        is considered hot.
+         * @param serialize If true, local transactions touching
+         *        hot keys are serialized with local key locks.
+         * @param decay_interval Number of recorded conflicts after
+         *        which all the counters are halved.
+         */
+        hot_key_detector(unsigned int threshold = 8,
+                         bool serialize = true,
+                         size_t decay_interval = 10000);
+
+        /**
+         * Hash of the certification key.
+         */
+        static hash_type hash(const wsrep::key& key);
+
+        /**
+         * Record keys of a conflicting transaction.
+         */
+        void record_conflict(const std::vector<hash_type>& keys);
+
+        /**
+         * Return conflict count estimate for the key.
+         */
+        unsigned int estimate(hash_type key) const;
+
+        /**
+         * Return true if the key is considered hot.
+         */
+        bool is_hot(hash_type key) const;
+
+        /**
+         * Acquire local key locks for hot keys in the set. The locks
+         * are acquired in order to avoid deadlocks between local
+         * transactions. Does nothing if serialization is disabled.
+         *
+         * The client state lock of the transaction is released while
+         * waiting for key locks. If the wait is interrupted or the
+         * timeout expires, the key locks acquired so far are released.
+         * The caller must then check if the transaction was aborted
+         * and call lock() again if not.
+         *
+         * @param keys Key hashes of the transaction.
+         * @param[out] slots Locked slots, to be passed to unlock().
+         * @param waiter Transaction acquiring the locks.
+         * @param lock Client state lock of the transaction.
+         * @param timeout Timeout in seconds.
+         *
+         * @return True if all locks were acquired, false if the wait
+         *         was interrupted or timed out.
+         */
+        bool lock(const std::vector<hash_type>& keys,
+                  std::vector<size_t>& slots,
+                  const wsrep::transaction& waiter,
+                  wsrep::unique_lock<wsrep::mutex>& lock,
+                  int timeout = 1);
+
+        /**
+         * Interrupt the key lock wait of the given transaction.
+         * Called with the client state lock of the transaction held.
+         */
+        void interrupt(const wsrep::transaction& waiter);
+
+        /**
+         * Release local key locks acquired by lock().
+         */
+        void unlock(std::vector<size_t>& slots);
+
+        /** Number of conflicts recorded. */
+        size_t conflicts() const;
+        /** Number of transactions which took local key locks. */
+        size_t serialized() const;
+        /** Number of transactions which waited for local key lock. */
+        size_t lock_waits() const;
+
+    private:
+        hot_key_detector(const hot_key_detector&);
+        hot_key_detector& operator=(const hot_key_detector&);
+
+        static const size_t depth_ = 4;
+        static const size_t width_ = 4096;
+        // Hot keys which collide in slots share the key lock.
+        static const size_t n_slots_ = 1024;
+
+        size_t cell(size_t row, hash_type key) const;
+        unsigned int estimate(wsrep::unique_lock<wsrep::mutex>&,
+                              hash_type key) const;
+
+        mutable wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable cond_;
+        const unsigned int threshold_;
+        const bool serialize_;
+        const size_t decay_interval_;
+        std::vector<unsigned int> counters_;
+        std::vector<bool> slots_;
+        // Waiting transactions and whether the wait was interrupted.
+        std::map<const wsrep::transaction*, bool> waiters_;
+        size_t since_decay_;
+        size_t conflicts_;
+        size_t serialized_;
+        size_t lock_waits_;
+    };
+}
+
+#endif // WSREP_HOT_KEY_DETECTOR_HPP
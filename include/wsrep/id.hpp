@@ -63,7 +63,10 @@ namespace wsrep
             {
                 throw wsrep::runtime_error("Too long identifier");
             }
-            std::memset(data_.buf, 0, sizeof(data_.buf));
+            if (size < sizeof(data_.buf))
+            {
+                std::memset(data_.buf, 0, sizeof(data_.buf));
+            }
             std::memcpy(data_.buf, data, size);
         }
 
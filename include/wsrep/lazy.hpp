@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file lazy.hpp
+ *
+ * Lazily allocated storage for rarely used parts of per connection
+ * objects.
+ */
+
+#ifndef WSREP_LAZY_HPP
+#define WSREP_LAZY_HPP
+
+#include <cstddef>
+
+namespace wsrep
+{
+    /**
+     * Holder for an object of type T which is allocated on the first
+     * modification. Until then get() returns a reference to a shared
+     * default constructed object. T must be default constructible
+     * and copy assignable.
+     */
+    template <class T>
+    class lazy
+    {
+    public:
+        lazy() : ptr_() { }
+        ~lazy() { delete ptr_; }
+
+        /** Return true if the object has been allocated. */
+        bool allocated() const { return (ptr_ != 0); }
+
+        /** Return the object for reading, never allocates. */
+        const T& get() const { return (ptr_ ? *ptr_ : empty()); }
+
+        /** Return the object for modification, allocates if needed. */
+        T& mut()
+        {
+            if (not ptr_) ptr_ = new T();
+            return *ptr_;
+        }
+
+        /** Assign value, allocates if needed. */
+        lazy& operator=(const T& value)
+        {
+            mut() = value;
+            return *this;
+        }
+
+        /** Copy value of other, releases storage if other is empty. */
+        void assign(const lazy& other)
+        {
+            if (other.ptr_) mut() = *other.ptr_;
+            else reset();
+        }
+
+        /** Release storage, get() returns default object afterwards. */
+        void reset()
+        {
+            delete ptr_;
+            ptr_ = 0;
+        }
+    private:
+        lazy(const lazy&);
+        lazy& operator=(const lazy&);
+
+        static const T& empty()
+        {
+            static const T value;
+            return value;
+        }
+
+        T* ptr_;
+    };
+}
+
+#endif // WSREP_LAZY_HPP
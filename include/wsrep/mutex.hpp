@@ -45,8 +45,16 @@ namespace wsrep
         mutex& operator=(const mutex& other);
     };
 
-    // Default pthread implementation
-    class default_mutex : public wsrep::mutex
+    /**
+     * Default pthread implementation.
+     *
+     * The class is final and lock() and unlock() are inline, so that
+     * locking through default_mutex, for example with
+     * wsrep::unique_lock<wsrep::default_mutex>, calls pthread directly
+     * without virtual dispatch. Instrumented mutexes should derive
+     * from wsrep::mutex.
+     */
+    class default_mutex WSREP_FINAL : public wsrep::mutex
     {
     public:
         default_mutex()
@@ -65,7 +73,7 @@ namespace wsrep
 
         void lock() WSREP_OVERRIDE
         {
-            if (pthread_mutex_lock(&mutex_))
+            if (WSREP_UNLIKELY(pthread_mutex_lock(&mutex_)))
             {
                 throw wsrep::runtime_error("mutex lock failed");
             }
@@ -73,7 +81,7 @@ namespace wsrep
 
         void unlock() WSREP_OVERRIDE
         {
-            if (pthread_mutex_unlock(&mutex_))
+            if (WSREP_UNLIKELY(pthread_mutex_unlock(&mutex_)))
             {
                 throw wsrep::runtime_error("mutex unlock failed");
             }
@@ -30,7 +30,9 @@
 #include <cstring>
 
 #include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include <ostream>
 
@@ -193,6 +195,117 @@ namespace wsrep
 
     std::ostream& operator<<(std::ostream& os, const wsrep::ws_meta& ws_meta);
 
+    /**
+     * Read only view over write set meta data owned by the caller.
+     *
+     * The view refers to the identifier buffers and integer fields
+     * of the provider native meta data and converts fields only when
+     * they are accessed. The complete wsrep::ws_meta object is
+     * constructed at most once, when first requested by ws_meta().
+     *
+     * The referenced buffers must remain valid for the lifetime
+     * of the view, typically for the duration of a provider
+     * apply callback.
+     */
+    class ws_meta_view
+    {
+    public:
+        /**
+         * Construct a view over native meta data.
+         *
+         * @param group_id Pointer to 16 byte group identifier.
+         * @param seqno Native sequence number.
+         * @param server_id Pointer to 16 byte originating server id.
+         * @param transaction_id Transaction identifier.
+         * @param client_id Client identifier.
+         * @param depends_on Sequence number of the dependency.
+         * @param flags Write set flags, see wsrep::provider::flag.
+         */
+        ws_meta_view(const void* group_id,
+                     long long seqno,
+                     const void* server_id,
+                     unsigned long long transaction_id,
+                     unsigned long long client_id,
+                     long long depends_on,
+                     int flags)
+            : group_id_(group_id)
+            , seqno_(seqno)
+            , server_id_(server_id)
+            , transaction_id_(transaction_id)
+            , client_id_(client_id)
+            , depends_on_(depends_on)
+            , flags_(flags)
+            , storage_()
+            , materialized_()
+        { }
+
+        ~ws_meta_view()
+        {
+            if (materialized_) get()->~ws_meta();
+        }
+
+        int flags() const { return flags_; }
+
+        wsrep::seqno seqno() const { return wsrep::seqno(seqno_); }
+
+        wsrep::id group_id() const
+        {
+            return wsrep::id(group_id_, sizeof(wsrep::id::native_type));
+        }
+
+        wsrep::id server_id() const
+        {
+            return wsrep::id(server_id_, sizeof(wsrep::id::native_type));
+        }
+
+        wsrep::transaction_id transaction_id() const
+        {
+            return wsrep::transaction_id(transaction_id_);
+        }
+
+        wsrep::client_id client_id() const
+        {
+            return wsrep::client_id(client_id_);
+        }
+
+        wsrep::seqno depends_on() const { return wsrep::seqno(depends_on_); }
+
+        /**
+         * Return reference to complete ws_meta object. The object
+         * is constructed on first call and cached for subsequent calls.
+         */
+        const wsrep::ws_meta& ws_meta() const
+        {
+            if (not materialized_)
+            {
+                new (&storage_) wsrep::ws_meta(
+                    wsrep::gtid(group_id(), seqno()),
+                    wsrep::stid(server_id(), transaction_id(), client_id()),
+                    depends_on(), flags_);
+                materialized_ = true;
+            }
+            return *get();
+        }
+    private:
+        ws_meta_view(const ws_meta_view&);
+        ws_meta_view& operator=(const ws_meta_view&);
+        const wsrep::ws_meta* get() const
+        {
+            return reinterpret_cast<const wsrep::ws_meta*>(&storage_);
+        }
+        const void* group_id_;
+        long long seqno_;
+        const void* server_id_;
+        unsigned long long transaction_id_;
+        unsigned long long client_id_;
+        long long depends_on_;
+        int flags_;
+        // Storage for ws_meta, constructed only when requested.
+        mutable std::aligned_storage<sizeof(wsrep::ws_meta),
+                                     alignof(wsrep::ws_meta)>::type storage_;
+        mutable bool materialized_;
+    };
+
     // Abstract interface for provider implementations
     class provider
     {
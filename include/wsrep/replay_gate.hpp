@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file replay_gate.hpp
+ *
+ * Per key gating of local certification against replaying
+ * transactions.
+ *
+ * When enabled in server state, the certification keys of each
+ * transaction are recorded. A transaction which must replay
+ * enters the gate with its keys and leaves the gate when the replay
+ * is over. Transactions going to certification wait if some of their
+ * keys overlap with keys of a replaying transaction.
+ *
+ * The waiter may hold resources which the replaying transaction
+ * needs, in which case the replayer BF aborts the waiter. BF abort
+ * interrupts the wait, see interrupt().
+ *
+ * Keys overlap if they are equal or if one is a prefix of the other
+ * in terms of key parts. Key types are not considered, so the
+ * check is conservative.
+ */
+
+#ifndef WSREP_REPLAY_GATE_HPP
+#define WSREP_REPLAY_GATE_HPP
+
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace wsrep
+{
+    class key;
+    class transaction;
+
+    class replay_gate
+    {
+    public:
+        typedef std::vector<std::string> key_vector;
+
+        replay_gate();
+
+        /**
+         * Encode certification key into a form stored in key vectors.
+         * Encoded key is a prefix of another encoded key if and only
+         * if its key parts are a prefix of other key parts.
+         */
+        static std::string encode(const wsrep::key& key);
+
+        /**
+         * Register keys of a transaction which is about to replay.
+         */
+        void enter(const key_vector& keys);
+
+        /**
+         * Unregister keys of a transaction which has finished replaying
+         * and wake up waiters.
+         */
+        void leave(const key_vector& keys);
+
+        /**
+         * Wait until none of the keys overlap with keys of replaying
+         * transactions. The client state lock of the waiting
+         * transaction is released for the duration of the wait.
+         * The wait returns early if it is interrupted or if
+         * the timeout expires, the caller must check if the
+         * transaction was aborted and call wait() again if not.
+         *
+         * @param keys Keys of the waiting transaction.
+         * @param waiter Waiting transaction.
+         * @param lock Client state lock of the waiting transaction.
+         * @param timeout Timeout in seconds.
+         *
+         * @return True if none of the keys overlap, false if the
+         *         wait was interrupted or timed out.
+         */
+        bool wait(const key_vector& keys,
+                  const wsrep::transaction& waiter,
+                  wsrep::unique_lock<wsrep::mutex>& lock,
+                  int timeout = 1);
+
+        /**
+         * Interrupt the wait of the given transaction. Called with
+         * the client state lock of the transaction held.
+         */
+        void interrupt(const wsrep::transaction& waiter);
+
+        /**
+         * Return true if any of the keys overlaps with keys of
+         * replaying transactions.
+         */
+        bool conflicts(const key_vector& keys) const;
+
+        /**
+         * Return number of replaying transactions.
+         */
+        size_t replayers() const;
+
+        /**
+         * Return number of wait() calls which had to wait for
+         * a replaying transaction.
+         */
+        size_t waits() const;
+
+    private:
+        replay_gate(const replay_gate&);
+        replay_gate& operator=(const replay_gate&);
+
+        bool conflicts(wsrep::unique_lock<wsrep::mutex>&,
+                       const key_vector&) const;
+
+        mutable wsrep::default_mutex mutex_;
+        wsrep::default_condition_variable cond_;
+        std::multiset<std::string> keys_;
+        // Waiting transactions and whether the wait was interrupted.
+        std::map<const wsrep::transaction*, bool> waiters_;
+        size_t replayers_;
+        size_t waits_;
+    };
+}
+
+#endif // WSREP_REPLAY_GATE_HPP
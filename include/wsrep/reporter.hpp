@@ -57,6 +57,13 @@ namespace wsrep
          */
         void report_progress(const std::string& json);
 
+        /**
+         * Format progress JSON string for report_progress().
+         */
+        static std::string make_progress_string(int from, int to,
+                                                int total, int done,
+                                                int indefinite);
+
         /**
          * Report provider event.
          * {
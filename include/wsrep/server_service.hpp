@@ -32,6 +32,7 @@
 #include "server_state.hpp"
 
 #include <string>
+#include <vector>
 
 namespace wsrep
 {
@@ -94,6 +95,20 @@ namespace wsrep
                                          wsrep::client_state& client_state)
             = 0;
 
+        /**
+         * Perform a background rollback for a batch of transactions
+         * which were BF aborted by wsrep::server_state::bf_abort().
+         * The victims have been marked for background rollback, but
+         * their locks are not held when this method is called.
+         *
+         * The default implementation hands over the victims one by
+         * one to background_rollback().
+         *
+         * @param victims Client sessions to do background rollback for.
+         */
+        virtual void background_rollback_batch(
+            const std::vector<wsrep::client_state*>& victims);
+
         /**
          * Bootstrap a DBMS state for a new cluster.
          *
@@ -145,6 +160,9 @@ namespace wsrep
          * This is overload for calls which are done from client context,
          * e.g. after SST has been received.
          *
+         * Independent transactions may be reconstructed in parallel
+         * using wsrep::streaming_applier_recovery.
+         *
          * @param client_service Reference to client service object
          */
         virtual void recover_streaming_appliers(
@@ -91,9 +91,13 @@
 #include "provider.hpp"
 #include "compiler.hpp"
 #include "xid.hpp"
+#include "client_registry.hpp"
+#include "replay_gate.hpp"
+#include "hot_key_detector.hpp"
 
 #include <memory>
 #include <deque>
+#include <queue>
 #include <functional>
 #include <vector>
 #include <string>
@@ -272,6 +276,87 @@ namespace wsrep
         wsrep::high_priority_service* find_streaming_applier(
             const wsrep::xid& xid) const;
 
+        /**
+         * BF abort a set of victims in one sweep. All victims are
+         * marked for abort first, after which the victims requiring
+         * background rollback are handed to the background rollbacker
+         * in a single batch via
+         * server_service::background_rollback_batch().
+         *
+         * This must not be called while holding the server state lock
+         * or any of the victim client state locks.
+         *
+         * @param victims Client sessions to be BF aborted.
+         * @param bf_seqno Seqno of the BF aborter.
+         * @param total_order True if the BF abort is done in total order,
+         *        e.g. by TOI operation.
+         *
+         * @return Number of victims which were BF aborted.
+         */
+        size_t bf_abort(const std::vector<wsrep::client_state*>& victims,
+                        wsrep::seqno bf_seqno,
+                        bool total_order);
+
+        /**
+         * Enable registry of local clients with an active
+         * transaction. The registry is populated at
+         * transaction::start_transaction() and cleaned up at
+         * transaction cleanup. This must be called before any
+         * local transaction is started.
+         *
+         * @param n_shards Number of registry shards.
+         */
+        void enable_client_registry(size_t n_shards = 16);
+
+        /**
+         * Return registry of local clients with an active
+         * transaction, null pointer if the registry is not enabled.
+         */
+        wsrep::client_registry* client_registry() const
+        {
+            return client_registry_.get();
+        }
+
+        /**
+         * Enable per key gating of certification against replaying
+         * transactions. When enabled, transactions wait in
+         * certification only for replaying transactions with
+         * overlapping keys, client_service::wait_for_replayers()
+         * is not called. client_service::signal_replayed() is still
+         * called after replaying. This must be called before any
+         * local transaction is started.
+         */
+        void enable_replay_gate();
+
+        /**
+         * Return replay gate, null pointer if not enabled.
+         */
+        wsrep::replay_gate* replay_gate() const
+        {
+            return replay_gate_.get();
+        }
+
+        /**
+         * Enable hot key detection. Keys of transactions which are
+         * BF aborted or fail certification are tracked, and if
+         * serialize is true, local transactions touching hot keys
+         * are serialized before certification. This must be called
+         * before any local transaction is started.
+         *
+         * @param threshold Conflict count at which a key becomes hot.
+         * @param serialize Serialize local transactions on hot keys.
+         */
+        void enable_hot_key_detector(unsigned int threshold = 8,
+                                     bool serialize = true);
+
+        /**
+         * Return hot key detector, null pointer if not enabled.
+         */
+        wsrep::hot_key_detector* hot_key_detector() const
+        {
+            return hot_key_detector_.get();
+        }
+
         /**
          * Queue a rollback fragment the transaction with given id
          */
@@ -397,11 +482,46 @@ namespace wsrep
          * Wait until all the write sets up to given GTID have been
          * committed.
          *
-         * @return Zero on success, non-zero on failure.
+         * If the GTID has already been released from commit order on
+         * this node, or it is currently in commit order, the wait is
+         * resolved locally without calling the provider. Otherwise
+         * the call is passed to provider.
+         *
+         * Local wait for a GTID in commit order is bounded by the
+         * timeout. Negative timeout selects provider default timeout
+         * and the call is always passed to provider.
+         *
+         * @param timeout Timeout in seconds.
+         *
+         * @return Zero on success, error_transaction_missing if the
+         *         local wait timed out, other non-zero on failure.
          */
         enum wsrep::provider::status
         wait_for_gtid(const wsrep::gtid&, int timeout) const;
 
+        /**
+         * Return the highest GTID which is known to have been released
+         * from commit order on this node.
+         */
+        wsrep::gtid committed_gtid() const;
+
+        /**
+         * Notify server state that a write set with given GTID
+         * has entered commit order. As the commit order is
+         * entered in seqno order, all the preceding write sets
+         * have been released from commit order.
+         *
+         * Called from transaction and TOI apply commit order paths.
+         */
+        void commit_order_entered(const wsrep::gtid&);
+
+        /**
+         * Notify server state that a write set with given GTID
+         * has been released from commit order. Wakes up local
+         * wait_for_gtid() waiters for seqnos up to the GTID seqno.
+         */
+        void commit_order_left(const wsrep::gtid&);
+
         /**
          * Set encryption key
          * 
@@ -426,6 +546,14 @@ namespace wsrep
          * in the DBMS cluster, so it may be relatively heavy operation.
          * Method wait_for_gtid() should be used whenever possible.
          *
+         * Concurrent calls are coalesced: a caller which arrives while
+         * a causal read is in flight waits for the next causal read
+         * to start and complete and shares its result. As the shared
+         * causal read was started after the caller arrived, the
+         * causality guarantee is preserved. Failures are shared
+         * as well. The caller may therefore wait up to the timeout
+         * of the in flight causal read in addition to its own.
+         *
          * @param timeout Timeout in seconds
          *
          * @return Pair of GTID and result status from provider.
@@ -434,6 +562,18 @@ namespace wsrep
         std::pair<wsrep::gtid, enum wsrep::provider::status>
         causal_read(int timeout) const;
 
+        /**
+         * Return number of causal reads issued to provider.
+         */
+        size_t causal_reads_issued() const;
+
+        /**
+         * Return number of causal read calls which were served
+         * by sharing the result of causal read issued by another
+         * caller.
+         */
+        size_t causal_reads_coalesced() const;
+
         /**
          * Desynchronize the server.
          *
@@ -641,6 +781,21 @@ namespace wsrep
             , streaming_clients_()
             , streaming_appliers_()
             , streaming_appliers_recovered_()
+            , client_registry_()
+            , replay_gate_()
+            , hot_key_detector_()
+            , causal_read_mutex_()
+            , causal_read_cond_()
+            , causal_read_in_flight_()
+            , causal_reads_issued_()
+            , causal_reads_completed_()
+            , causal_reads_coalesced_()
+            , causal_read_result_(wsrep::gtid::undefined(),
+                                  wsrep::provider::success)
+            , commit_order_mutex_()
+            , committed_gtid_()
+            , commit_order_seqno_()
+            , gtid_waiters_()
             , provider_()
             , provider_factory_(wsrep::provider::make_provider)
             , name_(name)
@@ -724,6 +879,51 @@ namespace wsrep
                          wsrep::high_priority_service*> streaming_appliers_map;
         streaming_appliers_map streaming_appliers_;
         bool streaming_appliers_recovered_;
+        std::unique_ptr<wsrep::client_registry> client_registry_;
+        std::unique_ptr<wsrep::replay_gate> replay_gate_;
+        std::unique_ptr<wsrep::hot_key_detector> hot_key_detector_;
+        // Single flight state for causal_read(). Causal reads are
+        // numbered in the order they are issued, callers wait until
+        // a causal read issued after their arrival has completed.
+        mutable wsrep::default_mutex causal_read_mutex_;
+        mutable wsrep::default_condition_variable causal_read_cond_;
+        mutable bool causal_read_in_flight_;
+        mutable size_t causal_reads_issued_;
+        mutable size_t causal_reads_completed_;
+        mutable size_t causal_reads_coalesced_;
+        mutable std::pair<wsrep::gtid, enum wsrep::provider::status>
+        causal_read_result_;
+        // Local committed GTID watermark and waiters for seqnos
+        // which are in commit order. Waiters are kept in a min heap
+        // and woken up individually in seqno order.
+        struct gtid_waiter
+        {
+            explicit gtid_waiter(wsrep::seqno seqno_arg)
+                : seqno(seqno_arg), cond(), done(), satisfied()
+            { }
+            wsrep::seqno seqno;
+            wsrep::default_condition_variable cond;
+            bool done;
+            bool satisfied;
+        };
+        struct gtid_waiter_cmp
+        {
+            bool operator()(const gtid_waiter* left,
+                            const gtid_waiter* right) const
+            {
+                return (left->seqno > right->seqno);
+            }
+        };
+        void wake_gtid_waiters(wsrep::unique_lock<wsrep::mutex>&,
+                               wsrep::seqno, bool satisfied) const;
+        // Remove timed out waiter from waiter queue.
+        void remove_gtid_waiter(wsrep::unique_lock<wsrep::mutex>&,
+                                const gtid_waiter*) const;
+        mutable wsrep::default_mutex commit_order_mutex_;
+        wsrep::gtid committed_gtid_;
+        wsrep::seqno commit_order_seqno_;
+        mutable std::priority_queue<gtid_waiter*, std::vector<gtid_waiter*>,
+                                    gtid_waiter_cmp> gtid_waiters_;
         std::unique_ptr<wsrep::provider> provider_;
         provider_factory_func provider_factory_;
         std::string name_;
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file state_history.hpp
+ *
+ * Fixed size history of state transitions for debugging.
+ */
+
+#ifndef WSREP_STATE_HISTORY_HPP
+#define WSREP_STATE_HISTORY_HPP
+
+#include <cstddef>
+
+namespace wsrep
+{
+    /**
+     * Ring buffer of N most recent states. States are stored
+     * in one byte each, so the enumeration S must have less than
+     * 256 values. Does not allocate memory.
+     */
+    template <class S, size_t N>
+    class state_history
+    {
+    public:
+        state_history() : states_(), pos_(), size_() { }
+
+        void push_back(S state)
+        {
+            states_[pos_] = static_cast<unsigned char>(state);
+            pos_ = static_cast<unsigned char>((pos_ + 1) % N);
+            if (size_ < N) ++size_;
+        }
+
+        void clear() { pos_ = 0; size_ = 0; }
+
+        size_t size() const { return size_; }
+
+        /** Return i:th oldest state in the history. */
+        S operator[](size_t i) const
+        {
+            return static_cast<S>(states_[(pos_ + N - size_ + i) % N]);
+        }
+    private:
+        unsigned char states_[N];
+        unsigned char pos_;
+        unsigned char size_;
+    };
+}
+
+#endif // WSREP_STATE_HISTORY_HPP
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file streaming_applier_recovery.hpp
+ *
+ * Parallel reconstruction of streaming appliers from the
+ * fragment storage.
+ *
+ * The application implementation of
+ * wsrep::server_service::recover_streaming_appliers() scans the
+ * fragment storage for in-flight streaming transactions and
+ * passes them to streaming_applier_recovery::run(). Each
+ * transaction is reconstructed in isolation by a worker thread
+ * calling streaming_applier_recovery::recoverer::recover().
+ * Once all the workers have finished, the reconstructed appliers
+ * are registered to server state in one go.
+ */
+
+#ifndef WSREP_STREAMING_APPLIER_RECOVERY_HPP
+#define WSREP_STREAMING_APPLIER_RECOVERY_HPP
+
+#include "id.hpp"
+#include "transaction_id.hpp"
+#include "mutex.hpp"
+
+#include <vector>
+#include <cstddef>
+
+namespace wsrep
+{
+    class server_state;
+    class high_priority_service;
+    class reporter;
+
+    class streaming_applier_recovery
+    {
+    public:
+        /**
+         * Identifies a single streaming transaction to be recovered.
+         */
+        struct job
+        {
+            job(const wsrep::id& server_id_arg,
+                wsrep::transaction_id transaction_id_arg)
+                : server_id(server_id_arg)
+                , transaction_id(transaction_id_arg)
+            { }
+            wsrep::id server_id;
+            wsrep::transaction_id transaction_id;
+        };
+
+        /**
+         * Interface for reconstructing a single streaming applier.
+         */
+        class recoverer
+        {
+        public:
+            virtual ~recoverer() { }
+
+            /**
+             * Reconstruct streaming applier for the transaction
+             * identified by job. The method is called concurrently
+             * from several worker threads for distinct transactions,
+             * so the implementation must not share mutable state
+             * between calls without synchronization.
+             *
+             * The returned applier must not be registered into
+             * server state by the implementation. As the applier
+             * is constructed in a worker thread, the thread which
+             * later uses the applier must take the ownership via
+             * high_priority_service::store_globals().
+             *
+             * @return Pointer to reconstructed high priority service,
+             *         null pointer on failure.
+             */
+            virtual wsrep::high_priority_service* recover(const job&) = 0;
+        };
+
+        /**
+         * Constructor.
+         *
+         * @param server_state Server state where recovered appliers
+         *        are registered.
+         * @param n_workers Number of worker threads. Zero and one
+         *        run recovery in the calling thread.
+         * @param reporter Optional reporter for progress reporting.
+         */
+        streaming_applier_recovery(wsrep::server_state& server_state,
+                                   size_t n_workers,
+                                   wsrep::reporter* reporter);
+
+        /**
+         * Recover streaming appliers for given transactions and
+         * register successfully recovered appliers into server state
+         * after all jobs have been processed.
+         *
+         * @return Zero if all appliers were recovered, non-zero
+         *         otherwise.
+         */
+        int run(const std::vector<job>& jobs, recoverer& recoverer);
+
+        /**
+         * Return number of appliers recovered by the last call
+         * to run().
+         */
+        size_t recovered() const { return recovered_; }
+
+    private:
+        streaming_applier_recovery(const streaming_applier_recovery&);
+        streaming_applier_recovery& operator=(
+            const streaming_applier_recovery&);
+
+        void work();
+        void report_progress(size_t done);
+
+        wsrep::server_state& server_state_;
+        size_t n_workers_;
+        wsrep::reporter* reporter_;
+        wsrep::default_mutex mutex_;
+        const std::vector<job>* jobs_;
+        recoverer* recoverer_;
+        std::vector<wsrep::high_priority_service*> results_;
+        size_t next_job_;
+        size_t done_;
+        size_t reported_percent_;
+        size_t failed_;
+        size_t recovered_;
+    };
+}
+
+#endif // WSREP_STREAMING_APPLIER_RECOVERY_HPP
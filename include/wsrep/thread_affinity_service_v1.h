@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_affinity_service_v1.h
+ *
+ * Affinity extension to wsrep-API thread service v1.
+ *
+ * The wsrep_thread_service_v1_t struct cannot grow new fields, so
+ * thread affinity calls are offered to the provider through a
+ * separate service. The provider may export
+ * WSREP_THREAD_AFFINITY_SERVICE_INIT_FUNC_V1 and
+ * WSREP_THREAD_AFFINITY_SERVICE_DEINIT_FUNC_V1 to receive these
+ * callbacks in addition to thread service v1 callbacks. The service
+ * is initialized after thread service v1 and deinitialized with it.
+ *
+ * This is a C header so that providers can include it.
+ */
+
+#ifndef WSREP_THREAD_AFFINITY_SERVICE_V1_H
+#define WSREP_THREAD_AFFINITY_SERVICE_V1_H
+
+#include "v26/wsrep_thread_service.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif /* __cplusplus */
+
+/**
+ * Thread affinity service callbacks.
+ *
+ * Functions return zero on success, system error code on failure.
+ * ENOTSUP is returned if the application does not implement the call.
+ */
+typedef struct wsrep_thread_affinity_service_v1_st
+{
+    /**
+     * Set CPU affinity of a thread. The cpuset points to a cpu_set_t
+     * of cpuset_size bytes.
+     */
+    int (*thread_setaffinity)(wsrep_thread_t* thread,
+                              size_t cpuset_size, const void* cpuset);
+    /**
+     * Get CPU affinity of a thread into cpuset of cpuset_size bytes.
+     */
+    int (*thread_getaffinity)(wsrep_thread_t* thread,
+                              size_t cpuset_size, void* cpuset);
+    /**
+     * Hint the application to run the thread on the given NUMA node.
+     */
+    int (*thread_set_numa_node)(wsrep_thread_t* thread, int node);
+} wsrep_thread_affinity_service_v1_t;
+
+/**
+ * Initialize the thread affinity service.
+ *
+ * @param callbacks Callbacks provided by the application, valid
+ *        until the service is deinitialized.
+ *
+ * @return Zero on success, system error code on failure.
+ */
+typedef int (*wsrep_thread_affinity_service_v1_init_fn)(
+    wsrep_thread_affinity_service_v1_t* callbacks);
+
+/**
+ * Deinitialize the thread affinity service.
+ */
+typedef void (*wsrep_thread_affinity_service_v1_deinit_fn)(void);
+
+#define WSREP_THREAD_AFFINITY_SERVICE_INIT_FUNC_V1 \
+    "wsrep_init_thread_affinity_service_v1"
+
+#define WSREP_THREAD_AFFINITY_SERVICE_DEINIT_FUNC_V1 \
+    "wsrep_deinit_thread_affinity_service_v1"
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WSREP_THREAD_AFFINITY_SERVICE_V1_H */
@@ -32,6 +32,7 @@
 #define WSREP_THREAD_SERVICE_HPP
 
 #include <cstddef> // size_t
+#include <cerrno>  // ENOTSUP
 #include "compiler.hpp"
 
 struct timespec;
@@ -87,6 +88,50 @@ namespace wsrep
         virtual int getschedparam(thread*, int*, struct sched_param*) WSREP_NOEXCEPT
             = 0;
 
+        /**
+         * Set CPU affinity of the thread.
+         *
+         * @param cpuset_size Size of the CPU set in bytes.
+         * @param cpuset CPU set, cpu_set_t on Linux.
+         *
+         * @return Zero on success, system error code on failure.
+         *         The default implementation returns ENOTSUP.
+         */
+        virtual int setaffinity(thread*, size_t /* cpuset_size */,
+                                const void* /* cpuset */) WSREP_NOEXCEPT
+        {
+            return ENOTSUP;
+        }
+
+        /**
+         * Get CPU affinity of the thread.
+         *
+         * @param cpuset_size Size of the CPU set in bytes.
+         * @param[out] cpuset CPU set, cpu_set_t on Linux.
+         *
+         * @return Zero on success, system error code on failure.
+         *         The default implementation returns ENOTSUP.
+         */
+        virtual int getaffinity(thread*, size_t /* cpuset_size */,
+                                void* /* cpuset */) WSREP_NOEXCEPT
+        {
+            return ENOTSUP;
+        }
+
+        /**
+         * Hint that the thread should run on given NUMA node and
+         * that the memory it allocates should be placed on the same
+         * node. The application may place the thread according to its
+         * own policy. Negative node clears the hint.
+         *
+         * @return Zero on success, system error code on failure.
+         *         The default implementation returns ENOTSUP.
+         */
+        virtual int set_numa_node(thread*, int /* node */) WSREP_NOEXCEPT
+        {
+            return ENOTSUP;
+        }
+
         /* Mutex */
         virtual const mutex_key* create_mutex_key(const char* name) WSREP_NOEXCEPT
             = 0;
@@ -26,8 +26,12 @@
 #include "streaming_context.hpp"
 #include "lock.hpp"
 #include "sr_key_set.hpp"
+#include "replay_gate.hpp"
+#include "hot_key_detector.hpp"
 #include "buffer.hpp"
 #include "xid.hpp"
+#include "lazy.hpp"
+#include "state_history.hpp"
 
 #include <iosfwd>
 #include <vector>
@@ -97,7 +101,7 @@ namespace wsrep
          */
         bool is_streaming() const
         {
-            return (streaming_context_.fragments_certified() > 0);
+            return (streaming_context_.get().fragments_certified() > 0);
         }
 
         /**
@@ -119,19 +123,19 @@ namespace wsrep
          */
         bool is_empty() const
         {
-            return sr_keys_.empty();
+            return not has_keys_;
         }
 
         bool is_xa() const
         {
-            return !xid_.is_null();
+            return !xid_.get().is_null();
         }
 
         void assign_xid(const wsrep::xid& xid);
 
         const wsrep::xid& xid() const
         {
-            return xid_;
+            return xid_.get();
         }
 
         int restore_to_prepared_state(const wsrep::xid& xid);
@@ -153,7 +157,8 @@ namespace wsrep
         bool implicit_deps() const { return implicit_deps_; }
         void implicit_deps(bool implicit) { implicit_deps_ = implicit; }
 
-        int start_transaction(const wsrep::transaction_id& id);
+        int start_transaction(wsrep::unique_lock<wsrep::mutex>&,
+                              const wsrep::transaction_id& id);
 
         int start_transaction(const wsrep::ws_handle& ws_handle,
                               const wsrep::ws_meta& ws_meta);
@@ -199,12 +204,21 @@ namespace wsrep
 
         void after_applying();
 
+        /*
+         * If deferred_rollback is non-null, the victim is not handed
+         * to the background rollbacker. Instead *deferred_rollback
+         * is set to true if the background rollback is required
+         * and the caller is responsible for calling
+         * server_service::background_rollback().
+         */
         bool bf_abort(wsrep::unique_lock<wsrep::mutex>& lock,
                       wsrep::seqno bf_seqno,
-                      wsrep::client_service&);
+                      wsrep::client_service&,
+                      bool* deferred_rollback = 0);
         bool total_order_bf_abort(wsrep::unique_lock<wsrep::mutex>&,
                                   wsrep::seqno bf_seqno,
-                                  wsrep::client_service&);
+                                  wsrep::client_service&,
+                                  bool* deferred_rollback = 0);
 
         void clone_for_replay(const wsrep::transaction& other);
 
@@ -227,10 +241,27 @@ namespace wsrep
         wsrep::ws_handle& ws_handle() { return ws_handle_; }
         const wsrep::ws_handle& ws_handle() const { return ws_handle_; }
         const wsrep::ws_meta& ws_meta() const { return ws_meta_; }
+        /**
+         * Return streaming context for reading. The context of a
+         * transaction which does not use streaming is not allocated.
+         */
         const wsrep::streaming_context& streaming_context() const
-        { return streaming_context_; }
+        { return streaming_context_.get(); }
+        /**
+         * Return streaming context for modification. Allocates the
+         * context if needed, use the const streaming_context() for
+         * reading.
+         */
+        wsrep::streaming_context& mutable_streaming_context()
+        { return streaming_context_.mut(); }
+        /**
+         * Same as mutable_streaming_context(), allocates the context
+         * if needed.
+         *
+         * @deprecated Use mutable_streaming_context().
+         */
         wsrep::streaming_context& streaming_context()
-        { return streaming_context_; }
+        { return streaming_context_.mut(); }
         void adopt_apply_error(wsrep::mutable_buffer& buf)
         {
             apply_error_buf_ = std::move(buf);
@@ -254,6 +285,9 @@ namespace wsrep
         int certify_commit(wsrep::unique_lock<wsrep::mutex>&,
                            const wsrep::provider::seq_cb_t*);
         int append_sr_keys_for_commit();
+        void wait_for_replayers(wsrep::unique_lock<wsrep::mutex>&);
+        void signal_replayed();
+        void record_conflict();
         int release_commit_order(wsrep::unique_lock<wsrep::mutex>&);
         void remove_fragments_in_storage_service_scope(
             wsrep::unique_lock<wsrep::mutex>&);
@@ -261,9 +295,12 @@ namespace wsrep
         int replay(wsrep::unique_lock<wsrep::mutex>&);
         void xa_replay_common(wsrep::unique_lock<wsrep::mutex>&);
         int xa_replay_commit(wsrep::unique_lock<wsrep::mutex>&);
-        void cleanup();
+        void cleanup(wsrep::unique_lock<wsrep::mutex>&);
         void debug_log_state(const char*) const;
         void debug_log_key_append(const wsrep::key& key) const;
+        // Clean up streaming context and release it if streaming
+        // is not enabled for the client.
+        void cleanup_streaming_context();
 
         wsrep::server_service& server_service_;
         wsrep::client_service& client_service_;
@@ -271,7 +308,7 @@ namespace wsrep
         wsrep::id server_id_;
         wsrep::transaction_id id_;
         enum state state_;
-        std::vector<enum state> state_hist_;
+        wsrep::state_history<enum state, 11> state_hist_;
         enum state bf_abort_state_;
         enum wsrep::provider::status bf_abort_provider_status_;
         int bf_abort_client_state_;
@@ -282,10 +319,26 @@ namespace wsrep
         bool implicit_deps_;
         bool certified_;
         size_t fragments_certified_for_statement_;
-        wsrep::streaming_context streaming_context_;
-        wsrep::sr_key_set sr_keys_;
+        // Keys recorded for replay gating and hot key detection,
+        // if enabled in server state.
+        struct key_tracking
+        {
+            key_tracking() : replay_keys(), key_hashes(), hot_key_slots()
+            { }
+            wsrep::replay_gate::key_vector replay_keys;
+            // Key hashes and held local key locks for hot key detection.
+            std::vector<wsrep::hot_key_detector::hash_type> key_hashes;
+            std::vector<size_t> hot_key_slots;
+        };
+        // Streaming, SR keys, key tracking and XA parts are allocated
+        // only for transactions which use them.
+        wsrep::lazy<wsrep::streaming_context> streaming_context_;
+        wsrep::lazy<wsrep::sr_key_set> sr_keys_;
+        wsrep::lazy<key_tracking> key_tracking_;
+        bool replay_gate_entered_;
+        bool has_keys_;
         wsrep::mutable_buffer apply_error_buf_;
-        wsrep::xid xid_;
+        wsrep::lazy<wsrep::xid> xid_;
         bool streaming_rollback_in_progress_;
         /* This flag tells that the transaction has become immutable
            against BF aborts. Ideally this would be deduced from transaction
@@ -295,6 +348,8 @@ namespace wsrep
            too many changes to application using the lib, so boolean flag
            must do. */
         bool is_bf_immutable_;
+        /* Transaction is registered in server state client registry. */
+        bool registered_;
     };
 
     static inline const char* to_c_string(enum wsrep::transaction::state state)
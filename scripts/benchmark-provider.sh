@@ -20,6 +20,8 @@
 
 set -x
 PROVIDER=${PROVIDER:?"Provider library is required"}
+# Client state mutex implementation: default or adaptive
+CLIENT_MUTEX=${CLIENT_MUTEX:-default}
 
 total_transactions=$((1 << 17))
 
@@ -28,10 +30,10 @@ function run_benchmark()
     servers=$1
     clients=$2
     transactions=$(($total_transactions/($servers*$clients)))
-    result_file=dbms-bench-$(basename $PROVIDER)-$servers-$clients
+    result_file=dbms-bench-$(basename $PROVIDER)-$CLIENT_MUTEX-$servers-$clients
     echo "Running benchmark for servers: $servers clients $clients"
     rm -r *_data/ || :
-    command time -v ./src/dbms_simulator --servers=$servers --clients=$clients --transactions=$transactions --wsrep-provider="$PROVIDER" --fast-exit=1 >& $result_file
+    command time -v ./src/dbms_simulator --servers=$servers --clients=$clients --transactions=$transactions --wsrep-provider="$PROVIDER" --client-mutex=$CLIENT_MUTEX --fast-exit=1 >& $result_file
 }
 
 
@@ -19,22 +19,27 @@
 #
 
 PROVIDER=${PROVIDER:?"Provider library is required"}
+# Client state mutex implementation used in benchmark-provider.sh
+CLIENT_MUTEX=${CLIENT_MUTEX:-default}
 
 function report()
 {
     servers=$1
     clients=$2
-    result_file=dbms-bench-$(basename $PROVIDER)-$servers-$clients
+    result_file=dbms-bench-$(basename $PROVIDER)-$CLIENT_MUTEX-$servers-$clients
     trx_per_sec=$(grep -a "Transactions per second" "$result_file" | cut -d ':' -f 2)
     cpu=$(grep -a "Percent of CPU this job got" "$result_file" | cut -d ':' -f 2)
     vol_ctx_switches=$(grep -a "Voluntary context switches" "$result_file" | cut -d ':' -f 2)
     invol_ctx_switches=$(grep -a "Involuntary context switches" "$result_file" | cut -d ':' -f 2)
-    echo "$clients $cpu $trx_per_sec $vol_ctx_switches $invol_ctx_switches"
+    # p50/p90/p99/p99.9/max in microseconds
+    trx_latency=$(grep -a "Transaction latency usec" "$result_file" | cut -d ':' -f 2)
+    commit_latency=$(grep -a "Commit latency usec" "$result_file" | cut -d ':' -f 2)
+    echo "$clients $cpu $trx_per_sec $vol_ctx_switches $invol_ctx_switches $trx_latency $commit_latency"
 }
 
 for servers in 1 2 4 8 16
 do
-    echo "Servers: $servers"
+    echo "Servers: $servers client mutex: $CLIENT_MUTEX"
     for clients in 1 2 4 8 16 32
     do
 	report $servers $clients
@@ -0,0 +1,60 @@
+#!/bin/bash -eu
+#
+# Copyright (C) 2024 Codership Oy <info@codership.com>
+#
+# This file is part of wsrep-lib.
+#
+# Wsrep-lib is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 2 of the License, or
+# (at your option) any later version.
+#
+# Wsrep-lib is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+#
+
+# Run dbsim in open loop mode with increasing arrival rates and report
+# achieved throughput and latency percentiles for each rate. The rate
+# where latency starts to grow rapidly is the saturation point of the
+# provider and cluster configuration.
+
+WSREP_PROVIDER=${WSREP_PROVIDER:?"Provider library is required"}
+RATES=${RATES:-"1000 2000 4000 8000 16000 32000 64000"}
+SERVERS=${SERVERS:-3}
+CLIENTS=${CLIENTS:-16}
+DURATION=${DURATION:-20}
+WARMUP=${WARMUP:-5}
+
+function latency()
+{
+    # Extract percentile $2 from latency object $1 of results file $3
+    grep -a "\"$1\"" "$3" | sed -e "s/.*\"$2\": \([0-9.e+]*\).*/\1/"
+}
+
+echo "rate tps trx_p50 trx_p99 trx_p99.9 commit_p50 commit_p99"
+for rate in $RATES
+do
+    result_file=dbsim-rate-$(basename $WSREP_PROVIDER)-$SERVERS-$CLIENTS-$rate.json
+    rm -r dbsim_*_data/ >& /dev/null || :
+    ./dbsim/dbsim \
+        --servers=$SERVERS \
+        --clients=$CLIENTS \
+        --rate=$rate \
+        --duration=$DURATION \
+        --warmup=$WARMUP \
+        --results-json=$result_file \
+        --wsrep-provider=$WSREP_PROVIDER \
+        --fast-exit=1 >& $result_file.log
+    tps=$(grep -a '"transactions_per_second"' $result_file | sed -e 's/.*: \([0-9.e+]*\),/\1/')
+    echo "$rate $tps" \
+         "$(latency trx_latency_usec p50 $result_file)" \
+         "$(latency trx_latency_usec p99 $result_file)" \
+         "$(latency trx_latency_usec p99.9 $result_file)" \
+         "$(latency commit_latency_usec p50 $result_file)" \
+         "$(latency commit_latency_usec p99 $result_file)"
+done
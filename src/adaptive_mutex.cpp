@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/adaptive_mutex.hpp"
+
+#include <climits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+namespace
+{
+    inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    // Park the calling thread while *addr equals val. May return
+    // spuriously.
+    inline void park(std::atomic<int>* addr, int val)
+    {
+#if defined(__linux__)
+        (void)::syscall(SYS_futex, reinterpret_cast<int*>(addr),
+                        FUTEX_WAIT_PRIVATE, val, 0, 0, 0);
+#else
+        if (addr->load(std::memory_order_relaxed) == val) ::sched_yield();
+#endif
+    }
+
+    inline void unpark(std::atomic<int>* addr, int count)
+    {
+#if defined(__linux__)
+        (void)::syscall(SYS_futex, reinterpret_cast<int*>(addr),
+                        FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+#else
+        (void)addr;
+        (void)count;
+#endif
+    }
+}
+
+void wsrep::adaptive_mutex::lock_contended()
+{
+    for (unsigned int i(0); i < spins_; ++i)
+    {
+        cpu_relax();
+        if (state_.load(std::memory_order_relaxed) == unlocked)
+        {
+            int expected(unlocked);
+            if (state_.compare_exchange_weak(
+                    expected, locked, std::memory_order_acquire))
+            {
+                return;
+            }
+        }
+    }
+    // Mark the mutex contended so that unlock() wakes up a waiter.
+    while (state_.exchange(contended, std::memory_order_acquire) != unlocked)
+    {
+        park(&state_, contended);
+    }
+}
+
+void wsrep::adaptive_mutex::wake()
+{
+    unpark(&state_, 1);
+}
+
+void wsrep::adaptive_condition_variable::notify_one()
+{
+    seq_.fetch_add(1, std::memory_order_release);
+    unpark(&seq_, 1);
+}
+
+void wsrep::adaptive_condition_variable::notify_all()
+{
+    seq_.fetch_add(1, std::memory_order_release);
+    unpark(&seq_, INT_MAX);
+}
+
+void wsrep::adaptive_condition_variable::wait(
+    wsrep::unique_lock<wsrep::mutex>& lock)
+{
+    // Sequence is read while holding the mutex, notification after
+    // unlock changes it and park returns immediately.
+    const int seq(seq_.load(std::memory_order_acquire));
+    lock.unlock();
+    park(&seq_, seq);
+    lock.lock();
+}
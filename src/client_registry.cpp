@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/client_registry.hpp"
+#include "wsrep/compiler.hpp"
+
+#include <cassert>
+
+wsrep::client_registry::client_registry(size_t n_shards)
+    : n_shards_(n_shards ? n_shards : 1)
+    , shards_(new shard[n_shards_])
+{ }
+
+wsrep::client_registry::~client_registry()
+{
+    delete[] shards_;
+}
+
+void wsrep::client_registry::insert(wsrep::client_id client_id,
+                                    wsrep::transaction_id transaction_id,
+                                    wsrep::client_state* client_state)
+{
+    {
+        shard& s(shard_for(transaction_id.get()));
+        wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+        s.transactions[transaction_id] = client_state;
+    }
+    {
+        shard& s(shard_for(client_id.get()));
+        wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+        s.clients[client_id] = client_state;
+    }
+}
+
+void wsrep::client_registry::erase(wsrep::client_id client_id,
+                                   wsrep::transaction_id transaction_id)
+{
+    {
+        shard& s(shard_for(transaction_id.get()));
+        wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+        size_t erased WSREP_UNUSED(s.transactions.erase(transaction_id));
+        assert(erased == 1);
+    }
+    {
+        shard& s(shard_for(client_id.get()));
+        wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+        s.clients.erase(client_id);
+    }
+}
+
+wsrep::client_state* wsrep::client_registry::find(
+    wsrep::transaction_id transaction_id) const
+{
+    const shard& s(shard_for(transaction_id.get()));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    transaction_map::const_iterator i(s.transactions.find(transaction_id));
+    return (i == s.transactions.end() ? 0 : i->second);
+}
+
+wsrep::client_state* wsrep::client_registry::find(
+    wsrep::client_id client_id) const
+{
+    const shard& s(shard_for(client_id.get()));
+    wsrep::unique_lock<wsrep::mutex> lock(s.mutex);
+    client_map::const_iterator i(s.clients.find(client_id));
+    return (i == s.clients.end() ? 0 : i->second);
+}
+
+size_t wsrep::client_registry::size() const
+{
+    size_t ret(0);
+    for (size_t i(0); i < n_shards_; ++i)
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(shards_[i].mutex);
+        ret += shards_[i].transactions.size();
+    }
+    return ret;
+}
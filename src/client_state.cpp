@@ -25,6 +25,7 @@
 #include "wsrep/client_service.hpp"
 
 #include <unistd.h> // usleep()
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 #include <iostream>
@@ -41,7 +42,9 @@ wsrep::provider& wsrep::client_state::provider() const
 
 void wsrep::client_state::open(wsrep::client_id id)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    // The client state is not visible to other threads before open.
+    default_mutex_ = dynamic_cast<wsrep::default_mutex*>(&mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(state_ == s_none);
     assert(keep_command_error_ == false);
     debug_log_state("open: enter");
@@ -56,11 +59,11 @@ void wsrep::client_state::open(wsrep::client_id id)
 
 void wsrep::client_state::close()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("close: enter");
 
     while (mode_ == m_local && is_rollbacker_active()) {
-        cond_.wait(lock);
+        rollback_complete_cond_.wait(lock);
     }
     do_acquire_ownership(lock);
 
@@ -82,7 +85,7 @@ void wsrep::client_state::close()
 
 void wsrep::client_state::cleanup()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     cleanup(lock);
 }
 
@@ -107,7 +110,7 @@ void wsrep::client_state::override_error(enum wsrep::client_error error,
 
 int wsrep::client_state::before_command(bool keep_command_error)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("before_command: enter");
     // If the state is s_exec, the processing thread has already grabbed
     // control with wait_rollback_complete_and_acquire_ownership()
@@ -183,7 +186,7 @@ int wsrep::client_state::before_command(bool keep_command_error)
 
 void wsrep::client_state::after_command_before_result()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("after_command_before_result: enter");
     assert(state() == s_exec);
     if (transaction_.active() &&
@@ -207,7 +210,7 @@ void wsrep::client_state::after_command_before_result()
 
 void wsrep::client_state::after_command_after_result()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("after_command_after_result_enter");
     assert(state() == s_result);
     assert(transaction_.state() != wsrep::transaction::s_aborting);
@@ -230,7 +233,7 @@ void wsrep::client_state::after_command_after_result()
 
 int wsrep::client_state::before_statement()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("before_statement: enter");
 #if 0
     /**
@@ -257,7 +260,7 @@ int wsrep::client_state::before_statement()
 
 int wsrep::client_state::after_statement()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("after_statement: enter");
     assert(state() == s_exec);
     assert(mode() == m_local);
@@ -286,9 +289,9 @@ void wsrep::client_state::after_applying()
 
 int wsrep::client_state::start_transaction(const wsrep::transaction_id& id)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(state_ == s_exec);
-    return transaction_.start_transaction(id);
+    return transaction_.start_transaction(lock, id);
 }
 
 int wsrep::client_state::assign_read_view(const wsrep::gtid* const gtid)
@@ -330,7 +333,7 @@ int wsrep::client_state::after_row()
 {
     assert(mode_ == m_local);
     assert(state_ == s_exec);
-    return (transaction_.streaming_context().fragment_size()
+    return (transaction().streaming_context().fragment_size()
                 ? transaction_.after_row()
                 : 0);
 }
@@ -352,7 +355,7 @@ int wsrep::client_state::prepare_for_ordering(const wsrep::ws_handle& ws_handle,
 int wsrep::client_state::start_transaction(const wsrep::ws_handle& wsh,
                                            const wsrep::ws_meta& meta)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(owning_thread_id_ == wsrep::this_thread::get_id());
     assert(mode_ == m_high_priority);
     return transaction_.start_transaction(wsh, meta);
@@ -360,14 +363,14 @@ int wsrep::client_state::start_transaction(const wsrep::ws_handle& wsh,
 
 int wsrep::client_state::next_fragment(const wsrep::ws_meta& meta)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(mode_ == m_high_priority);
     return transaction_.next_fragment(meta);
 }
 
 int wsrep::client_state::before_prepare(const wsrep::provider::seq_cb_t* seq_cb)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(owning_thread_id_ == wsrep::this_thread::get_id());
     assert(state_ == s_exec);
     return transaction_.before_prepare(lock, seq_cb);
@@ -375,7 +378,7 @@ int wsrep::client_state::before_prepare(const wsrep::provider::seq_cb_t* seq_cb)
 
 int wsrep::client_state::after_prepare()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(owning_thread_id_ == wsrep::this_thread::get_id());
     assert(state_ == s_exec);
     return transaction_.after_prepare(lock);
@@ -424,18 +427,19 @@ int wsrep::client_state::after_rollback()
 
 void wsrep::client_state::sync_rollback_complete()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("sync_rollback_complete: enter");
     assert(state_ == s_idle && mode_ == m_local &&
            transaction_.state() == wsrep::transaction::s_aborted);
     set_rollbacker_active(false);
-    cond_.notify_all();
+    // Only the owning thread waits for rollback to complete.
+    notify_waiter(rollback_complete_cond_);
     debug_log_state("sync_rollback_complete: leave");
 }
 
 void wsrep::client_state::wait_rollback_complete_and_acquire_ownership()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     debug_log_state("wait_rollback_complete_and_acquire_ownership: enter");
     if (state_ == s_idle)
     {
@@ -454,7 +458,7 @@ void wsrep::client_state::streaming_params(
     size_t fragment_size)
 {
     assert(mode_ == m_local);
-    transaction_.streaming_context().params(fragment_unit, fragment_size);
+    transaction_.mutable_streaming_context().params(fragment_unit, fragment_size);
 }
 
 int wsrep::client_state::enable_streaming(
@@ -464,7 +468,7 @@ int wsrep::client_state::enable_streaming(
 {
     assert(mode_ == m_local);
     if (transaction_.is_streaming() &&
-        transaction_.streaming_context().fragment_unit() !=
+        transaction().streaming_context().fragment_unit() !=
         fragment_unit)
     {
         wsrep::log_error()
@@ -472,7 +476,7 @@ int wsrep::client_state::enable_streaming(
             << "not allowed";
         return 1;
     }
-    transaction_.streaming_context().enable(fragment_unit, fragment_size);
+    transaction_.mutable_streaming_context().enable(fragment_unit, fragment_size);
     return 0;
 }
 
@@ -480,7 +484,7 @@ void wsrep::client_state::disable_streaming()
 {
     assert(mode_ == m_local);
     assert(state_ == s_exec || state_ == s_quitting);
-    transaction_.streaming_context().disable();
+    transaction_.mutable_streaming_context().disable();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -498,7 +502,7 @@ void wsrep::client_state::xa_replay()
 {
     assert(mode_ == m_local);
     assert(state_ == s_idle);
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     transaction_.xa_replay(lock);
 }
 
@@ -518,7 +522,7 @@ int wsrep::client_state::bf_abort(wsrep::unique_lock<wsrep::mutex>& lock,
 
 int wsrep::client_state::bf_abort(wsrep::seqno bf_seqno)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     return bf_abort(lock, bf_seqno);
 }
 
@@ -534,10 +538,29 @@ int wsrep::client_state::total_order_bf_abort(
 
 int wsrep::client_state::total_order_bf_abort(wsrep::seqno bf_seqno)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     return total_order_bf_abort(lock, bf_seqno);
 }
 
+int wsrep::client_state::bf_abort_deferred(
+    wsrep::unique_lock<wsrep::mutex>& lock,
+    wsrep::seqno bf_seqno,
+    bool total_order,
+    bool& deferred_rollback)
+{
+    assert(lock.owns_lock());
+    assert(mode_ == m_local || transaction_.is_streaming());
+    deferred_rollback = false;
+    auto ret = (total_order ?
+                transaction_.total_order_bf_abort(lock, bf_seqno,
+                                                  client_service_,
+                                                  &deferred_rollback) :
+                transaction_.bf_abort(lock, bf_seqno, client_service_,
+                                      &deferred_rollback));
+    assert(lock.owns_lock());
+    return ret;
+}
+
 void wsrep::client_state::adopt_transaction(
     const wsrep::transaction& transaction)
 {
@@ -627,12 +650,12 @@ int wsrep::client_state::enter_toi_local(const wsrep::key_array& keys,
     assert(mode_ == m_local);
     int ret;
 
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
 
     bool timed_out;
     auto const status(poll_enter_toi(
                           lock, keys, buffer,
-                          toi_meta_,
+                          toi_meta_.mut(),
                           wsrep::provider::flag::start_transaction |
                           wsrep::provider::flag::commit,
                           wait_until,
@@ -666,7 +689,7 @@ int wsrep::client_state::enter_toi_local(const wsrep::key_array& keys,
 void wsrep::client_state::enter_toi_mode(const wsrep::ws_meta& ws_meta)
 {
     debug_log_state("enter_toi_mode: enter");
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(mode_ == m_high_priority);
     enter_toi_common(lock);
     toi_meta_ = ws_meta;
@@ -675,14 +698,14 @@ void wsrep::client_state::enter_toi_mode(const wsrep::ws_meta& ws_meta)
 
 void wsrep::client_state::leave_toi_common()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     mode(lock, toi_mode_);
     toi_mode_ = m_undefined;
-    if (toi_meta_.gtid().is_undefined() == false)
+    if (toi_meta_.get().gtid().is_undefined() == false)
     {
-        update_last_written_gtid(toi_meta_.gtid());
+        update_last_written_gtid(toi_meta_.get().gtid());
     }
-    toi_meta_ = wsrep::ws_meta();
+    toi_meta_.reset();
 }
 
 int wsrep::client_state::leave_toi_local(const wsrep::mutable_buffer& err)
@@ -690,7 +713,7 @@ int wsrep::client_state::leave_toi_local(const wsrep::mutable_buffer& err)
     debug_log_state("leave_toi_local: enter");
     assert(toi_mode_ == m_local);
 
-    auto ret = (provider().leave_toi(id_, toi_meta_, err) == provider::success ? 0 : 1);
+    auto ret = (provider().leave_toi(id_, toi_meta_.get(), err) == provider::success ? 0 : 1);
     leave_toi_common();
     debug_log_state("leave_toi_local: leave");
 
@@ -730,7 +753,7 @@ int wsrep::client_state::begin_rsu(int timeout)
         return 1;
     }
     wsrep::log_info() << "Provider paused at: " << pause_seqno;
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     toi_mode_ = mode_;
     mode(lock, m_rsu);
     return 0;
@@ -749,7 +772,7 @@ int wsrep::client_state::end_rsu()
         wsrep::log_warning() << "End RSU failed: " << e.what();
         ret = 1;
     }
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     mode(lock, toi_mode_);
     toi_mode_ = m_undefined;
     return ret;
@@ -766,7 +789,7 @@ int wsrep::client_state::begin_nbo_phase_one(
 {
     debug_log_state("begin_nbo_phase_one: enter");
     debug_log_keys(keys);
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     assert(state_ == s_exec);
     assert(mode_ == m_local);
     assert(toi_mode_ == m_undefined);
@@ -775,7 +798,7 @@ int wsrep::client_state::begin_nbo_phase_one(
     bool timed_out;
     auto const status(poll_enter_toi(
                           lock, keys, buffer,
-                          toi_meta_,
+                          toi_meta_.mut(),
                           wsrep::provider::flag::start_transaction,
                           wait_until,
                           timed_out));
@@ -811,8 +834,8 @@ int wsrep::client_state::end_nbo_phase_one(const wsrep::mutable_buffer& err)
     assert(mode_ == m_nbo);
     assert(in_toi());
 
-    enum wsrep::provider::status status(provider().leave_toi(id_, toi_meta_, err));
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    enum wsrep::provider::status status(provider().leave_toi(id_, toi_meta_.get(), err));
+    wsrep::client_state_lock lock(*this);
     int ret;
     switch (status)
     {
@@ -824,8 +847,8 @@ int wsrep::client_state::end_nbo_phase_one(const wsrep::mutable_buffer& err)
         ret = 1;
         break;
     }
-    nbo_meta_ = toi_meta_;
-    toi_meta_ = wsrep::ws_meta();
+    nbo_meta_.assign(toi_meta_);
+    toi_meta_.reset();
     toi_mode_ = m_undefined;
     debug_log_state("end_nbo_phase_one: leave");
     return ret;
@@ -836,7 +859,7 @@ int wsrep::client_state::enter_nbo_mode(const wsrep::ws_meta& ws_meta)
     assert(state_ == s_exec);
     assert(mode_ == m_local);
     assert(toi_mode_ == m_undefined);
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     nbo_meta_ = ws_meta;
     mode(lock, m_nbo);
     return 0;
@@ -853,7 +876,7 @@ int wsrep::client_state::begin_nbo_phase_two(
     assert(toi_mode_ == m_undefined);
     assert(!in_toi());
 
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    wsrep::client_state_lock lock(*this);
     // Note: nbo_meta_ is passed to enter_toi() as it is
     // an input param containing gtid of NBO begin.
     // Output stored in nbo_meta_ is copied to toi_meta_ for
@@ -862,7 +885,7 @@ int wsrep::client_state::begin_nbo_phase_two(
     enum wsrep::provider::status status(
         poll_enter_toi(lock, keys,
                        wsrep::const_buffer(),
-                       nbo_meta_,
+                       nbo_meta_.mut(),
                        wsrep::provider::flag::commit,
                        wait_until,
                        timed_out));
@@ -871,7 +894,7 @@ int wsrep::client_state::begin_nbo_phase_two(
     {
     case wsrep::provider::success:
         ret= 0;
-        toi_meta_ = nbo_meta_;
+        toi_meta_.assign(nbo_meta_);
         toi_mode_ = m_local;
         break;
     case wsrep::provider::error_provider_failed:
@@ -897,7 +920,7 @@ int wsrep::client_state::begin_nbo_phase_two(
     if (ret)
     {
         mode(lock, m_local);
-        nbo_meta_ = wsrep::ws_meta();
+        nbo_meta_.reset();
     }
 
     debug_log_state("begin_nbo_phase_two: leave");
@@ -912,8 +935,8 @@ int wsrep::client_state::end_nbo_phase_two(const wsrep::mutable_buffer& err)
     assert(toi_mode_ == m_local);
     assert(in_toi());
     enum wsrep::provider::status status(
-        provider().leave_toi(id_, toi_meta_, err));
-    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+        provider().leave_toi(id_, toi_meta_.get(), err));
+    wsrep::client_state_lock lock(*this);
     int ret;
     switch (status)
     {
@@ -925,9 +948,9 @@ int wsrep::client_state::end_nbo_phase_two(const wsrep::mutable_buffer& err)
         ret = 1;
         break;
     }
-    toi_meta_ = wsrep::ws_meta();
+    toi_meta_.reset();
     toi_mode_ = m_undefined;
-    nbo_meta_ = wsrep::ws_meta();
+    nbo_meta_.reset();
     mode(lock, m_local);
     debug_log_state("end_nbo_phase_two: leave");
     return ret;
@@ -957,10 +980,63 @@ int wsrep::client_state::sync_wait(int timeout)
     return ret;
 }
 
+int wsrep::client_state::retry_statement()
+{
+    assert(mode_ == m_local);
+    assert(transaction_.active() == false);
+    size_t attempt(0);
+    while (current_error_ == wsrep::e_deadlock_error &&
+           attempt < retry_policy_.max_attempts)
+    {
+        if (not client_service_.is_retryable_statement())
+        {
+            return 1;
+        }
+        ++attempt;
+        ::usleep(static_cast<useconds_t>(retry_backoff(attempt)));
+        WSREP_LOG_DEBUG(debug_log_level(),
+                        wsrep::log::debug_level_client_state,
+                        "Retrying statement, attempt " << attempt);
+        reset_error();
+        if (client_service_.reexecute_statement())
+        {
+            // Not retryable, restore the original error.
+            override_error(wsrep::e_deadlock_error);
+            return 1;
+        }
+        ++statement_retries_;
+        if (current_error_ == wsrep::e_success)
+        {
+            ++statement_retry_successes_;
+            return 0;
+        }
+    }
+    return 1;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                               Private                                     //
 ///////////////////////////////////////////////////////////////////////////////
 
+unsigned long wsrep::client_state::retry_backoff(size_t attempt)
+{
+    unsigned long backoff(retry_policy_.backoff_min_us);
+    for (size_t i(1); i < attempt && backoff < retry_policy_.backoff_max_us;
+         ++i)
+    {
+        backoff <<= 1;
+    }
+    backoff = std::min(backoff, retry_policy_.backoff_max_us);
+    // Randomize between half and full backoff so that clients which
+    // conflicted with each other do not retry at the same time.
+    retry_seed_ ^= retry_seed_ << 13;
+    retry_seed_ ^= retry_seed_ >> 7;
+    retry_seed_ ^= retry_seed_ << 17;
+    const unsigned long half(backoff / 2);
+    return half + (half ? static_cast<unsigned long>(
+                       retry_seed_ % (backoff - half + 1)) : backoff);
+}
+
 void wsrep::client_state::do_acquire_ownership(
     wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED)
 {
@@ -974,6 +1050,19 @@ void wsrep::client_state::do_acquire_ownership(
     owning_thread_id_ = wsrep::this_thread::get_id();
 }
 
+void wsrep::client_state::notify_waiter(wsrep::condition_variable& channel)
+{
+    if (&channel == &cond_ ||
+        &rollback_complete_cond_ == &streaming_rollback_cond_)
+    {
+        channel.notify_all();
+    }
+    else
+    {
+        channel.notify_one();
+    }
+}
+
 void wsrep::client_state::do_wait_rollback_complete_and_acquire_ownership(
     wsrep::unique_lock<wsrep::mutex>& lock)
 {
@@ -981,7 +1070,7 @@ void wsrep::client_state::do_wait_rollback_complete_and_acquire_ownership(
     assert(state_ == s_idle);
     while (is_rollbacker_active())
     {
-        cond_.wait(lock);
+        rollback_complete_cond_.wait(lock);
     }
     do_acquire_ownership(lock);
     state(lock, s_exec);
@@ -1005,8 +1094,8 @@ void wsrep::client_state::debug_log_state(const char* context) const
                     << "," << to_c_string(mode_)
                     << "," << wsrep::to_string(current_error_)
                     << "," << current_error_status_
-                    << ",toi: " << toi_meta_.seqno()
-                    << ",nbo: " << nbo_meta_.seqno() << ")");
+                    << ",toi: " << toi_meta_.get().seqno()
+                    << ",nbo: " << nbo_meta_.get().seqno() << ")");
 }
 
 void wsrep::client_state::debug_log_keys(const wsrep::key_array& keys) const
@@ -1048,11 +1137,6 @@ void wsrep::client_state::state(
     state_hist_.push_back(state_);
     state_ = state;
     client_service_.notify_state_change();
-    if (state_hist_.size() > 10)
-    {
-        state_hist_.erase(state_hist_.begin());
-    }
-
 }
 
 void wsrep::client_state::mode(
@@ -1088,13 +1172,13 @@ wsrep::high_priority_context::high_priority_context(wsrep::client_state& client)
     : client_(client)
     , orig_mode_(client.mode_)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client.mutex_);
+    wsrep::client_state_lock lock(client);
     client.mode(lock, wsrep::client_state::m_high_priority);
 }
 
 wsrep::high_priority_context::~high_priority_context()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_.mutex_);
+    wsrep::client_state_lock lock(client_);
     assert(client_.mode() == wsrep::client_state::m_high_priority);
     client_.mode(lock, orig_mode_);
 }
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/hot_key_detector.hpp"
+#include "wsrep/key.hpp"
+#include "wsrep/compiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <ctime> // clock_gettime()
+
+wsrep::hot_key_detector::hot_key_detector(unsigned int threshold,
+                                          bool serialize,
+                                          size_t decay_interval)
+    : mutex_()
+    , cond_()
+    , threshold_(threshold ? threshold : 1)
+    , serialize_(serialize)
+    , decay_interval_(decay_interval ? decay_interval : 1)
+    , counters_(depth_ * width_)
+    , slots_(n_slots_)
+    , waiters_()
+    , since_decay_()
+    , conflicts_()
+    , serialized_()
+    , lock_waits_()
+{ }
+
+wsrep::hot_key_detector::hash_type
+wsrep::hot_key_detector::hash(const wsrep::key& key)
+{
+    // FNV-1a over key parts, part lengths included to separate
+    // part boundaries.
+    hash_type ret(14695981039346656037ULL);
+    for (size_t i(0); i < key.size(); ++i)
+    {
+        const unsigned char* ptr(
+            reinterpret_cast<const unsigned char*>(key.key_parts()[i].data()));
+        const size_t len(key.key_parts()[i].size());
+        ret = (ret ^ len) * 1099511628211ULL;
+        for (size_t j(0); j < len; ++j)
+        {
+            ret = (ret ^ ptr[j]) * 1099511628211ULL;
+        }
+    }
+    return ret;
+}
+
+void wsrep::hot_key_detector::record_conflict(
+    const std::vector<hash_type>& keys)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    ++conflicts_;
+    for (std::vector<hash_type>::const_iterator i(keys.begin());
+         i != keys.end(); ++i)
+    {
+        for (size_t row(0); row < depth_; ++row)
+        {
+            unsigned int& counter(counters_[cell(row, *i)]);
+            if (counter < threshold_ * 2) ++counter;
+        }
+    }
+    if (++since_decay_ >= decay_interval_)
+    {
+        for (std::vector<unsigned int>::iterator i(counters_.begin());
+             i != counters_.end(); ++i)
+        {
+            *i >>= 1;
+        }
+        since_decay_ = 0;
+    }
+}
+
+unsigned int wsrep::hot_key_detector::estimate(hash_type key) const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return estimate(lock, key);
+}
+
+bool wsrep::hot_key_detector::is_hot(hash_type key) const
+{
+    return (estimate(key) >= threshold_);
+}
+
+bool wsrep::hot_key_detector::lock(
+    const std::vector<hash_type>& keys,
+    std::vector<size_t>& slots,
+    const wsrep::transaction& waiter,
+    wsrep::unique_lock<wsrep::mutex>& client_lock,
+    int timeout)
+{
+    assert(client_lock.owns_lock());
+    assert(slots.empty());
+    if (not serialize_ || keys.empty()) return true;
+
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    std::vector<size_t> hot;
+    for (std::vector<hash_type>::const_iterator i(keys.begin());
+         i != keys.end(); ++i)
+    {
+        if (estimate(lock, *i) >= threshold_)
+        {
+            hot.push_back(static_cast<size_t>(*i % n_slots_));
+        }
+    }
+    if (hot.empty()) return true;
+
+    std::sort(hot.begin(), hot.end());
+    hot.erase(std::unique(hot.begin(), hot.end()), hot.end());
+    // Waiter is registered before the client state lock is released,
+    // so that BF abort cannot be missed.
+    std::map<const wsrep::transaction*, bool>::iterator w(
+        waiters_.insert(std::make_pair(&waiter, false)).first);
+    client_lock.unlock();
+    struct timespec deadline;
+    ::clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout;
+    bool ret(true);
+    bool waited(false);
+    for (std::vector<size_t>::const_iterator i(hot.begin());
+         ret && i != hot.end(); ++i)
+    {
+        while (slots_[*i])
+        {
+            waited = true;
+            if (w->second || not cond_.wait_until(lock, deadline))
+            {
+                ret = false;
+                break;
+            }
+        }
+        if (ret)
+        {
+            slots_[*i] = true;
+            slots.push_back(*i);
+        }
+    }
+    if (ret)
+    {
+        ++serialized_;
+        if (waited) ++lock_waits_;
+    }
+    else
+    {
+        for (std::vector<size_t>::const_iterator i(slots.begin());
+             i != slots.end(); ++i)
+        {
+            slots_[*i] = false;
+        }
+        slots.clear();
+        cond_.notify_all();
+    }
+    waiters_.erase(w);
+    lock.unlock();
+    client_lock.lock();
+    return ret;
+}
+
+void wsrep::hot_key_detector::interrupt(const wsrep::transaction& waiter)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    std::map<const wsrep::transaction*, bool>::iterator i(
+        waiters_.find(&waiter));
+    if (i != waiters_.end())
+    {
+        i->second = true;
+        cond_.notify_all();
+    }
+}
+
+void wsrep::hot_key_detector::unlock(std::vector<size_t>& slots)
+{
+    if (slots.empty()) return;
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    for (std::vector<size_t>::const_iterator i(slots.begin());
+         i != slots.end(); ++i)
+    {
+        assert(slots_[*i]);
+        slots_[*i] = false;
+    }
+    slots.clear();
+    cond_.notify_all();
+}
+
+size_t wsrep::hot_key_detector::conflicts() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return conflicts_;
+}
+
+size_t wsrep::hot_key_detector::serialized() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return serialized_;
+}
+
+size_t wsrep::hot_key_detector::lock_waits() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return lock_waits_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                              Private                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+size_t wsrep::hot_key_detector::cell(size_t row, hash_type key) const
+{
+    // Derive independent row hashes from the key hash.
+    hash_type h(key + 0x9e3779b97f4a7c15ULL * (row + 1));
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return row * width_ + static_cast<size_t>(h % width_);
+}
+
+unsigned int wsrep::hot_key_detector::estimate(
+    wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED, hash_type key) const
+{
+    assert(lock.owns_lock());
+    unsigned int ret(counters_[cell(0, key)]);
+    for (size_t row(1); row < depth_; ++row)
+    {
+        ret = std::min(ret, counters_[cell(row, key)]);
+    }
+    return ret;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/replay_gate.hpp"
+#include "wsrep/key.hpp"
+#include "wsrep/compiler.hpp"
+
+#include <cassert>
+#include <ctime> // clock_gettime()
+
+wsrep::replay_gate::replay_gate()
+    : mutex_()
+    , cond_()
+    , keys_()
+    , waiters_()
+    , replayers_()
+    , waits_()
+{ }
+
+std::string wsrep::replay_gate::encode(const wsrep::key& key)
+{
+    std::string ret;
+    for (size_t i(0); i < key.size(); ++i)
+    {
+        // Length prefix makes the encoding prefix free on part
+        // boundaries.
+        const size_t len(key.key_parts()[i].size());
+        ret.append(1, static_cast<char>(len >> 24));
+        ret.append(1, static_cast<char>(len >> 16));
+        ret.append(1, static_cast<char>(len >> 8));
+        ret.append(1, static_cast<char>(len));
+        ret.append(static_cast<const char*>(key.key_parts()[i].data()), len);
+    }
+    return ret;
+}
+
+void wsrep::replay_gate::enter(const key_vector& keys)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    keys_.insert(keys.begin(), keys.end());
+    ++replayers_;
+}
+
+void wsrep::replay_gate::leave(const key_vector& keys)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    for (key_vector::const_iterator i(keys.begin()); i != keys.end(); ++i)
+    {
+        std::multiset<std::string>::iterator found(keys_.find(*i));
+        assert(found != keys_.end());
+        if (found != keys_.end())
+        {
+            keys_.erase(found);
+        }
+    }
+    assert(replayers_ > 0);
+    --replayers_;
+    cond_.notify_all();
+}
+
+bool wsrep::replay_gate::wait(const key_vector& keys,
+                              const wsrep::transaction& waiter,
+                              wsrep::unique_lock<wsrep::mutex>& client_lock,
+                              int timeout)
+{
+    assert(client_lock.owns_lock());
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    if (not conflicts(lock, keys))
+    {
+        return true;
+    }
+    ++waits_;
+    // Waiter is registered before the client state lock is released,
+    // so that BF abort cannot be missed.
+    std::map<const wsrep::transaction*, bool>::iterator i(
+        waiters_.insert(std::make_pair(&waiter, false)).first);
+    client_lock.unlock();
+    struct timespec deadline;
+    ::clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout;
+    bool ret(true);
+    while (conflicts(lock, keys))
+    {
+        if (i->second || not cond_.wait_until(lock, deadline))
+        {
+            ret = false;
+            break;
+        }
+    }
+    waiters_.erase(i);
+    lock.unlock();
+    client_lock.lock();
+    return ret;
+}
+
+void wsrep::replay_gate::interrupt(const wsrep::transaction& waiter)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    std::map<const wsrep::transaction*, bool>::iterator i(
+        waiters_.find(&waiter));
+    if (i != waiters_.end())
+    {
+        i->second = true;
+        cond_.notify_all();
+    }
+}
+
+bool wsrep::replay_gate::conflicts(const key_vector& keys) const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return conflicts(lock, keys);
+}
+
+size_t wsrep::replay_gate::replayers() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return replayers_;
+}
+
+size_t wsrep::replay_gate::waits() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    return waits_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                              Private                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+bool wsrep::replay_gate::conflicts(
+    wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED,
+    const key_vector& keys) const
+{
+    assert(lock.owns_lock());
+    if (keys_.empty())
+    {
+        return false;
+    }
+    for (key_vector::const_iterator i(keys.begin()); i != keys.end(); ++i)
+    {
+        const std::string& key(*i);
+        // Replaying key equal to or more specific than the key.
+        std::multiset<std::string>::const_iterator lb(keys_.lower_bound(key));
+        if (lb != keys_.end() && lb->compare(0, key.size(), key) == 0)
+        {
+            return true;
+        }
+        // Replaying key less specific than the key.
+        size_t pos(0);
+        while (pos < key.size())
+        {
+            const size_t len(
+                (size_t(static_cast<unsigned char>(key[pos])) << 24) |
+                (size_t(static_cast<unsigned char>(key[pos + 1])) << 16) |
+                (size_t(static_cast<unsigned char>(key[pos + 2])) << 8) |
+                size_t(static_cast<unsigned char>(key[pos + 3])));
+            pos += 4 + len;
+            if (pos < key.size() && keys_.count(key.substr(0, pos)))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
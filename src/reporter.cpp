@@ -34,9 +34,11 @@
 
 static std::string const TEMP_EXTENSION(".XXXXXX");
 
-static std::string make_progress_string(int const from, int const to,
-                                        int const total,int const done,
-                                        int const indefinite)
+std::string wsrep::reporter::make_progress_string(int const from,
+                                                  int const to,
+                                                  int const total,
+                                                  int const done,
+                                                  int const indefinite)
 {
     std::ostringstream os;
 
@@ -50,9 +52,9 @@ static std::string make_progress_string(int const from, int const to,
 }
 
 static std::string const indefinite_progress
-    (make_progress_string(-1, -1, -1, -1, -1));
+    (wsrep::reporter::make_progress_string(-1, -1, -1, -1, -1));
 static std::string const steady_state
-    (make_progress_string(-1, -1, 0, 0, -1));
+    (wsrep::reporter::make_progress_string(-1, -1, 0, 0, -1));
 
 static inline double
 timestamp()
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/server_service.hpp"
+#include "wsrep/client_state.hpp"
+
+void wsrep::server_service::background_rollback_batch(
+    const std::vector<wsrep::client_state*>& victims)
+{
+    for (std::vector<wsrep::client_state*>::const_iterator i(victims.begin());
+         i != victims.end(); ++i)
+    {
+        wsrep::unique_lock<wsrep::mutex> lock((*i)->mutex());
+        background_rollback(lock, **i);
+    }
+}
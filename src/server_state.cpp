@@ -31,6 +31,8 @@
 #include <cassert>
 #include <sstream>
 #include <algorithm>
+#include <vector>
+#include <ctime> // clock_gettime()
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -466,7 +468,8 @@ static int apply_write_set(wsrep::server_state& server_state,
     return ret;
 }
 
-static int apply_toi(wsrep::provider& provider,
+static int apply_toi(wsrep::server_state& server_state,
+                     wsrep::provider& provider,
                      wsrep::high_priority_service& high_priority_service,
                      const wsrep::ws_handle& ws_handle,
                      const wsrep::ws_meta& ws_meta,
@@ -479,17 +482,21 @@ static int apply_toi(wsrep::provider& provider,
         // Regular TOI.
         //
         provider.commit_order_enter(ws_handle, ws_meta);
+        server_state.commit_order_entered(ws_meta.gtid());
         wsrep::mutable_buffer err;
         int const apply_err(high_priority_service.apply_toi(ws_meta,data,err));
         int const vote_err(provider.commit_order_leave(ws_handle, ws_meta,err));
+        server_state.commit_order_left(ws_meta.gtid());
         return resolve_return_error(err.size() > 0, vote_err, apply_err);
     }
     else if (wsrep::starts_transaction(ws_meta.flags()))
     {
         provider.commit_order_enter(ws_handle, ws_meta);
+        server_state.commit_order_entered(ws_meta.gtid());
         wsrep::mutable_buffer err;
         int const apply_err(high_priority_service.apply_nbo_begin(ws_meta, data, err));
         int const vote_err(provider.commit_order_leave(ws_handle, ws_meta, err));
+        server_state.commit_order_left(ws_meta.gtid());
         return resolve_return_error(err.size() > 0, vote_err, apply_err);
     }
     else if (wsrep::commits_transaction(ws_meta.flags()))
@@ -497,8 +504,10 @@ static int apply_toi(wsrep::provider& provider,
         // NBO end event is ignored here, both local and applied
         // have NBO end handled via local TOI calls.
         provider.commit_order_enter(ws_handle, ws_meta);
+        server_state.commit_order_entered(ws_meta.gtid());
         wsrep::mutable_buffer err;
         provider.commit_order_leave(ws_handle, ws_meta, err);
+        server_state.commit_order_left(ws_meta.gtid());
         return 0;
     }
     else
@@ -851,9 +860,86 @@ enum wsrep::provider::status
 wsrep::server_state::wait_for_gtid(const wsrep::gtid& gtid, int timeout)
     const
 {
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(commit_order_mutex_);
+        if (committed_gtid_.id().is_undefined() == false &&
+            gtid.id() == committed_gtid_.id())
+        {
+            if (gtid.seqno() <= committed_gtid_.seqno())
+            {
+                return wsrep::provider::success;
+            }
+            // The write set is in commit order and commit order leave
+            // will follow, wait for it locally. Negative timeout
+            // selects provider default timeout, leave it to provider.
+            if (gtid.seqno() <= commit_order_seqno_ && timeout >= 0)
+            {
+                struct timespec deadline;
+                ::clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_sec += timeout;
+                gtid_waiter waiter(gtid.seqno());
+                gtid_waiters_.push(&waiter);
+                while (not waiter.done)
+                {
+                    if (not waiter.cond.wait_until(lock, deadline))
+                    {
+                        remove_gtid_waiter(lock, &waiter);
+                        break;
+                    }
+                }
+                if (not waiter.done)
+                {
+                    return wsrep::provider::error_transaction_missing;
+                }
+                if (waiter.satisfied)
+                {
+                    return wsrep::provider::success;
+                }
+            }
+        }
+    }
     return provider().wait_for_gtid(gtid, timeout);
 }
 
+wsrep::gtid wsrep::server_state::committed_gtid() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(commit_order_mutex_);
+    return committed_gtid_;
+}
+
+void wsrep::server_state::commit_order_entered(const wsrep::gtid& gtid)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(commit_order_mutex_);
+    if (gtid.id() != committed_gtid_.id())
+    {
+        // New history, waiters for the old one must go to provider.
+        wake_gtid_waiters(lock, wsrep::seqno::undefined(), false);
+        committed_gtid_ = wsrep::gtid(gtid.id(), wsrep::seqno::undefined());
+        commit_order_seqno_ = wsrep::seqno::undefined();
+    }
+    if (gtid.seqno() > commit_order_seqno_)
+    {
+        commit_order_seqno_ = gtid.seqno();
+    }
+    const wsrep::seqno preceding(gtid.seqno().get() - 1);
+    if (preceding > committed_gtid_.seqno())
+    {
+        committed_gtid_ = wsrep::gtid(gtid.id(), preceding);
+        wake_gtid_waiters(lock, preceding, true);
+    }
+}
+
+void wsrep::server_state::commit_order_left(const wsrep::gtid& gtid)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(commit_order_mutex_);
+    if (gtid.id() == committed_gtid_.id() &&
+        gtid.seqno() > committed_gtid_.seqno())
+    {
+        committed_gtid_ = gtid;
+        wake_gtid_waiters(lock, gtid.seqno(), true);
+    }
+}
+
 int 
 wsrep::server_state::set_encryption_key(std::vector<unsigned char>& key)
 {
@@ -876,7 +962,54 @@ wsrep::server_state::set_encryption_key(std::vector<unsigned char>& key)
 std::pair<wsrep::gtid, enum wsrep::provider::status>
 wsrep::server_state::causal_read(int timeout) const
 {
-    return provider().causal_read(timeout);
+    wsrep::unique_lock<wsrep::mutex> lock(causal_read_mutex_);
+    // The result of the first causal read issued after this point
+    // is good enough for this caller.
+    const size_t target(causal_reads_issued_ + 1);
+    while (causal_reads_completed_ < target)
+    {
+        if (causal_read_in_flight_)
+        {
+            causal_read_cond_.wait(lock);
+            continue;
+        }
+        causal_read_in_flight_ = true;
+        const size_t issued(++causal_reads_issued_);
+        lock.unlock();
+        std::pair<wsrep::gtid, enum wsrep::provider::status> result(
+            wsrep::gtid::undefined(), wsrep::provider::error_unknown);
+        try
+        {
+            result = provider().causal_read(timeout);
+        }
+        catch (...)
+        {
+            lock.lock();
+            causal_read_in_flight_ = false;
+            causal_read_cond_.notify_all();
+            throw;
+        }
+        lock.lock();
+        causal_read_result_ = result;
+        causal_reads_completed_ = issued;
+        causal_read_in_flight_ = false;
+        causal_read_cond_.notify_all();
+        return result;
+    }
+    ++causal_reads_coalesced_;
+    return causal_read_result_;
+}
+
+size_t wsrep::server_state::causal_reads_issued() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(causal_read_mutex_);
+    return causal_reads_issued_;
+}
+
+size_t wsrep::server_state::causal_reads_coalesced() const
+{
+    wsrep::unique_lock<wsrep::mutex> lock(causal_read_mutex_);
+    return causal_reads_coalesced_;
 }
 
 void wsrep::server_state::on_connect(const wsrep::view& view)
@@ -1132,7 +1265,7 @@ int wsrep::server_state::on_apply(
 {
     if (is_toi(ws_meta.flags()))
     {
-        return apply_toi(provider(), high_priority_service,
+        return apply_toi(*this, provider(), high_priority_service,
                          ws_handle, ws_meta, data);
     }
     else if (is_commutative(ws_meta.flags()) || is_native(ws_meta.flags()))
@@ -1257,6 +1390,40 @@ void wsrep::server_state::stop_streaming_client(
     }
 }
 
+size_t wsrep::server_state::bf_abort(
+    const std::vector<wsrep::client_state*>& victims,
+    wsrep::seqno bf_seqno,
+    bool total_order)
+{
+    size_t ret(0);
+    std::vector<wsrep::client_state*> rollback_batch;
+    for (std::vector<wsrep::client_state*>::const_iterator i(victims.begin());
+         i != victims.end(); ++i)
+    {
+        wsrep::unique_lock<wsrep::mutex> lock((*i)->mutex());
+        bool deferred_rollback(false);
+        if ((*i)->bf_abort_deferred(lock, bf_seqno, total_order,
+                                    deferred_rollback))
+        {
+            ++ret;
+        }
+        if (deferred_rollback)
+        {
+            rollback_batch.push_back(*i);
+        }
+    }
+    WSREP_LOG_DEBUG(wsrep::log::debug_log_level(),
+                    wsrep::log::debug_level_server_state,
+                    "Bulk BF abort by " << bf_seqno << ": "
+                    << ret << "/" << victims.size() << " aborted, "
+                    << rollback_batch.size() << " to background rollback");
+    if (not rollback_batch.empty())
+    {
+        server_service_.background_rollback_batch(rollback_batch);
+    }
+    return ret;
+}
+
 void wsrep::server_state::start_streaming_applier(
     const wsrep::id& server_id,
     const wsrep::transaction_id& transaction_id,
@@ -1323,6 +1490,44 @@ wsrep::high_priority_service* wsrep::server_state::find_streaming_applier(
 //                              Private                                     //
 //////////////////////////////////////////////////////////////////////////////
 
+void wsrep::server_state::wake_gtid_waiters(
+    wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED,
+    wsrep::seqno seqno, bool satisfied) const
+{
+    assert(lock.owns_lock());
+    // Undefined seqno wakes up all the waiters.
+    while (not gtid_waiters_.empty() &&
+           (seqno.is_undefined() || gtid_waiters_.top()->seqno <= seqno))
+    {
+        gtid_waiter* waiter(gtid_waiters_.top());
+        gtid_waiters_.pop();
+        waiter->done = true;
+        waiter->satisfied = satisfied;
+        waiter->cond.notify_one();
+    }
+}
+
+void wsrep::server_state::remove_gtid_waiter(
+    wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED,
+    const gtid_waiter* waiter) const
+{
+    assert(lock.owns_lock());
+    std::vector<gtid_waiter*> waiters;
+    while (not gtid_waiters_.empty())
+    {
+        if (gtid_waiters_.top() != waiter)
+        {
+            waiters.push_back(gtid_waiters_.top());
+        }
+        gtid_waiters_.pop();
+    }
+    for (std::vector<gtid_waiter*>::const_iterator i(waiters.begin());
+         i != waiters.end(); ++i)
+    {
+        gtid_waiters_.push(*i);
+    }
+}
+
 int wsrep::server_state::desync(wsrep::unique_lock<wsrep::mutex>& lock)
 {
     assert(lock.owns_lock());
@@ -1460,19 +1665,24 @@ void wsrep::server_state::recover_streaming_appliers_if_not_recovered(
     streaming_appliers_recovered_ = true;
 }
 
-class transaction_state_cmp
+namespace
 {
-public:
-    transaction_state_cmp(const enum wsrep::transaction::state s)
-        : state_(s) { }
-    bool operator()(const std::pair<wsrep::client_id,
-                    wsrep::client_state*>& vt) const
-    {
-        return vt.second->transaction().state() == state_;
-    }
-private:
-    enum wsrep::transaction::state state_;
-};
+    // Orphaned streaming applier collected for rollback in
+    // close_orphaned_sr_transactions().
+    struct orphaned_streaming_applier
+    {
+        orphaned_streaming_applier(const wsrep::id& server_id_arg,
+                                   wsrep::transaction_id transaction_id_arg,
+                                   wsrep::high_priority_service* applier_arg)
+            : server_id(server_id_arg)
+            , transaction_id(transaction_id_arg)
+            , applier(applier_arg)
+        { }
+        wsrep::id server_id;
+        wsrep::transaction_id transaction_id;
+        wsrep::high_priority_service* applier;
+    };
+}
 
 void wsrep::server_state::close_orphaned_sr_transactions(
     wsrep::unique_lock<wsrep::mutex>& lock,
@@ -1498,16 +1708,38 @@ void wsrep::server_state::close_orphaned_sr_transactions(
 
     if (current_view_.own_index() == -1 || equal_consecutive_views)
     {
-        streaming_clients_map::iterator i;
-        transaction_state_cmp prepared_state_cmp(wsrep::transaction::s_prepared);
-        while ((i = std::find_if_not(streaming_clients_.begin(),
-                                     streaming_clients_.end(),
-                                     prepared_state_cmp))
-               != streaming_clients_.end())
+        // Collect victims in one pass. Transactions in prepared state
+        // must be committed or rolled back explicitly, those are never
+        // rolled back here.
+        std::vector<std::pair<wsrep::client_id, wsrep::transaction_id> >
+            victims;
+        victims.reserve(streaming_clients_.size());
+        for (streaming_clients_map::const_iterator i(
+                 streaming_clients_.begin());
+             i != streaming_clients_.end(); ++i)
+        {
+            if (i->second->transaction().state() !=
+                wsrep::transaction::s_prepared)
+            {
+                victims.push_back(
+                    std::make_pair(i->first, i->second->transaction().id()));
+            }
+        }
+
+        // BF abort all victims first so that rollbacks may proceed
+        // concurrently, then wait until all of them are gone.
+        for (size_t v(0); v < victims.size(); ++v)
         {
-            wsrep::client_id client_id(i->first);
-            wsrep::transaction_id transaction_id(i->second->transaction().id());
-            auto& client_state = *i->second;
+            // The victim may have gone away while the lock was
+            // released for the previous victim.
+            streaming_clients_map::const_iterator i(
+                streaming_clients_.find(victims[v].first));
+            if (i == streaming_clients_.end() ||
+                i->second->transaction().id() != victims[v].second)
+            {
+                continue;
+            }
+            wsrep::client_state& client_state(*i->second);
             // It is safe to unlock the server state temporarily here.
             // The processing happens inside view handler which is
             // protected by the provider commit ordering critical
@@ -1520,16 +1752,25 @@ void wsrep::server_state::close_orphaned_sr_transactions(
             lock.unlock();
             client_state.total_order_bf_abort(current_view_.view_seqno());
             lock.lock();
+        }
+
+        for (size_t v(0); v < victims.size(); ++v)
+        {
             streaming_clients_map::const_iterator found_i;
-            while ((found_i = streaming_clients_.find(client_id)) !=
+            while ((found_i = streaming_clients_.find(victims[v].first)) !=
                    streaming_clients_.end() &&
-                   found_i->second->transaction().id() == transaction_id)
+                   found_i->second->transaction().id() == victims[v].second)
             {
                 cond_.wait(lock);
             }
         }
     }
 
+    // Collect orphaned streaming appliers in one pass and remove them
+    // from the map while holding the lock. After that the appliers are
+    // not reachable by other threads and the lock can be released for
+    // the whole batch.
+    std::vector<orphaned_streaming_applier> orphans;
     streaming_appliers_map::iterator i(streaming_appliers_.begin());
     while (i != streaming_appliers_.end())
     {
@@ -1545,52 +1786,64 @@ void wsrep::server_state::close_orphaned_sr_transactions(
              not current_view_.is_member(
                  streaming_applier->transaction().server_id())))
         {
-            WSREP_LOG_DEBUG(wsrep::log::debug_log_level(),
-                            wsrep::log::debug_level_server_state,
-                            "Removing SR fragments for "
-                            << i->first.first
-                            << ", " << i->first.second);
-            wsrep::id server_id(i->first.first);
-            wsrep::transaction_id transaction_id(i->first.second);
-            int adopt_error;
-            if ((adopt_error = high_priority_service.adopt_transaction(
-                     streaming_applier->transaction())))
-            {
-                log_adopt_error(streaming_applier->transaction());
-            }
-            // Even if the transaction adopt above fails, we roll back
-            // the transaction. Adopt error will leave stale entries
-            // in the streaming log which can be removed manually.
-            {
-                wsrep::high_priority_switch sw(high_priority_service,
-                                               *streaming_applier);
-                streaming_applier->rollback(
-                    wsrep::ws_handle(), wsrep::ws_meta());
-                streaming_applier->after_apply();
-            }
-
+            orphans.push_back(orphaned_streaming_applier(
+                                  i->first.first, i->first.second,
+                                  streaming_applier));
             streaming_appliers_.erase(i++);
-            server_service_.release_high_priority_service(streaming_applier);
-            high_priority_service.store_globals();
-            wsrep::ws_meta ws_meta(
-                wsrep::gtid(),
-                wsrep::stid(server_id, transaction_id, wsrep::client_id()),
-                wsrep::seqno::undefined(), 0);
-            lock.unlock();
-            if (adopt_error == 0)
-            {
-                high_priority_service.remove_fragments(ws_meta);
-                high_priority_service.commit(wsrep::ws_handle(transaction_id, 0),
-                                             ws_meta);
-            }
-            high_priority_service.after_apply();
-            lock.lock();
         }
         else
         {
             ++i;
         }
     }
+
+    if (orphans.empty())
+    {
+        return;
+    }
+
+    lock.unlock();
+    for (std::vector<orphaned_streaming_applier>::const_iterator
+             o(orphans.begin()); o != orphans.end(); ++o)
+    {
+        wsrep::high_priority_service* streaming_applier(o->applier);
+        WSREP_LOG_DEBUG(wsrep::log::debug_log_level(),
+                        wsrep::log::debug_level_server_state,
+                        "Removing SR fragments for "
+                        << o->server_id
+                        << ", " << o->transaction_id);
+        int adopt_error;
+        if ((adopt_error = high_priority_service.adopt_transaction(
+                 streaming_applier->transaction())))
+        {
+            log_adopt_error(streaming_applier->transaction());
+        }
+        // Even if the transaction adopt above fails, we roll back
+        // the transaction. Adopt error will leave stale entries
+        // in the streaming log which can be removed manually.
+        {
+            wsrep::high_priority_switch sw(high_priority_service,
+                                           *streaming_applier);
+            streaming_applier->rollback(
+                wsrep::ws_handle(), wsrep::ws_meta());
+            streaming_applier->after_apply();
+        }
+
+        server_service_.release_high_priority_service(streaming_applier);
+        high_priority_service.store_globals();
+        wsrep::ws_meta ws_meta(
+            wsrep::gtid(),
+            wsrep::stid(o->server_id, o->transaction_id, wsrep::client_id()),
+            wsrep::seqno::undefined(), 0);
+        if (adopt_error == 0)
+        {
+            high_priority_service.remove_fragments(ws_meta);
+            high_priority_service.commit(
+                wsrep::ws_handle(o->transaction_id, 0), ws_meta);
+        }
+        high_priority_service.after_apply();
+    }
+    lock.lock();
 }
 
 void wsrep::server_state::close_transactions_at_disconnect(
@@ -1621,6 +1874,35 @@ void wsrep::server_state::close_transactions_at_disconnect(
 // Rollback event queue
 //
 
+void wsrep::server_state::enable_client_registry(size_t n_shards)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    if (!client_registry_)
+    {
+        client_registry_.reset(new wsrep::client_registry(n_shards));
+    }
+}
+
+void wsrep::server_state::enable_replay_gate()
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    if (!replay_gate_)
+    {
+        replay_gate_.reset(new wsrep::replay_gate());
+    }
+}
+
+void wsrep::server_state::enable_hot_key_detector(unsigned int threshold,
+                                                  bool serialize)
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    if (!hot_key_detector_)
+    {
+        hot_key_detector_.reset(
+            new wsrep::hot_key_detector(threshold, serialize));
+    }
+}
+
 void wsrep::server_state::queue_rollback_event(
     const wsrep::transaction_id& id)
 {
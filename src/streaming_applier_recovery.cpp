@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/streaming_applier_recovery.hpp"
+#include "wsrep/server_state.hpp"
+#include "wsrep/reporter.hpp"
+#include "wsrep/logger.hpp"
+
+#include <system_error>
+#include <thread>
+
+wsrep::streaming_applier_recovery::streaming_applier_recovery(
+    wsrep::server_state& server_state,
+    size_t n_workers,
+    wsrep::reporter* reporter)
+    : server_state_(server_state)
+    , n_workers_(n_workers)
+    , reporter_(reporter)
+    , mutex_()
+    , jobs_()
+    , recoverer_()
+    , results_()
+    , next_job_()
+    , done_()
+    , reported_percent_()
+    , failed_()
+    , recovered_()
+{ }
+
+int wsrep::streaming_applier_recovery::run(const std::vector<job>& jobs,
+                                           recoverer& recoverer)
+{
+    jobs_ = &jobs;
+    recoverer_ = &recoverer;
+    results_.assign(jobs.size(), 0);
+    next_job_ = 0;
+    done_ = 0;
+    reported_percent_ = 0;
+    failed_ = 0;
+    recovered_ = 0;
+
+    wsrep::log_info() << "Recovering " << jobs.size()
+                      << " streaming appliers using "
+                      << (n_workers_ > 1 ? n_workers_ : 1)
+                      << " threads";
+    report_progress(0);
+
+    // The calling thread participates in recovery, start
+    // n_workers - 1 additional threads.
+    std::vector<std::thread> threads;
+    for (size_t i(1); i < n_workers_ && i < jobs.size(); ++i)
+    {
+        try
+        {
+            threads.push_back(
+                std::thread(&streaming_applier_recovery::work, this));
+        }
+        catch (const std::system_error& e)
+        {
+            wsrep::log_warning() << "Failed to start streaming applier "
+                                 << "recovery thread: " << e.what();
+            break;
+        }
+    }
+    work();
+    for (std::vector<std::thread>::iterator i(threads.begin());
+         i != threads.end(); ++i)
+    {
+        i->join();
+    }
+
+    // All appliers have been reconstructed, register them into
+    // server state in the order of the job list.
+    for (size_t i(0); i < results_.size(); ++i)
+    {
+        if (results_[i])
+        {
+            server_state_.start_streaming_applier(
+                jobs[i].server_id, jobs[i].transaction_id, results_[i]);
+            ++recovered_;
+        }
+    }
+    results_.clear();
+    jobs_ = 0;
+    recoverer_ = 0;
+
+    wsrep::log_info() << "Recovered " << recovered_ << " streaming appliers, "
+                      << failed_ << " failures";
+    return (failed_ == 0 ? 0 : 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//                              Private                                       //
+////////////////////////////////////////////////////////////////////////////////
+
+void wsrep::streaming_applier_recovery::work()
+{
+    wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+    while (next_job_ < jobs_->size())
+    {
+        const size_t i(next_job_++);
+        lock.unlock();
+        wsrep::high_priority_service* result(0);
+        try
+        {
+            result = recoverer_->recover((*jobs_)[i]);
+        }
+        catch (const std::exception& e)
+        {
+            wsrep::log_error() << "Failed to recover streaming applier "
+                               << (*jobs_)[i].server_id << ": "
+                               << (*jobs_)[i].transaction_id
+                               << ": " << e.what();
+        }
+        catch (...)
+        {
+            // Exceptions must not escape from the worker thread.
+            wsrep::log_error() << "Failed to recover streaming applier "
+                               << (*jobs_)[i].server_id << ": "
+                               << (*jobs_)[i].transaction_id
+                               << ": unknown exception";
+        }
+        lock.lock();
+        results_[i] = result;
+        if (result == 0)
+        {
+            ++failed_;
+        }
+        report_progress(++done_);
+    }
+}
+
+void wsrep::streaming_applier_recovery::report_progress(size_t done)
+{
+    if (reporter_ == 0) return;
+    const size_t total(jobs_->size());
+    const size_t percent(total ? (100 * done) / total : 100);
+    if (done && done != total && percent == reported_percent_)
+    {
+        return;
+    }
+    reported_percent_ = percent;
+    reporter_->report_progress(
+        wsrep::reporter::make_progress_string(-1, -1, int(total), int(done),
+                                              -1));
+}
@@ -22,6 +22,7 @@
 
 #include "wsrep/thread_service.hpp"
 #include "wsrep/logger.hpp"
+#include "wsrep/thread_affinity_service_v1.h"
 #include "v26/wsrep_thread_service.h"
 
 #include <cassert>
@@ -38,6 +39,8 @@ namespace wsrep_thread_service_v1
     // the application.
     static wsrep::thread_service* thread_service_impl{ 0 };
     static std::atomic<size_t> use_count;
+    // Number of successful affinity service initializations.
+    static std::atomic<size_t> affinity_use_count;
 
     static const wsrep_thread_key_t* thread_key_create_cb(const char* name)
     {
@@ -113,6 +116,31 @@ namespace wsrep_thread_service_v1
             sp);
     }
 
+    int thread_setaffinity_cb(wsrep_thread_t* thread, size_t cpuset_size,
+                              const void* cpuset)
+    {
+        assert(thread_service_impl);
+        return thread_service_impl->setaffinity(
+            reinterpret_cast<wsrep::thread_service::thread*>(thread),
+            cpuset_size, cpuset);
+    }
+
+    int thread_getaffinity_cb(wsrep_thread_t* thread, size_t cpuset_size,
+                              void* cpuset)
+    {
+        assert(thread_service_impl);
+        return thread_service_impl->getaffinity(
+            reinterpret_cast<wsrep::thread_service::thread*>(thread),
+            cpuset_size, cpuset);
+    }
+
+    int thread_set_numa_node_cb(wsrep_thread_t* thread, int node)
+    {
+        assert(thread_service_impl);
+        return thread_service_impl->set_numa_node(
+            reinterpret_cast<wsrep::thread_service::thread*>(thread), node);
+    }
+
     const wsrep_mutex_key_t* mutex_key_create_cb(const char* name)
     {
         assert(thread_service_impl);
@@ -234,6 +262,11 @@ namespace wsrep_thread_service_v1
             cond_timedwait_cb,
             cond_signal_cb,
             cond_broadcast_cb };
+
+    static wsrep_thread_affinity_service_v1_t affinity_service_callbacks
+        = { thread_setaffinity_cb,
+            thread_getaffinity_cb,
+            thread_set_numa_node_cb };
 }
 
 int wsrep::thread_service_v1_probe(void* dlh)
@@ -268,12 +301,36 @@ int wsrep::thread_service_v1_init(void* dlh,
     else
     {
         ++wsrep_thread_service_v1::use_count;
+        // Affinity extension is optional.
+        typedef wsrep_thread_affinity_service_v1_init_fn affinity_init_fn;
+        typedef wsrep_thread_affinity_service_v1_deinit_fn affinity_deinit_fn;
+        if (wsrep_impl::service_probe<affinity_init_fn>(
+                dlh, WSREP_THREAD_AFFINITY_SERVICE_INIT_FUNC_V1,
+                "thread affinity service v1") == 0 &&
+            wsrep_impl::service_probe<affinity_deinit_fn>(
+                dlh, WSREP_THREAD_AFFINITY_SERVICE_DEINIT_FUNC_V1,
+                "thread affinity service v1") == 0 &&
+            wsrep_impl::service_init<affinity_init_fn>(
+                dlh, WSREP_THREAD_AFFINITY_SERVICE_INIT_FUNC_V1,
+                &wsrep_thread_service_v1::affinity_service_callbacks,
+                "thread affinity service v1") == 0)
+        {
+            ++wsrep_thread_service_v1::affinity_use_count;
+        }
     }
     return ret;
 }
 
 void wsrep::thread_service_v1_deinit(void* dlh)
 {
+    if (wsrep_thread_service_v1::affinity_use_count > 0)
+    {
+        typedef wsrep_thread_affinity_service_v1_deinit_fn affinity_deinit_fn;
+        wsrep_impl::service_deinit<affinity_deinit_fn>(
+            dlh, WSREP_THREAD_AFFINITY_SERVICE_DEINIT_FUNC_V1,
+            "thread affinity service v1");
+        --wsrep_thread_service_v1::affinity_use_count;
+    }
     typedef int (*deinit_fn)();
     wsrep_impl::service_deinit<deinit_fn>(
         dlh, WSREP_THREAD_SERVICE_DEINIT_FUNC_V1, "thread service v1");
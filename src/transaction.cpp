@@ -114,10 +114,14 @@ wsrep::transaction::transaction(
     , fragments_certified_for_statement_()
     , streaming_context_()
     , sr_keys_()
+    , key_tracking_()
+    , replay_gate_entered_(false)
+    , has_keys_(false)
     , apply_error_buf_()
     , xid_()
     , streaming_rollback_in_progress_(false)
     , is_bf_immutable_(false)
+    , registered_(false)
 { }
 
 
@@ -126,8 +130,10 @@ wsrep::transaction::~transaction()
 }
 
 int wsrep::transaction::start_transaction(
+    wsrep::unique_lock<wsrep::mutex>& lock,
     const wsrep::transaction_id& id)
 {
+    assert(lock.owns_lock());
     debug_log_state("start_transaction enter");
     assert(active() == false);
     assert(is_xa() == false);
@@ -145,8 +151,21 @@ int wsrep::transaction::start_transaction(
         debug_log_state("start_transaction success");
         return 0;
     case wsrep::client_state::m_local:
+    {
+        int ret(provider().start_transaction(ws_handle_));
+        if (wsrep::client_registry* registry =
+            client_state_.server_state().client_registry())
+        {
+            // Registry shard locks are never acquired while holding
+            // the client state mutex, see cleanup().
+            registered_ = true;
+            lock.unlock();
+            registry->insert(client_state_.id(), id, &client_state_);
+            lock.lock();
+        }
         debug_log_state("start_transaction success");
-        return provider().start_transaction(ws_handle_);
+        return ret;
+    }
     default:
         debug_log_state("start_transaction error");
         assert(0);
@@ -202,7 +221,8 @@ void wsrep::transaction::adopt(const wsrep::transaction& transaction)
 {
     debug_log_state("adopt enter");
     assert(transaction.is_streaming());
-    start_transaction(transaction.id());
+    wsrep::client_state_lock lock(client_state_);
+    start_transaction(lock, transaction.id());
     server_id_ = transaction.server_id_;
     flags_  = transaction.flags();
     streaming_context_ = transaction.streaming_context();
@@ -212,7 +232,7 @@ void wsrep::transaction::adopt(const wsrep::transaction& transaction)
 void wsrep::transaction::fragment_applied(wsrep::seqno seqno)
 {
     assert(active());
-    streaming_context_.applied(seqno);
+    streaming_context_.mut().applied(seqno);
 }
 
 int wsrep::transaction::prepare_for_ordering(
@@ -250,7 +270,25 @@ int wsrep::transaction::append_key(const wsrep::key& key)
     try
     {
         debug_log_key_append(key);
-        sr_keys_.insert(key);
+        has_keys_ = true;
+        // SR keys are needed only for the commit fragment of streaming
+        // and XA transactions. Keys appended before streaming is
+        // enabled in the middle of the transaction are not recorded.
+        if (streaming_context_.get().fragment_size() || is_streaming() ||
+            is_xa())
+        {
+            sr_keys_.mut().insert(key);
+        }
+        if (client_state_.server_state().replay_gate())
+        {
+            key_tracking_.mut().replay_keys.push_back(
+                wsrep::replay_gate::encode(key));
+        }
+        if (client_state_.server_state().hot_key_detector())
+        {
+            key_tracking_.mut().key_hashes.push_back(
+                wsrep::hot_key_detector::hash(key));
+        }
         return provider().append_key(ws_handle_, key);
     }
     catch (...)
@@ -268,11 +306,11 @@ int wsrep::transaction::append_data(const wsrep::const_buffer& data)
 
 int wsrep::transaction::after_row()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("after_row_enter");
     int ret(0);
-    if (streaming_context_.fragment_size() &&
-        streaming_context_.fragment_unit() != streaming_context::statement)
+    if (streaming_context_.get().fragment_size() &&
+        streaming_context_.get().fragment_unit() != streaming_context::statement)
     {
         ret = streaming_step(lock);
     }
@@ -456,7 +494,7 @@ int wsrep::transaction::before_commit(const wsrep::provider::seq_cb* seq_cb)
 {
     int ret(1);
 
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("before_commit_enter");
     assert(client_state_.mode() != wsrep::client_state::m_toi);
     assert(state() == s_executing ||
@@ -522,6 +560,8 @@ int wsrep::transaction::before_commit(const wsrep::provider::seq_cb* seq_cb)
             switch (status)
             {
             case wsrep::provider::success:
+                client_state_.server_state().commit_order_entered(
+                    ws_meta_.gtid());
                 break;
             case wsrep::provider::error_bf_abort:
                 if (state() != s_must_abort)
@@ -558,6 +598,11 @@ int wsrep::transaction::before_commit(const wsrep::provider::seq_cb* seq_cb)
         }
         lock.unlock();
         ret = ret || provider().commit_order_enter(ws_handle_, ws_meta_);
+        if (ret == 0)
+        {
+            client_state_.server_state().commit_order_entered(
+                ws_meta_.gtid());
+        }
         lock.lock();
         if (ret)
         {
@@ -581,7 +626,7 @@ int wsrep::transaction::before_commit(const wsrep::provider::seq_cb* seq_cb)
 
 int wsrep::transaction::ordered_commit()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("ordered_commit_enter");
     assert(state() == s_committing);
     assert(is_bf_immutable_);
@@ -589,6 +634,7 @@ int wsrep::transaction::ordered_commit()
     client_service_.debug_sync("wsrep_before_commit_order_leave");
     int ret(provider().commit_order_leave(ws_handle_, ws_meta_,
                                           apply_error_buf_));
+    client_state_.server_state().commit_order_left(ws_meta_.gtid());
     client_service_.debug_sync("wsrep_after_commit_order_leave");
     // Should always succeed:
     // 1) If before commit before succeeds, the transaction handle
@@ -622,7 +668,7 @@ int wsrep::transaction::after_commit()
 {
     int ret(0);
 
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     assert(is_bf_immutable_);
     debug_log_state("after_commit_enter");
     assert(state() == s_ordered_commit);
@@ -645,7 +691,7 @@ int wsrep::transaction::after_commit()
             client_state_.server_state_.stop_streaming_client(&client_state_);
             lock.lock();
         }
-        streaming_context_.cleanup();
+        cleanup_streaming_context();
     }
 
     switch (client_state_.mode())
@@ -667,7 +713,7 @@ int wsrep::transaction::after_commit()
 
 int wsrep::transaction::before_rollback()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("before_rollback_enter");
     assert(state() == s_executing ||
            state() == s_preparing ||
@@ -754,7 +800,7 @@ int wsrep::transaction::before_rollback()
 
 int wsrep::transaction::after_rollback()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("after_rollback_enter");
     assert(state() == s_aborting || state() == s_must_replay);
 
@@ -776,7 +822,7 @@ int wsrep::transaction::after_rollback()
             // We skip streaming context cleanup for replay because
             // we want to remember if the transaction was streaming.
             // See transaction::replay()
-            streaming_context_.cleanup();
+            cleanup_streaming_context();
         }
 
         state(lock, s_aborted);
@@ -799,9 +845,12 @@ int wsrep::transaction::release_commit_order(
     int ret(provider().commit_order_enter(ws_handle_, ws_meta_));
     if (!ret)
     {
+        wsrep::server_state& server_state(client_state_.server_state());
+        server_state.commit_order_entered(ws_meta_.gtid());
         server_service_.set_position(client_service_, ws_meta_.gtid());
         ret = provider().commit_order_leave(ws_handle_, ws_meta_,
                                             apply_error_buf_);
+        server_state.commit_order_left(ws_meta_.gtid());
     }
     // grabbing lock here, as set_position may call for sync wait in galera side
     lock.lock();
@@ -830,7 +879,7 @@ void wsrep::transaction::remove_fragments_in_storage_service_scope(
 
 int wsrep::transaction::after_statement()
 {
-  wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex());
+  wsrep::client_state_lock lock(client_state_);
   return after_statement(lock);
 }
 
@@ -849,8 +898,8 @@ int wsrep::transaction::after_statement(wsrep::unique_lock<wsrep::mutex>& lock)
            state() == s_must_replay);
 
     if (state() == s_executing &&
-        streaming_context_.fragment_size() &&
-        streaming_context_.fragment_unit() == streaming_context::statement)
+        streaming_context_.get().fragment_size() &&
+        streaming_context_.get().fragment_unit() == streaming_context::statement)
     {
         ret = streaming_step(lock);
     }
@@ -931,7 +980,7 @@ int wsrep::transaction::after_statement(wsrep::unique_lock<wsrep::mutex>& lock)
         (!client_service_.is_explicit_xa() ||
          client_state_.state() == wsrep::client_state::s_quitting))
     {
-        cleanup();
+        cleanup(lock);
     }
     fragments_certified_for_statement_ = 0;
     debug_log_state("after_statement_leave");
@@ -969,7 +1018,7 @@ void wsrep::transaction::after_command_must_abort(
 
 void wsrep::transaction::after_applying()
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex_);
+    wsrep::client_state_lock lock(client_state_);
     debug_log_state("after_applying enter");
     assert(state_ == s_executing ||
            state_ == s_prepared ||
@@ -980,7 +1029,7 @@ void wsrep::transaction::after_applying()
     if (state_ != s_executing && state_ != s_prepared)
     {
         if (state_ == s_replaying) state(lock, s_aborted);
-        cleanup();
+        cleanup(lock);
     }
     else
     {
@@ -998,7 +1047,8 @@ void wsrep::transaction::after_applying()
 bool wsrep::transaction::bf_abort(
     wsrep::unique_lock<wsrep::mutex>& lock,
     wsrep::seqno bf_seqno,
-    wsrep::client_service& victim_ctx)
+    wsrep::client_service& victim_ctx,
+    bool* deferred_rollback)
 {
     bool ret(false);
     const enum wsrep::transaction::state state_at_enter(state());
@@ -1040,6 +1090,7 @@ bool wsrep::transaction::bf_abort(
                                 << " victim_seqno " << victim_seqno);
                 bf_abort_state_ = state_at_enter;
                 state(lock, s_must_abort);
+                record_conflict();
                 ret = true;
                 break;
             default:
@@ -1065,6 +1116,18 @@ bool wsrep::transaction::bf_abort(
     if (ret)
     {
         bf_abort_client_state_ = client_state_.state();
+        // Victim may be waiting for replayers or hot key locks
+        // in certification.
+        if (wsrep::replay_gate* gate =
+            client_state_.server_state().replay_gate())
+        {
+            gate->interrupt(*this);
+        }
+        if (wsrep::hot_key_detector* detector =
+            client_state_.server_state().hot_key_detector())
+        {
+            detector->interrupt(*this);
+        }
         // If the transaction is in executing state, we must initiate
         // streaming rollback to ensure that the rollback fragment gets
         // replicated before the victim starts to roll back and release locks.
@@ -1108,7 +1171,14 @@ bool wsrep::transaction::bf_abort(
                 }
             }
 
-            server_service_.background_rollback(lock, client_state_);
+            if (deferred_rollback)
+            {
+                *deferred_rollback = true;
+            }
+            else
+            {
+                server_service_.background_rollback(lock, client_state_);
+            }
         }
     }
     return ret;
@@ -1117,14 +1187,15 @@ bool wsrep::transaction::bf_abort(
 bool wsrep::transaction::total_order_bf_abort(
     wsrep::unique_lock<wsrep::mutex>& lock WSREP_UNUSED,
     wsrep::seqno bf_seqno,
-    wsrep::client_service& victim_ctx)
+    wsrep::client_service& victim_ctx,
+    bool* deferred_rollback)
 {
     /* We must set this flag before entering bf_abort() in order
      * to streaming_rollback() work correctly. The flag will be
      * unset if BF abort was not allowed. Note that we rely in
      * bf_abort() not to release lock if the BF abort is not allowed. */
     bf_aborted_in_total_order_ = true;
-    bool ret(bf_abort(lock, bf_seqno, victim_ctx));
+    bool ret(bf_abort(lock, bf_seqno, victim_ctx, deferred_rollback));
     if (not ret)
     {
         bf_aborted_in_total_order_ = false;
@@ -1136,11 +1207,11 @@ void wsrep::transaction::clone_for_replay(const wsrep::transaction& other)
 {
     assert(other.state() == s_replaying);
     id_ = other.id_;
-    xid_ = other.xid_;
+    xid_.assign(other.xid_);
     server_id_ = other.server_id_;
     ws_handle_ = other.ws_handle_;
     ws_meta_ = other.ws_meta_;
-    streaming_context_ = other.streaming_context_;
+    streaming_context_.assign(other.streaming_context_);
     state_ = s_replaying;
     client_service_.notify_state_change();
 }
@@ -1154,7 +1225,7 @@ void wsrep::transaction::assign_xid(const wsrep::xid& xid)
 
 int wsrep::transaction::restore_to_prepared_state(const wsrep::xid& xid)
 {
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex_);
+    wsrep::client_state_lock lock(client_state_);
     assert(active());
     assert(is_empty());
     assert(state() == s_executing || state() == s_replaying);
@@ -1176,7 +1247,7 @@ int wsrep::transaction::commit_or_rollback_by_xid(const wsrep::xid& xid,
                                                   bool commit)
 {
     debug_log_state("commit_or_rollback_by_xid enter");
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex_);
+    wsrep::client_state_lock lock(client_state_);
     wsrep::server_state& server_state(client_state_.server_state());
     wsrep::high_priority_service* sa(server_state.find_streaming_applier(xid));
 
@@ -1260,12 +1331,12 @@ void wsrep::transaction::xa_detach()
         client_service_.store_globals();
         client_service_.cleanup_transaction();
     }
-    wsrep::unique_lock<wsrep::mutex> lock(client_state_.mutex_);
-    streaming_context_.cleanup();
+    wsrep::client_state_lock lock(client_state_);
+    cleanup_streaming_context();
     state(lock, s_aborting);
     state(lock, s_aborted);
     provider().release(ws_handle_);
-    cleanup();
+    cleanup(lock);
     debug_log_state("xa_detach leave");
 }
 
@@ -1299,10 +1370,10 @@ int wsrep::transaction::xa_replay(wsrep::unique_lock<wsrep::mutex>& lock)
     debug_log_state("xa_replay enter");
     xa_replay_common(lock);
     state(lock, s_aborted);
-    streaming_context_.cleanup();
+    cleanup_streaming_context();
     provider().release(ws_handle_);
-    cleanup();
-    client_service_.signal_replayed();
+    cleanup(lock);
+    signal_replayed();
     debug_log_state("xa_replay leave");
     return 0;
 }
@@ -1319,9 +1390,9 @@ int wsrep::transaction::xa_replay_commit(wsrep::unique_lock<wsrep::mutex>& lock)
     {
     case wsrep::provider::success:
         state(lock, s_committed);
-        streaming_context_.cleanup();
+        cleanup_streaming_context();
         provider().release(ws_handle_);
-        cleanup();
+        cleanup(lock);
         ret = 0;
         break;
     default:
@@ -1333,7 +1404,7 @@ int wsrep::transaction::xa_replay_commit(wsrep::unique_lock<wsrep::mutex>& lock)
         client_state_.override_error(wsrep::e_error_during_commit, status);
     }
 
-    client_service_.signal_replayed();
+    signal_replayed();
     debug_log_state("xa_replay_commit leave");
     return ret;
 }
@@ -1393,15 +1464,17 @@ void wsrep::transaction::state(
     }
 
     state_hist_.push_back(state_);
-    if (state_hist_.size() == 12)
-    {
-        state_hist_.erase(state_hist_.begin());
-    }
     state_ = next_state;
     client_service_.notify_state_change();
 
     if (state_ == s_must_replay)
     {
+        wsrep::replay_gate* gate(client_state_.server_state().replay_gate());
+        if (gate && !replay_gate_entered_)
+        {
+            gate->enter(key_tracking_.get().replay_keys);
+            replay_gate_entered_ = true;
+        }
         client_service_.will_replay();
     }
 }
@@ -1454,34 +1527,34 @@ int wsrep::transaction::streaming_step(wsrep::unique_lock<wsrep::mutex>& lock,
                                        bool force)
 {
     assert(lock.owns_lock());
-    assert(streaming_context_.fragment_size() || is_xa());
+    assert(streaming_context_.get().fragment_size() || is_xa());
 
     if (client_service_.bytes_generated() <
-        streaming_context_.log_position())
+        streaming_context_.get().log_position())
     {
         /* Something went wrong on DBMS side in keeping track of
            generated bytes. Return an error to abort the transaction. */
         wsrep::log_warning() << "Bytes generated "
                              << client_service_.bytes_generated()
                              << " less than bytes certified "
-                             << streaming_context_.log_position()
+                             << streaming_context_.get().log_position()
                              << ", aborting streaming transaction";
         return 1;
     }
     int ret(0);
 
     const size_t bytes_to_replicate(client_service_.bytes_generated() -
-                                    streaming_context_.log_position());
+                                    streaming_context_.get().log_position());
 
-    switch (streaming_context_.fragment_unit())
+    switch (streaming_context_.get().fragment_unit())
     {
     case streaming_context::row:
         WSREP_FALLTHROUGH;
     case streaming_context::statement:
-        streaming_context_.increment_unit_counter(1);
+        streaming_context_.mut().increment_unit_counter(1);
         break;
     case streaming_context::bytes:
-        streaming_context_.set_unit_counter(bytes_to_replicate);
+        streaming_context_.mut().set_unit_counter(bytes_to_replicate);
         break;
     }
 
@@ -1496,9 +1569,9 @@ int wsrep::transaction::streaming_step(wsrep::unique_lock<wsrep::mutex>& lock,
         return ret;
     }
 
-    if (streaming_context_.fragment_size_exceeded() || force)
+    if (streaming_context_.get().fragment_size_exceeded() || force)
     {
-        streaming_context_.reset_unit_counter();
+        streaming_context_.mut().reset_unit_counter();
         ret = certify_fragment(lock);
     }
 
@@ -1511,10 +1584,10 @@ int wsrep::transaction::certify_fragment(
     assert(lock.owns_lock());
 
     assert(client_state_.mode() == wsrep::client_state::m_local);
-    assert(streaming_context_.rolled_back() == false ||
+    assert(streaming_context_.get().rolled_back() == false ||
            state() == s_must_abort);
 
-    client_service_.wait_for_replayers(lock);
+    wait_for_replayers(lock);
     if (abort_or_interrupt(lock))
     {
         return 1;
@@ -1546,7 +1619,7 @@ int wsrep::transaction::certify_fragment(
         client_state_.override_error(wsrep::e_error_during_commit);
         return 1;
     }
-    streaming_context_.set_log_position(log_position);
+    streaming_context_.mut().set_log_position(log_position);
 
     if (data.size() == 0)
     {
@@ -1654,7 +1727,7 @@ int wsrep::transaction::certify_fragment(
             case wsrep::provider::success:
                 ++fragments_certified_for_statement_;
                 assert(sr_ws_meta.seqno().is_undefined() == false);
-                streaming_context_.certified();
+                streaming_context_.mut().certified();
                 if (storage_service.update_fragment_meta(sr_ws_meta))
                 {
                     storage_service.rollback(wsrep::ws_handle(),
@@ -1670,7 +1743,7 @@ int wsrep::transaction::certify_fragment(
                 }
                 else
                 {
-                    streaming_context_.stored(sr_ws_meta.seqno());
+                    streaming_context_.mut().stored(sr_ws_meta.seqno());
                 }
                 client_service_.debug_crash(
                     "crash_replicate_fragment_success");
@@ -1694,7 +1767,7 @@ int wsrep::transaction::certify_fragment(
                 // we take a risk of sending one rollback fragment for nothing.
                 storage_service.rollback(wsrep::ws_handle(),
                                          wsrep::ws_meta());
-                streaming_context_.certified();
+                streaming_context_.mut().certified();
                 ret = 1;
                 error = wsrep::e_deadlock_error;
                 break;
@@ -1771,7 +1844,24 @@ int wsrep::transaction::certify_commit(
 {
     assert(lock.owns_lock());
     assert(active());
-    client_service_.wait_for_replayers(lock);
+    wait_for_replayers(lock);
+
+    if (wsrep::hot_key_detector* detector =
+        client_state_.server_state().hot_key_detector())
+    {
+        // Prepared XA transactions may stay uncommitted for a long
+        // time, don't let them hold key locks.
+        key_tracking& keys(key_tracking_.mut());
+        if (keys.hot_key_slots.empty() && !is_xa())
+        {
+            // Appliers BF abort the waiter if it holds resources
+            // they need, BF abort interrupts the wait.
+            while (not abort_or_interrupt(lock) &&
+                   not detector->lock(keys.key_hashes, keys.hot_key_slots,
+                                      *this, lock))
+            { }
+        }
+    }
 
     assert(lock.owns_lock());
 
@@ -1916,6 +2006,7 @@ int wsrep::transaction::certify_commit(
     case wsrep::provider::error_certification_failed:
         state(lock, s_cert_failed);
         client_state_.override_error(wsrep::e_deadlock_error);
+        record_conflict();
         break;
     case wsrep::provider::error_size_exceeded:
         state(lock, s_must_abort);
@@ -1977,13 +2068,52 @@ int wsrep::transaction::certify_commit(
     return ret;
 }
 
+void wsrep::transaction::wait_for_replayers(
+    wsrep::unique_lock<wsrep::mutex>& lock)
+{
+    assert(lock.owns_lock());
+    if (wsrep::replay_gate* gate = client_state_.server_state().replay_gate())
+    {
+        // Wait only for replayers with overlapping keys. The
+        // replayer BF aborts the waiter if the waiter holds
+        // resources it needs, BF abort interrupts the wait.
+        while (not abort_or_interrupt(lock) &&
+               not gate->wait(key_tracking_.get().replay_keys, *this, lock))
+        { }
+    }
+    else
+    {
+        client_service_.wait_for_replayers(lock);
+    }
+}
+
+void wsrep::transaction::signal_replayed()
+{
+    if (replay_gate_entered_)
+    {
+        client_state_.server_state().replay_gate()->leave(
+            key_tracking_.get().replay_keys);
+        replay_gate_entered_ = false;
+    }
+    client_service_.signal_replayed();
+}
+
+void wsrep::transaction::record_conflict()
+{
+    if (wsrep::hot_key_detector* detector =
+        client_state_.server_state().hot_key_detector())
+    {
+        detector->record_conflict(key_tracking_.get().key_hashes);
+    }
+}
+
 int wsrep::transaction::append_sr_keys_for_commit()
 {
     int ret(0);
     assert(client_state_.mode() == wsrep::client_state::m_local);
     for (wsrep::sr_key_set::branch_type::const_iterator
-             i(sr_keys_.root().begin());
-         ret == 0 && i != sr_keys_.root().end(); ++i)
+             i(sr_keys_.get().root().begin());
+         ret == 0 && i != sr_keys_.get().root().end(); ++i)
     {
         for (wsrep::sr_key_set::leaf_type::const_iterator
                  j(i->second.begin());
@@ -2017,10 +2147,10 @@ void wsrep::transaction::streaming_rollback(
     // and therefore change the state of the transaction, causing
     // assertions to fire.
     while (streaming_rollback_in_progress_)
-        client_state_.cond_.wait(lock);
+        client_state_.streaming_rollback_cond_.wait(lock);
     streaming_rollback_in_progress_ = true;
 
-    if (streaming_context_.rolled_back() == false)
+    if (streaming_context_.get().rolled_back() == false)
     {
         // Note that streaming_context_ must not be cleaned up in this
         // method. This is because the owning thread may still be executing
@@ -2064,12 +2194,14 @@ void wsrep::transaction::streaming_rollback(
 
         // Mark the streaming context as rolled back,
         // so that this block is executed once.
-        streaming_context_.rolled_back(id_);
+        streaming_context_.mut().rolled_back(id_);
     }
 
     debug_log_state("streaming_rollback leave");
     streaming_rollback_in_progress_ = false;
-    client_state_.cond_.notify_all();
+    // Each thread leaving streaming rollback passes the turn to
+    // one waiter.
+    client_state_.notify_waiter(client_state_.streaming_rollback_cond_);
 }
 
 int wsrep::transaction::replay(wsrep::unique_lock<wsrep::mutex>& lock)
@@ -2083,7 +2215,7 @@ int wsrep::transaction::replay(wsrep::unique_lock<wsrep::mutex>& lock)
     lock.unlock();
     client_service_.debug_sync("wsrep_before_replay");
     enum wsrep::provider::status replay_ret(client_service_.replay());
-    client_service_.signal_replayed();
+    signal_replayed();
     if (was_streaming)
     {
         client_state_.server_state_.stop_streaming_client(&client_state_);
@@ -2100,7 +2232,7 @@ int wsrep::transaction::replay(wsrep::unique_lock<wsrep::mutex>& lock)
         }
         if (is_streaming())
         {
-            streaming_context_.cleanup();
+            cleanup_streaming_context();
         }
         provider().release(ws_handle_);
         break;
@@ -2112,7 +2244,7 @@ int wsrep::transaction::replay(wsrep::unique_lock<wsrep::mutex>& lock)
             lock.unlock();
             client_service_.remove_fragments();
             lock.lock();
-            streaming_context_.cleanup();
+            cleanup_streaming_context();
         }
         state(lock, s_aborted);
         ret = 1;
@@ -2129,10 +2261,22 @@ int wsrep::transaction::replay(wsrep::unique_lock<wsrep::mutex>& lock)
     return ret;
 }
 
-void wsrep::transaction::cleanup()
+void wsrep::transaction::cleanup(wsrep::unique_lock<wsrep::mutex>& lock)
 {
+    assert(lock.owns_lock());
     debug_log_state("cleanup_enter");
     assert(state() == s_committed || state() == s_aborted);
+    if (registered_)
+    {
+        // Registry shard locks are never acquired while holding
+        // the client state mutex.
+        registered_ = false;
+        lock.unlock();
+        assert(not lock.owns_lock());
+        client_state_.server_state().client_registry()->erase(
+            client_state_.id(), id_);
+        lock.lock();
+    }
     id_ = wsrep::transaction_id::undefined();
     ws_handle_ = wsrep::ws_handle();
     // Keep the state history for troubleshooting. Reset
@@ -2150,15 +2294,47 @@ void wsrep::transaction::cleanup()
     flags_ = 0;
     certified_ = false;
     implicit_deps_ = false;
-    sr_keys_.clear();
-    streaming_context_.cleanup();
+    sr_keys_.reset();
+    has_keys_ = false;
+    if (replay_gate_entered_)
+    {
+        // Replay was not completed via signal_replayed().
+        client_state_.server_state().replay_gate()->leave(
+            key_tracking_.get().replay_keys);
+        replay_gate_entered_ = false;
+    }
+    if (key_tracking_.allocated())
+    {
+        // Keep the storage for the next transaction of the client.
+        key_tracking& keys(key_tracking_.mut());
+        keys.replay_keys.clear();
+        if (!keys.hot_key_slots.empty())
+        {
+            client_state_.server_state().hot_key_detector()->unlock(
+                keys.hot_key_slots);
+        }
+        keys.key_hashes.clear();
+    }
+    cleanup_streaming_context();
     client_service_.cleanup_transaction();
     apply_error_buf_.clear();
-    xid_.clear();
+    xid_.reset();
     is_bf_immutable_ = false;
     debug_log_state("cleanup_leave");
 }
 
+void wsrep::transaction::cleanup_streaming_context()
+{
+    if (streaming_context_.allocated())
+    {
+        streaming_context_.mut().cleanup();
+        if (streaming_context_.get().fragment_size() == 0)
+        {
+            streaming_context_.reset();
+        }
+    }
+}
+
 void wsrep::transaction::debug_log_state(
     const char* context) const
 {
@@ -2180,13 +2356,13 @@ void wsrep::transaction::debug_log_state(
         << ", status: " << client_state_.current_error_status()
         << "\n"
         << "    is_sr: " << is_streaming()
-        << ", frags: " << streaming_context_.fragments_certified()
-        << ", frags size: " << streaming_context_.fragments().size()
-        << ", unit: " << streaming_context_.fragment_unit()
-        << ", size: " << streaming_context_.fragment_size()
-        << ", counter: " << streaming_context_.unit_counter()
-        << ", log_pos: " << streaming_context_.log_position()
-        << ", sr_rb: " << streaming_context_.rolled_back()
+        << ", frags: " << streaming_context_.get().fragments_certified()
+        << ", frags size: " << streaming_context_.get().fragments().size()
+        << ", unit: " << streaming_context_.get().fragment_unit()
+        << ", size: " << streaming_context_.get().fragment_size()
+        << ", counter: " << streaming_context_.get().unit_counter()
+        << ", log_pos: " << streaming_context_.get().log_position()
+        << ", sr_rb: " << streaming_context_.get().rolled_back()
         << "\n    own: " << (client_state_.owning_thread_id_ == wsrep::this_thread::get_id())
         << " thread_id: " << client_state_.owning_thread_id_
         << "");
@@ -495,15 +495,15 @@ namespace
         wsrep::const_buffer data(buf->ptr, buf->len);
         wsrep::ws_handle ws_handle(wsrep::transaction_id(wsh->trx_id),
                                    wsh->opaque);
-        wsrep::ws_meta ws_meta(
-            wsrep::gtid(wsrep::id(meta->gtid.uuid.data,
-                                  sizeof(meta->gtid.uuid.data)),
-                        wsrep::seqno(meta->gtid.seqno)),
-            wsrep::stid(wsrep::id(meta->stid.node.data,
-                                  sizeof(meta->stid.node.data)),
-                        wsrep::transaction_id(meta->stid.trx),
-                        wsrep::client_id(meta->stid.conn)),
-            wsrep::seqno(seqno_from_native(meta->depends_on)),
+        // Identifier buffers are referenced in place, complete ws_meta
+        // is constructed only if the applier needs it.
+        wsrep::ws_meta_view ws_meta(
+            meta->gtid.uuid.data,
+            meta->gtid.seqno,
+            meta->stid.node.data,
+            meta->stid.trx,
+            meta->stid.conn,
+            seqno_from_native(meta->depends_on).get(),
             map_flags_from_native(flags));
         try
         {
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/adaptive_mutex.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(adaptive_mutex_mutual_exclusion)
+{
+    // Zero spins to exercise the parking path.
+    wsrep::adaptive_mutex mutex(0);
+    size_t counter(0);
+    std::vector<std::thread> threads;
+    for (size_t i(0); i < 4; ++i)
+    {
+        threads.push_back(std::thread([&mutex, &counter]()
+        {
+            for (size_t j(0); j < 10000; ++j)
+            {
+                wsrep::unique_lock<wsrep::mutex> lock(mutex);
+                ++counter;
+            }
+        }));
+    }
+    for (size_t i(0); i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+    BOOST_REQUIRE(counter == 40000);
+}
+
+BOOST_AUTO_TEST_CASE(adaptive_condition_variable_wait_notify)
+{
+    wsrep::adaptive_mutex mutex;
+    wsrep::adaptive_condition_variable cond;
+    size_t turn(0);
+    const size_t rounds(1000);
+    std::thread other([&]()
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex);
+        for (size_t i(0); i < rounds; ++i)
+        {
+            while (turn % 2 == 0) cond.wait(lock);
+            ++turn;
+            cond.notify_all();
+        }
+    });
+    {
+        wsrep::unique_lock<wsrep::mutex> lock(mutex);
+        for (size_t i(0); i < rounds; ++i)
+        {
+            while (turn % 2 == 1) cond.wait(lock);
+            ++turn;
+            cond.notify_one();
+        }
+        while (turn != 2 * rounds) cond.wait(lock);
+    }
+    other.join();
+    BOOST_REQUIRE(turn == 2 * rounds);
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file apply_bench.cpp
+ *
+ * Microbenchmark for write set apply dispatch path.
+ *
+ * Dispatches write sets from provider native meta data through
+ * high_priority_service::apply() to 1PC commit, constructing
+ * wsrep::ws_meta up front and through wsrep::ws_meta_view as the
+ * provider apply callback does. The latter constructs ws_meta when
+ * the default apply() implementation needs it.
+ *
+ * The skip cases compare a service which skips write sets by seqno
+ * (for example ones already contained in the storage engine) with
+ * up front ws_meta construction and with ws_meta_view, which skips
+ * without converting the meta data.
+ *
+ * Usage: wsrep-lib_apply_bench [-- iterations]
+ */
+
+#define BOOST_TEST_MODULE wsrep-lib_apply_bench
+#include <boost/test/included/unit_test.hpp>
+
+#include "mock_server_state.hpp"
+#include "bench_utils.hpp"
+
+#include "wsrep/logger.hpp"
+
+#include <cstring>
+
+namespace
+{
+    // Mock provider logs every call, discard log to keep formatting
+    // out of the measured apply path.
+    void discard_log(wsrep::log::level, const char*, const char*) { }
+
+    // Layout equivalent of wsrep_trx_meta_t, wsrep API headers
+    // are not needed to exercise the dispatch path.
+    struct native_meta
+    {
+        struct { unsigned char uuid[16]; long long seqno; } gtid;
+        struct
+        {
+            unsigned char node[16];
+            unsigned long long trx;
+            unsigned long long conn;
+        } stid;
+        long long depends_on;
+    };
+
+    // Skips write sets at or below given seqno without constructing
+    // complete ws_meta.
+    class skipping_service : public wsrep::mock_high_priority_service
+    {
+    public:
+        skipping_service(wsrep::server_state& server_state,
+                         wsrep::mock_client_state* client_state)
+            : wsrep::mock_high_priority_service(server_state, client_state,
+                                                false)
+            , skip_below_()
+        { }
+        using wsrep::high_priority_service::apply;
+        int apply(const wsrep::ws_handle& ws_handle,
+                  const wsrep::ws_meta_view& ws_meta_view,
+                  const wsrep::const_buffer& data) WSREP_OVERRIDE
+        {
+            if (ws_meta_view.seqno() <= skip_below_) return 0;
+            return wsrep::high_priority_service::apply(
+                ws_handle, ws_meta_view, data);
+        }
+        wsrep::seqno skip_below_;
+    };
+
+    struct apply_fixture
+    {
+        apply_fixture()
+            : server_service(&ss)
+            , ss("s1", wsrep::server_state::rm_sync, server_service)
+            , cc(ss, wsrep::client_id(1),
+                 wsrep::client_state::m_high_priority)
+            , hps(ss, &cc)
+            , meta()
+        {
+            wsrep::log::logger_fn(discard_log);
+            cc.open(cc.id());
+            cc.before_command();
+            ss.mock_connect();
+            std::memset(meta.gtid.uuid, 1, sizeof(meta.gtid.uuid));
+            std::memset(meta.stid.node, 2, sizeof(meta.stid.node));
+            meta.stid.conn = 1;
+        }
+
+        ~apply_fixture()
+        {
+            cc.after_command_before_result();
+            cc.after_command_after_result();
+            cc.close();
+            cc.cleanup();
+        }
+
+        void next(size_t i)
+        {
+            meta.gtid.seqno = static_cast<long long>(i + 1);
+            meta.stid.trx = i + 1;
+            meta.depends_on = static_cast<long long>(i);
+        }
+
+        wsrep::mock_server_service server_service;
+        wsrep::mock_server_state ss;
+        wsrep::mock_client cc;
+        skipping_service hps;
+        native_meta meta;
+    };
+
+    const int flags(wsrep::provider::flag::start_transaction |
+                    wsrep::provider::flag::commit);
+    const char data[1] = { 1 };
+
+    wsrep::ws_meta make_ws_meta(const native_meta& meta)
+    {
+        return wsrep::ws_meta(
+            wsrep::gtid(wsrep::id(meta.gtid.uuid, sizeof(meta.gtid.uuid)),
+                        wsrep::seqno(meta.gtid.seqno)),
+            wsrep::stid(wsrep::id(meta.stid.node, sizeof(meta.stid.node)),
+                        wsrep::transaction_id(meta.stid.trx),
+                        wsrep::client_id(meta.stid.conn)),
+            wsrep::seqno(meta.depends_on), flags);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(apply_dispatch)
+{
+    const size_t iterations(
+        wsrep_bench::iterations(
+            boost::unit_test::framework::master_test_suite().argc,
+            boost::unit_test::framework::master_test_suite().argv,
+            1000000));
+    {
+        apply_fixture f;
+        wsrep_bench::run(
+            "apply ws_meta", iterations,
+            [&f](size_t i)
+            {
+                f.next(i);
+                wsrep::ws_handle ws_handle(
+                    wsrep::transaction_id(f.meta.stid.trx), &f);
+                const wsrep::ws_meta ws_meta(make_ws_meta(f.meta));
+                if (f.hps.apply(ws_handle, ws_meta,
+                                wsrep::const_buffer(data, sizeof(data))))
+                {
+                    BOOST_FAIL("Apply failed");
+                }
+            });
+    }
+    {
+        apply_fixture f;
+        wsrep_bench::run(
+            "apply ws_meta_view", iterations,
+            [&f](size_t i)
+            {
+                f.next(i);
+                wsrep::ws_handle ws_handle(
+                    wsrep::transaction_id(f.meta.stid.trx), &f);
+                const wsrep::ws_meta_view ws_meta_view(
+                    f.meta.gtid.uuid, f.meta.gtid.seqno,
+                    f.meta.stid.node, f.meta.stid.trx, f.meta.stid.conn,
+                    f.meta.depends_on, flags);
+                if (f.hps.apply(ws_handle, ws_meta_view,
+                                wsrep::const_buffer(data, sizeof(data))))
+                {
+                    BOOST_FAIL("Apply failed");
+                }
+            });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(apply_skip)
+{
+    const size_t iterations(
+        wsrep_bench::iterations(
+            boost::unit_test::framework::master_test_suite().argc,
+            boost::unit_test::framework::master_test_suite().argv,
+            1000000));
+    apply_fixture f;
+    f.hps.skip_below_ = wsrep::seqno(
+        static_cast<long long>(iterations) + 1);
+    wsrep_bench::run(
+        "skip ws_meta", iterations,
+        [&f](size_t i)
+        {
+            f.next(i);
+            const wsrep::ws_meta ws_meta(make_ws_meta(f.meta));
+            if (not (ws_meta.seqno() <= f.hps.skip_below_))
+            {
+                BOOST_FAIL("Write set not skipped");
+            }
+        });
+    wsrep_bench::run(
+        "skip ws_meta_view", iterations,
+        [&f](size_t i)
+        {
+            f.next(i);
+            wsrep::ws_handle ws_handle(
+                wsrep::transaction_id(f.meta.stid.trx), &f);
+            const wsrep::ws_meta_view ws_meta_view(
+                f.meta.gtid.uuid, f.meta.gtid.seqno,
+                f.meta.stid.node, f.meta.stid.trx, f.meta.stid.conn,
+                f.meta.depends_on, flags);
+            if (f.hps.apply(ws_handle, ws_meta_view,
+                            wsrep::const_buffer(data, sizeof(data))))
+            {
+                BOOST_FAIL("Apply failed");
+            }
+        });
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file bench_utils.hpp
+ *
+ * Helpers for microbenchmark programs.
+ */
+
+#ifndef WSREP_BENCH_UTILS_HPP
+#define WSREP_BENCH_UTILS_HPP
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+namespace wsrep_bench
+{
+    /**
+     * Parse iteration count from the first command line argument.
+     */
+    inline size_t iterations(int argc, char* argv[], size_t default_value)
+    {
+        if (argc > 1)
+        {
+            return static_cast<size_t>(std::strtoull(argv[1], 0, 10));
+        }
+        return default_value;
+    }
+
+    /**
+     * Run function f for given number of iterations and print
+     * the average time per iteration.
+     *
+     * @return Average time per iteration in nanoseconds.
+     */
+    template <class F>
+    double run(const std::string& name, size_t iterations, F f)
+    {
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start(clock::now());
+        for (size_t i(0); i < iterations; ++i)
+        {
+            f(i);
+        }
+        const clock::duration elapsed(clock::now() - start);
+        const double ns_per_op(
+            double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       elapsed).count()) / double(iterations ? iterations : 1));
+        std::cout << std::left << std::setw(40) << name
+                  << std::right << std::setw(12) << iterations << " ops "
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << ns_per_op << " ns/op" << std::endl;
+        return ns_per_op;
+    }
+}
+
+#endif // WSREP_BENCH_UTILS_HPP
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file cond_bench.cpp
+ *
+ * Microbenchmark for client state wait channels.
+ *
+ * A number of bystander threads wait on the condition variable
+ * given to client state, as other sessions sharing the condition
+ * variable do. The client is then BF aborted in idle state and the
+ * rollback is completed, which notifies the rollback completion
+ * channel. The run is done with the condition variable given as the
+ * only one to client state and with separate condition variables for
+ * each wait reason. Context switches and bystander wakeups per
+ * rollback are reported.
+ *
+ * Usage: wsrep-lib_cond_bench [-- iterations]
+ */
+
+#define BOOST_TEST_MODULE wsrep-lib_cond_bench
+#include <boost/test/included/unit_test.hpp>
+
+#include "mock_server_state.hpp"
+#include "bench_utils.hpp"
+#include "test_utils.hpp"
+
+#include "wsrep/logger.hpp"
+
+#include <sys/resource.h> // getrusage()
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void discard_log(wsrep::log::level, const char*, const char*) { }
+
+    long context_switches()
+    {
+        struct rusage usage;
+        ::getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_nvcsw + usage.ru_nivcsw;
+    }
+
+    class bench_client
+        : public wsrep::mock_client_state
+        , public wsrep::mock_client_service
+    {
+    public:
+        bench_client(wsrep::server_state& server_state,
+                     wsrep::mutex& mutex,
+                     wsrep::condition_variable& cond,
+                     wsrep::condition_variable& rollback_complete_cond,
+                     wsrep::condition_variable& streaming_rollback_cond)
+            : wsrep::mock_client_state(server_state, *this,
+                                       wsrep::client_id(1),
+                                       wsrep::client_state::m_local,
+                                       mutex, cond, rollback_complete_cond,
+                                       streaming_rollback_cond)
+            , wsrep::mock_client_service(
+                static_cast<wsrep::mock_client_state*>(this))
+        { }
+    };
+
+    // Threads waiting on the shared condition variable.
+    class bystanders
+    {
+    public:
+        bystanders(wsrep::mutex& mutex, wsrep::condition_variable& cond,
+                   size_t n_threads)
+            : mutex_(mutex)
+            , cond_(cond)
+            , stop_()
+            , wakeups_()
+            , threads_()
+        {
+            for (size_t i(0); i < n_threads; ++i)
+            {
+                threads_.push_back(std::thread(&bystanders::run, this));
+            }
+        }
+
+        ~bystanders()
+        {
+            {
+                wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+                stop_ = true;
+                cond_.notify_all();
+            }
+            for (size_t i(0); i < threads_.size(); ++i)
+            {
+                threads_[i].join();
+            }
+        }
+
+        size_t wakeups() const { return wakeups_; }
+    private:
+        void run()
+        {
+            wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+            while (not stop_)
+            {
+                cond_.wait(lock);
+                ++wakeups_;
+            }
+        }
+        wsrep::mutex& mutex_;
+        wsrep::condition_variable& cond_;
+        bool stop_;
+        size_t wakeups_;
+        std::vector<std::thread> threads_;
+    };
+
+    struct server_fixture
+    {
+        server_fixture()
+            : server_service(&ss)
+            , ss("s1", wsrep::server_state::rm_sync, server_service)
+        {
+            ss.mock_connect();
+        }
+        wsrep::mock_server_service server_service;
+        wsrep::mock_server_state ss;
+    };
+
+    void rollback_cycle(bench_client& cc, size_t i)
+    {
+        cc.before_command();
+        cc.before_statement();
+        cc.start_transaction(wsrep::transaction_id(i + 1));
+        cc.after_statement();
+        cc.after_command_before_result();
+        cc.after_command_after_result();
+        wsrep_test::bf_abort_unordered(cc);
+        cc.sync_rollback_complete();
+        if (cc.before_command() != 1)
+        {
+            BOOST_FAIL("Transaction was not aborted");
+        }
+        cc.after_command_before_result();
+        cc.after_command_after_result();
+    }
+
+    void run(const std::string& name, size_t iterations, bool separate)
+    {
+        server_fixture f;
+        wsrep::mock_server_state& ss(f.ss);
+        wsrep::default_mutex mutex;
+        wsrep::default_condition_variable cond;
+        wsrep::default_condition_variable rollback_complete_cond;
+        wsrep::default_condition_variable streaming_rollback_cond;
+        bench_client cc(ss, mutex, cond,
+                        separate ? rollback_complete_cond : cond,
+                        separate ? streaming_rollback_cond : cond);
+        cc.open(cc.id());
+        size_t wakeups;
+        long switches;
+        {
+            bystanders b(mutex, cond, 4);
+            // Let bystanders reach the wait.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const long switches_before(context_switches());
+            wsrep_bench::run(name, iterations,
+                             [&cc](size_t i) { rollback_cycle(cc, i); });
+            switches = context_switches() - switches_before;
+            wsrep::unique_lock<wsrep::mutex> lock(mutex);
+            wakeups = b.wakeups();
+        }
+        const double n(double(iterations ? iterations : 1));
+        std::cout << "  context switches per rollback: "
+                  << double(switches) / n
+                  << ", bystander wakeups per rollback: "
+                  << double(wakeups) / n << std::endl;
+        cc.close();
+        cc.cleanup();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rollback_complete_wakeups)
+{
+    wsrep::log::logger_fn(discard_log);
+    const size_t iterations(
+        wsrep_bench::iterations(
+            boost::unit_test::framework::master_test_suite().argc,
+            boost::unit_test::framework::master_test_suite().argv,
+            100000));
+    run("rollback shared condition variable", iterations, false);
+    run("rollback per reason channels", iterations, true);
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/hot_key_detector.hpp"
+#include "wsrep/key.hpp"
+
+#include "client_state_fixture.hpp"
+#include "test_utils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <unistd.h> // usleep()
+
+namespace
+{
+    wsrep::hot_key_detector::hash_type hash(const char* row)
+    {
+        wsrep::key key(wsrep::key::exclusive);
+        key.append_key_part("db", 2);
+        key.append_key_part("t1", 2);
+        key.append_key_part(row, std::strlen(row));
+        return wsrep::hot_key_detector::hash(key);
+    }
+
+    bool acquire(wsrep::hot_key_detector& detector,
+                 const std::vector<wsrep::hot_key_detector::hash_type>& keys,
+                 std::vector<size_t>& slots,
+                 const wsrep::transaction& waiter,
+                 int timeout = 1)
+    {
+        wsrep::default_mutex mutex;
+        wsrep::unique_lock<wsrep::mutex> lock(mutex);
+        bool ret(detector.lock(keys, slots, waiter, lock, timeout));
+        BOOST_REQUIRE(lock.owns_lock());
+        return ret;
+    }
+
+    struct lock_thread_arg
+    {
+        wsrep::hot_key_detector* detector;
+        std::vector<wsrep::hot_key_detector::hash_type> keys;
+        std::vector<size_t> slots;
+        const wsrep::transaction* waiter;
+        bool locked;
+    };
+
+    void* lock_thread(void* ptr)
+    {
+        lock_thread_arg* arg(static_cast<lock_thread_arg*>(ptr));
+        arg->locked = acquire(*arg->detector, arg->keys, arg->slots,
+                              *arg->waiter, 60);
+        if (arg->locked) arg->detector->unlock(arg->slots);
+        return 0;
+    }
+
+    struct bf_abort_thread_arg
+    {
+        wsrep::client_state* victim;
+    };
+
+    void* bf_abort_thread(void* ptr)
+    {
+        bf_abort_thread_arg* arg(static_cast<bf_abort_thread_arg*>(ptr));
+        ::usleep(10000);
+        wsrep_test::bf_abort_unordered(*arg->victim);
+        return 0;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(hot_key_detector_detect_and_decay)
+{
+    wsrep::hot_key_detector detector(4, true, 8);
+    const std::vector<wsrep::hot_key_detector::hash_type> keys(1, hash("1"));
+    BOOST_REQUIRE(hash("1") != hash("2"));
+    for (size_t i(0); i < 3; ++i)
+    {
+        detector.record_conflict(keys);
+    }
+    BOOST_REQUIRE(detector.is_hot(hash("1")) == false);
+    detector.record_conflict(keys);
+    BOOST_REQUIRE(detector.is_hot(hash("1")));
+    BOOST_REQUIRE(detector.is_hot(hash("2")) == false);
+    BOOST_REQUIRE(detector.conflicts() == 4);
+
+    // Conflicts on other keys make the counters decay
+    const std::vector<wsrep::hot_key_detector::hash_type> other(
+        1, hash("2"));
+    for (size_t i(0); i < 4; ++i)
+    {
+        detector.record_conflict(other);
+    }
+    BOOST_REQUIRE(detector.is_hot(hash("1")) == false);
+}
+
+BOOST_FIXTURE_TEST_CASE(hot_key_detector_serialize,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    wsrep::hot_key_detector detector(1, true);
+    std::vector<wsrep::hot_key_detector::hash_type> keys;
+    keys.push_back(hash("1"));
+    keys.push_back(hash("2"));
+
+    // Cold keys are not locked
+    std::vector<size_t> slots;
+    BOOST_REQUIRE(acquire(detector, keys, slots, cc1.transaction()));
+    BOOST_REQUIRE(slots.empty());
+
+    detector.record_conflict(
+        std::vector<wsrep::hot_key_detector::hash_type>(1, hash("1")));
+    BOOST_REQUIRE(acquire(detector, keys, slots, cc1.transaction()));
+    BOOST_REQUIRE(slots.size() == 1);
+    BOOST_REQUIRE(detector.serialized() == 1);
+
+    lock_thread_arg arg = {
+        &detector, keys, std::vector<size_t>(), &cc2.transaction(), false };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, lock_thread, &arg) == 0);
+    ::usleep(10000);
+    BOOST_REQUIRE(arg.locked == false);
+    detector.unlock(slots);
+    BOOST_REQUIRE(slots.empty());
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(arg.locked);
+    BOOST_REQUIRE(detector.lock_waits() == 1);
+}
+
+//
+// Interrupted or timed out wait returns without key locks.
+//
+BOOST_FIXTURE_TEST_CASE(hot_key_detector_wait_interrupt,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    wsrep::hot_key_detector detector(1, true);
+    std::vector<wsrep::hot_key_detector::hash_type> keys;
+    keys.push_back(hash("1"));
+    detector.record_conflict(keys);
+    std::vector<size_t> slots;
+    BOOST_REQUIRE(acquire(detector, keys, slots, cc1.transaction()));
+    BOOST_REQUIRE(slots.size() == 1);
+
+    std::vector<size_t> waiter_slots;
+    BOOST_REQUIRE(acquire(detector, keys, waiter_slots, cc2.transaction(),
+                          0) == false);
+    BOOST_REQUIRE(waiter_slots.empty());
+
+    lock_thread_arg arg = {
+        &detector, keys, std::vector<size_t>(), &cc2.transaction(), false };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, lock_thread, &arg) == 0);
+    ::usleep(10000);
+    detector.interrupt(cc2.transaction());
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(arg.locked == false);
+    BOOST_REQUIRE(arg.slots.empty());
+    BOOST_REQUIRE(detector.serialized() == 1);
+    BOOST_REQUIRE(detector.lock_waits() == 0);
+
+    detector.unlock(slots);
+    BOOST_REQUIRE(acquire(detector, keys, slots, cc2.transaction()));
+    BOOST_REQUIRE(slots.size() == 1);
+    detector.unlock(slots);
+}
+
+//
+// Keys of transaction which fails certification are recorded
+// as conflicting.
+//
+BOOST_FIXTURE_TEST_CASE(hot_key_detector_cert_failure,
+                        replicating_client_fixture_sync_rm)
+{
+    sc.enable_hot_key_detector(1, true);
+    wsrep::hot_key_detector* detector(sc.hot_key_detector());
+    BOOST_REQUIRE(detector);
+
+    wsrep::key key(wsrep::key::exclusive);
+    key.append_key_part("db", 2);
+    key.append_key_part("t1", 2);
+    key.append_key_part("1", 1);
+
+    BOOST_REQUIRE(cc.start_transaction(wsrep::transaction_id(1)) == 0);
+    BOOST_REQUIRE(cc.append_key(key) == 0);
+    sc.provider().certify_result_ = wsrep::provider::error_certification_failed;
+    BOOST_REQUIRE(cc.before_commit());
+    BOOST_REQUIRE(tc.state() == wsrep::transaction::s_cert_failed);
+    BOOST_REQUIRE(cc.after_statement());
+    BOOST_REQUIRE(detector->conflicts() == 1);
+    BOOST_REQUIRE(detector->is_hot(wsrep::hot_key_detector::hash(key)));
+
+    cc.after_command_before_result();
+    cc.after_command_after_result();
+
+    // Next transaction on the same key takes local key lock and
+    // releases it at cleanup.
+    BOOST_REQUIRE(cc.before_command() == 0);
+    BOOST_REQUIRE(cc.before_statement() == 0);
+    sc.provider().certify_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc.start_transaction(wsrep::transaction_id(2)) == 0);
+    BOOST_REQUIRE(cc.append_key(key) == 0);
+    BOOST_REQUIRE(cc.before_commit() == 0);
+    BOOST_REQUIRE(detector->serialized() == 1);
+    BOOST_REQUIRE(cc.ordered_commit() == 0);
+    BOOST_REQUIRE(cc.after_commit() == 0);
+    BOOST_REQUIRE(cc.after_statement() == 0);
+
+    std::vector<size_t> slots;
+    BOOST_REQUIRE(acquire(*detector,
+                          std::vector<wsrep::hot_key_detector::hash_type>(
+                              1, wsrep::hot_key_detector::hash(key)),
+                          slots, tc));
+    BOOST_REQUIRE(slots.size() == 1);
+    BOOST_REQUIRE(detector->lock_waits() == 0);
+    detector->unlock(slots);
+}
+
+//
+// Transaction waiting for a hot key lock in certification is
+// BF aborted by an applier which needs its resources. BF abort
+// must interrupt the wait.
+//
+BOOST_FIXTURE_TEST_CASE(hot_key_detector_transaction_bf_abort,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    sc.enable_hot_key_detector(1, true);
+    wsrep::hot_key_detector* detector(sc.hot_key_detector());
+    wsrep::key key(wsrep::key::exclusive);
+    key.append_key_part("db", 2);
+    key.append_key_part("t1", 2);
+    key.append_key_part("1", 1);
+    detector->record_conflict(
+        std::vector<wsrep::hot_key_detector::hash_type>(
+            1, wsrep::hot_key_detector::hash(key)));
+
+    // First transaction holds the key lock until cleanup
+    BOOST_REQUIRE(cc1.start_transaction(wsrep::transaction_id(1)) == 0);
+    BOOST_REQUIRE(cc1.append_key(key) == 0);
+    BOOST_REQUIRE(cc1.before_commit() == 0);
+    BOOST_REQUIRE(detector->serialized() == 1);
+
+    BOOST_REQUIRE(cc2.start_transaction(wsrep::transaction_id(2)) == 0);
+    BOOST_REQUIRE(cc2.append_key(key) == 0);
+    bf_abort_thread_arg arg = { &cc2 };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, bf_abort_thread, &arg) == 0);
+    BOOST_REQUIRE(cc2.before_commit());
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(cc2.transaction().state() ==
+                  wsrep::transaction::s_must_abort);
+    BOOST_REQUIRE(cc2.current_error() == wsrep::e_deadlock_error);
+    cc2.after_statement();
+    BOOST_REQUIRE(cc2.transaction().state() == wsrep::transaction::s_aborted);
+    BOOST_REQUIRE(detector->serialized() == 1);
+
+    BOOST_REQUIRE(cc1.ordered_commit() == 0);
+    BOOST_REQUIRE(cc1.after_commit() == 0);
+    BOOST_REQUIRE(cc1.after_statement() == 0);
+}
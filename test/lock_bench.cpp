@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** @file lock_bench.cpp
+ *
+ * Microbenchmark for mutex lock/unlock paths.
+ *
+ * Compares lock/unlock pairs through wsrep::unique_lock for a mutex
+ * implementing the virtual interface out of line (as instrumented
+ * mutexes from integrators do), for wsrep::default_mutex through
+ * the wsrep::mutex interface and for wsrep::default_mutex directly,
+ * which avoids virtual dispatch. The mutex implementations are then
+ * used as client state mutex for a 1PC commit: the counting mutex,
+ * which also reports the number of lock/unlock pairs per commit,
+ * default_mutex wrapped behind the virtual interface and
+ * default_mutex, which client_state_lock calls directly.
+ *
+ * Usage: wsrep-lib_lock_bench [-- iterations]
+ */
+
+#define BOOST_TEST_MODULE wsrep-lib_lock_bench
+#include <boost/test/included/unit_test.hpp>
+
+#include "mock_server_state.hpp"
+#include "bench_utils.hpp"
+
+#include "wsrep/logger.hpp"
+
+namespace
+{
+    // Mock provider logs every call, discard log to keep formatting
+    // out of the measured commit path.
+    void discard_log(wsrep::log::level, const char*, const char*) { }
+
+    // Pthread mutex which counts lock calls.
+    class virtual_mutex : public wsrep::mutex
+    {
+    public:
+        virtual_mutex()
+            : wsrep::mutex()
+            , mutex_()
+            , locks_()
+        {
+            if (pthread_mutex_init(&mutex_, 0))
+            {
+                throw wsrep::runtime_error("mutex init failed");
+            }
+        }
+        ~virtual_mutex() WSREP_OVERRIDE { pthread_mutex_destroy(&mutex_); }
+        void lock() WSREP_OVERRIDE
+        {
+            if (pthread_mutex_lock(&mutex_))
+            {
+                throw wsrep::runtime_error("mutex lock failed");
+            }
+            ++locks_;
+        }
+        void unlock() WSREP_OVERRIDE
+        {
+            if (pthread_mutex_unlock(&mutex_))
+            {
+                throw wsrep::runtime_error("mutex unlock failed");
+            }
+        }
+        void* native() WSREP_OVERRIDE { return &mutex_; }
+        size_t locks() const { return locks_; }
+    private:
+        pthread_mutex_t mutex_;
+        size_t locks_;
+    };
+
+    // Default mutex behind the virtual interface, not recognized
+    // as wsrep::default_mutex by client_state_lock.
+    class wrapped_default_mutex : public wsrep::mutex
+    {
+    public:
+        wrapped_default_mutex() : wsrep::mutex(), mutex_() { }
+        void lock() WSREP_OVERRIDE { mutex_.lock(); }
+        void unlock() WSREP_OVERRIDE { mutex_.unlock(); }
+        void* native() WSREP_OVERRIDE { return mutex_.native(); }
+    private:
+        wsrep::default_mutex mutex_;
+    };
+
+    class bench_client
+        : public wsrep::mock_client_state
+        , public wsrep::mock_client_service
+    {
+    public:
+        bench_client(wsrep::server_state& server_state,
+                     wsrep::mutex& mutex)
+            : wsrep::mock_client_state(server_state, *this,
+                                       wsrep::client_id(1),
+                                       wsrep::client_state::m_local, mutex)
+            , wsrep::mock_client_service(
+                static_cast<wsrep::mock_client_state*>(this))
+        { }
+    };
+
+    struct commit_fixture
+    {
+        commit_fixture(wsrep::mutex& mutex)
+            : server_service(&ss)
+            , ss("s1", wsrep::server_state::rm_sync, server_service)
+            , cc(ss, mutex)
+        {
+            wsrep::log::logger_fn(discard_log);
+            ss.mock_connect();
+            cc.open(cc.id());
+        }
+
+        ~commit_fixture()
+        {
+            cc.close();
+            cc.cleanup();
+        }
+
+        void commit(size_t i)
+        {
+            cc.before_command();
+            cc.before_statement();
+            cc.start_transaction(wsrep::transaction_id(i + 1));
+            if (cc.before_commit() || cc.ordered_commit() ||
+                cc.after_commit())
+            {
+                BOOST_FAIL("Commit failed");
+            }
+            cc.after_statement();
+            cc.after_command_before_result();
+            cc.after_command_after_result();
+        }
+
+        wsrep::mock_server_service server_service;
+        wsrep::mock_server_state ss;
+        bench_client cc;
+    };
+
+    template <class M>
+    void lock_unlock(wsrep::mutex& mutex)
+    {
+        wsrep::unique_lock<M> lock(static_cast<M&>(mutex));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(lock_unlock_pairs)
+{
+    const size_t iterations(
+        wsrep_bench::iterations(
+            boost::unit_test::framework::master_test_suite().argc,
+            boost::unit_test::framework::master_test_suite().argv,
+            10000000));
+    virtual_mutex vm;
+    wsrep::default_mutex dm;
+    wsrep::mutex& vm_ref(vm);
+    wsrep::mutex& dm_ref(dm);
+    wsrep_bench::run(
+        "lock/unlock virtual", iterations,
+        [&vm_ref](size_t) { lock_unlock<wsrep::mutex>(vm_ref); });
+    wsrep_bench::run(
+        "lock/unlock default_mutex virtual", iterations,
+        [&dm_ref](size_t) { lock_unlock<wsrep::mutex>(dm_ref); });
+    wsrep_bench::run(
+        "lock/unlock default_mutex", iterations,
+        [&dm_ref](size_t) { lock_unlock<wsrep::default_mutex>(dm_ref); });
+}
+
+BOOST_AUTO_TEST_CASE(lock_unlock_commit)
+{
+    const size_t iterations(
+        wsrep_bench::iterations(
+            boost::unit_test::framework::master_test_suite().argc,
+            boost::unit_test::framework::master_test_suite().argv,
+            1000000) / 10);
+    {
+        virtual_mutex vm;
+        commit_fixture f(vm);
+        wsrep_bench::run("1pc commit virtual", iterations,
+                         [&f](size_t i) { f.commit(i); });
+        std::cout << "client state lock/unlock pairs per commit: "
+                  << double(vm.locks()) / double(iterations ? iterations : 1)
+                  << std::endl;
+    }
+    {
+        wrapped_default_mutex wm;
+        commit_fixture f(wm);
+        wsrep_bench::run("1pc commit default_mutex virtual", iterations,
+                         [&f](size_t i) { f.commit(i); });
+    }
+    {
+        wsrep::default_mutex dm;
+        commit_fixture f(dm);
+        wsrep_bench::run("1pc commit default_mutex", iterations,
+                         [&f](size_t i) { f.commit(i); });
+    }
+}
@@ -35,6 +35,33 @@ int wsrep::mock_client_service::bf_rollback()
     return ret;
 }
 
+int wsrep::mock_client_service::reexecute_statement()
+{
+    if (not is_autocommit_)
+    {
+        return 1;
+    }
+    ++retried_statements_;
+    /* Re-execute as a single statement autocommit transaction. */
+    if (client_state_->before_statement() == 0)
+    {
+        client_state_->start_transaction(
+            wsrep::transaction_id(1000 + retried_statements_));
+        if (client_state_->before_commit() == 0)
+        {
+            client_state_->ordered_commit();
+            client_state_->after_commit();
+        }
+        else
+        {
+            client_state_->before_rollback();
+            client_state_->after_rollback();
+        }
+        client_state_->after_statement();
+    }
+    return 0;
+}
+
 struct replayer_context
 {
     wsrep::mock_client_state state;
@@ -42,6 +42,32 @@ namespace wsrep
             , mutex_()
             , cond_()
         { }
+        /* Use mutex provided by the caller instead of default mutex. */
+        mock_client_state(wsrep::server_state& server_state,
+                          wsrep::client_service& client_service,
+                          const wsrep::client_id& id,
+                          enum wsrep::client_state::mode mode,
+                          wsrep::mutex& mutex)
+            : wsrep::client_state(mutex, cond_, server_state, client_service,
+                                  id, mode)
+            , mutex_()
+            , cond_()
+        { }
+        /* Use mutex and condition variables provided by the caller. */
+        mock_client_state(wsrep::server_state& server_state,
+                          wsrep::client_service& client_service,
+                          const wsrep::client_id& id,
+                          enum wsrep::client_state::mode mode,
+                          wsrep::mutex& mutex,
+                          wsrep::condition_variable& cond,
+                          wsrep::condition_variable& rollback_complete_cond,
+                          wsrep::condition_variable& streaming_rollback_cond)
+            : wsrep::client_state(mutex, cond, rollback_complete_cond,
+                                  streaming_rollback_cond, server_state,
+                                  client_service, id, mode)
+            , mutex_()
+            , cond_()
+        { }
         ~mock_client_state() WSREP_OVERRIDE
         {
             if (transaction().active())
@@ -78,7 +104,9 @@ namespace wsrep
             , will_replay_called_()
             , replays_()
             , unordered_replays_()
+            , replayer_waits_()
             , aborts_()
+            , retried_statements_()
         { }
         mock_client_service(const mock_client_service&) = delete;
         mock_client_service& operator=(const mock_client_service&) = delete;
@@ -125,6 +153,7 @@ namespace wsrep
             wsrep::unique_lock<wsrep::mutex>& lock)
             WSREP_OVERRIDE
         {
+            replayer_waits_++;
             lock.unlock();
             if (bf_abort_during_wait_)
             {
@@ -216,6 +245,13 @@ namespace wsrep
             // Not going to do this while unit testing
         }
 
+        bool is_retryable_statement() WSREP_OVERRIDE
+        {
+            return is_autocommit_;
+        }
+
+        int reexecute_statement() WSREP_OVERRIDE;
+
         //
         // Knobs to tune the behavior
         //
@@ -242,13 +278,17 @@ namespace wsrep
         bool will_replay_called() const { return will_replay_called_; }
         size_t replays() const { return replays_; }
         size_t unordered_replays() const { return unordered_replays_; }
+        size_t replayer_waits() const { return replayer_waits_; }
         size_t aborts() const { return aborts_; }
+        size_t retried_statements() const { return retried_statements_; }
     private:
         wsrep::mock_client_state* client_state_;
         bool will_replay_called_;
         size_t replays_;
         size_t unordered_replays_;
+        size_t replayer_waits_;
         size_t aborts_;
+        size_t retried_statements_;
     };
 
     class mock_client
@@ -26,6 +26,7 @@
 #include "wsrep/high_priority_service.hpp"
 
 #include <cstring>
+#include <unistd.h> // usleep()
 #include <map>
 #include <iostream> // todo: proper logging
 
@@ -45,6 +46,10 @@ namespace wsrep
             , commit_order_leave_result_()
             , release_result_()
             , replay_result_()
+            , causal_read_result_(wsrep::provider::error_not_implemented)
+            , causal_read_gtid_()
+            , causal_read_delay_us_()
+            , wait_for_gtid_result_(wsrep::provider::success)
             , group_id_("1")
             , server_id_("1")
             , group_seqno_(0)
@@ -264,12 +269,15 @@ namespace wsrep
         std::pair<wsrep::gtid, enum wsrep::provider::status>
         causal_read(int) const WSREP_OVERRIDE
         {
-            return std::make_pair(wsrep::gtid::undefined(),
-                                  wsrep::provider::error_not_implemented);
+            if (causal_read_delay_us_)
+            {
+                ::usleep(causal_read_delay_us_);
+            }
+            return std::make_pair(causal_read_gtid_, causal_read_result_);
         }
         enum wsrep::provider::status wait_for_gtid(const wsrep::gtid&,
             int) const WSREP_OVERRIDE
-        { return wsrep::provider::success; }
+        { return wait_for_gtid_result_; }
         wsrep::gtid last_committed_gtid() const WSREP_OVERRIDE
         { return wsrep::gtid(); }
         enum wsrep::provider::status sst_sent(const wsrep::gtid&, int)
@@ -331,6 +339,10 @@ namespace wsrep
         enum wsrep::provider::status commit_order_leave_result_;
         enum wsrep::provider::status release_result_;
         enum wsrep::provider::status replay_result_;
+        enum wsrep::provider::status causal_read_result_;
+        wsrep::gtid causal_read_gtid_;
+        useconds_t causal_read_delay_us_;
+        enum wsrep::provider::status wait_for_gtid_result_;
 
         size_t start_fragments() const { return start_fragments_; }
         size_t fragments() const { return fragments_; }
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/replay_gate.hpp"
+#include "wsrep/key.hpp"
+
+#include "client_state_fixture.hpp"
+#include "test_utils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <unistd.h> // usleep()
+
+namespace
+{
+    std::string encode(const char* p1, const char* p2 = 0,
+                       const char* p3 = 0)
+    {
+        wsrep::key key(wsrep::key::exclusive);
+        key.append_key_part(p1, std::strlen(p1));
+        if (p2) key.append_key_part(p2, std::strlen(p2));
+        if (p3) key.append_key_part(p3, std::strlen(p3));
+        return wsrep::replay_gate::encode(key);
+    }
+
+    wsrep::replay_gate::key_vector keys(const std::string& key)
+    {
+        return wsrep::replay_gate::key_vector(1, key);
+    }
+
+    struct wait_thread_arg
+    {
+        wsrep::replay_gate* gate;
+        wsrep::replay_gate::key_vector keys;
+        const wsrep::transaction* waiter;
+        bool done;
+        bool result;
+    };
+
+    void* wait_thread(void* ptr)
+    {
+        wait_thread_arg* arg(static_cast<wait_thread_arg*>(ptr));
+        wsrep::default_mutex mutex;
+        wsrep::unique_lock<wsrep::mutex> lock(mutex);
+        arg->result = arg->gate->wait(arg->keys, *arg->waiter, lock, 60);
+        arg->done = true;
+        return 0;
+    }
+
+    struct bf_abort_thread_arg
+    {
+        wsrep::replay_gate* gate;
+        wsrep::client_state* victim;
+    };
+
+    void* bf_abort_thread(void* ptr)
+    {
+        bf_abort_thread_arg* arg(static_cast<bf_abort_thread_arg*>(ptr));
+        while (arg->gate->waits() == 0)
+        {
+            ::usleep(1000);
+        }
+        wsrep_test::bf_abort_unordered(*arg->victim);
+        return 0;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(replay_gate_conflicts)
+{
+    wsrep::replay_gate gate;
+    const wsrep::replay_gate::key_vector replaying(
+        keys(encode("db", "t1", "1")));
+    BOOST_REQUIRE(gate.conflicts(replaying) == false);
+    gate.enter(replaying);
+    BOOST_REQUIRE(gate.replayers() == 1);
+
+    // Same key
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t1", "1"))));
+    // Less specific keys
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t1"))));
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db"))));
+    // Different row, table or schema
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t1", "2"))) == false);
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t2", "1"))) == false);
+    BOOST_REQUIRE(gate.conflicts(keys(encode("d", "bt1", "1"))) == false);
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t", "11"))) == false);
+
+    gate.leave(replaying);
+    BOOST_REQUIRE(gate.replayers() == 0);
+    BOOST_REQUIRE(gate.conflicts(replaying) == false);
+
+    // More specific key than the replaying one
+    gate.enter(keys(encode("db", "t1")));
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t1", "5"))));
+    BOOST_REQUIRE(gate.conflicts(keys(encode("db", "t2", "5"))) == false);
+    gate.leave(keys(encode("db", "t1")));
+}
+
+BOOST_FIXTURE_TEST_CASE(replay_gate_wait,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    wsrep::replay_gate gate;
+    const wsrep::replay_gate::key_vector replaying(keys(encode("db", "t1")));
+    gate.enter(replaying);
+
+    // Non-conflicting keys do not wait
+    {
+        wsrep::default_mutex mutex;
+        wsrep::unique_lock<wsrep::mutex> lock(mutex);
+        BOOST_REQUIRE(gate.wait(keys(encode("db", "t2")), tc, lock));
+        BOOST_REQUIRE(lock.owns_lock());
+    }
+    BOOST_REQUIRE(gate.waits() == 0);
+
+    wait_thread_arg arg = {
+        &gate, keys(encode("db", "t1", "1")), &tc, false, false };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, wait_thread, &arg) == 0);
+    while (gate.waits() == 0)
+    {
+        ::usleep(1000);
+    }
+    BOOST_REQUIRE(arg.done == false);
+    gate.leave(replaying);
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(arg.done);
+    BOOST_REQUIRE(arg.result);
+    BOOST_REQUIRE(gate.waits() == 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(replay_gate_wait_interrupt,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    wsrep::replay_gate gate;
+    const wsrep::replay_gate::key_vector replaying(keys(encode("db", "t1")));
+    gate.enter(replaying);
+    // Interrupting transaction which does not wait has no effect
+    gate.interrupt(tc);
+
+    wait_thread_arg arg = {
+        &gate, keys(encode("db", "t1", "1")), &tc, false, true };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, wait_thread, &arg) == 0);
+    while (gate.waits() == 0)
+    {
+        ::usleep(1000);
+    }
+    gate.interrupt(tc);
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(arg.done);
+    BOOST_REQUIRE(arg.result == false);
+    BOOST_REQUIRE(gate.conflicts(arg.keys));
+    gate.leave(replaying);
+}
+
+//
+// Replaying transaction holds the gate only for its own keys
+// while replay is pending.
+//
+BOOST_FIXTURE_TEST_CASE(replay_gate_transaction,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    sc.enable_replay_gate();
+    wsrep::replay_gate* gate(sc.replay_gate());
+    BOOST_REQUIRE(gate);
+
+    wsrep::key key1(wsrep::key::exclusive);
+    key1.append_key_part("db", 2);
+    key1.append_key_part("t1", 2);
+    key1.append_key_part("1", 1);
+    wsrep::key key2(wsrep::key::exclusive);
+    key2.append_key_part("db", 2);
+    key2.append_key_part("t1", 2);
+    key2.append_key_part("2", 1);
+
+    BOOST_REQUIRE(cc1.start_transaction(wsrep::transaction_id(1)) == 0);
+    BOOST_REQUIRE(cc1.append_key(key1) == 0);
+    sc.provider().certify_result_ = wsrep::provider::error_bf_abort;
+    sc.provider().replay_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc1.before_commit());
+    BOOST_REQUIRE(tc.state() == wsrep::transaction::s_must_replay);
+    BOOST_REQUIRE(gate->replayers() == 1);
+    BOOST_REQUIRE(gate->conflicts(keys(wsrep::replay_gate::encode(key1))));
+
+    // Transaction with non-overlapping keys commits without waiting
+    sc.provider().certify_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc2.start_transaction(wsrep::transaction_id(2)) == 0);
+    BOOST_REQUIRE(cc2.append_key(key2) == 0);
+    BOOST_REQUIRE(cc2.before_commit() == 0);
+    BOOST_REQUIRE(cc2.ordered_commit() == 0);
+    BOOST_REQUIRE(cc2.after_commit() == 0);
+    BOOST_REQUIRE(cc2.after_statement() == 0);
+    BOOST_REQUIRE(gate->waits() == 0);
+    // Gate replaces the global wait for replayers
+    BOOST_REQUIRE(cc2.replayer_waits() == 0);
+
+    BOOST_REQUIRE(cc1.after_statement() == 0);
+    BOOST_REQUIRE(tc.state() == wsrep::transaction::s_committed);
+    BOOST_REQUIRE(gate->replayers() == 0);
+}
+
+//
+// Transaction waiting for a replayer in certification is BF aborted
+// by the replayer. BF abort must interrupt the wait.
+//
+BOOST_FIXTURE_TEST_CASE(replay_gate_transaction_bf_abort,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    sc.enable_replay_gate();
+    wsrep::replay_gate* gate(sc.replay_gate());
+
+    wsrep::key key1(wsrep::key::exclusive);
+    key1.append_key_part("db", 2);
+    key1.append_key_part("t1", 2);
+    key1.append_key_part("1", 1);
+
+    BOOST_REQUIRE(cc1.start_transaction(wsrep::transaction_id(1)) == 0);
+    BOOST_REQUIRE(cc1.append_key(key1) == 0);
+    sc.provider().certify_result_ = wsrep::provider::error_bf_abort;
+    sc.provider().replay_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc1.before_commit());
+    BOOST_REQUIRE(tc.state() == wsrep::transaction::s_must_replay);
+
+    sc.provider().certify_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc2.start_transaction(wsrep::transaction_id(2)) == 0);
+    BOOST_REQUIRE(cc2.append_key(key1) == 0);
+    bf_abort_thread_arg arg = { gate, &cc2 };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, bf_abort_thread, &arg) == 0);
+    BOOST_REQUIRE(cc2.before_commit());
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(gate->waits() == 1);
+    BOOST_REQUIRE(cc2.transaction().state() ==
+                  wsrep::transaction::s_must_abort);
+    BOOST_REQUIRE(cc2.current_error() == wsrep::e_deadlock_error);
+    cc2.after_statement();
+    BOOST_REQUIRE(cc2.transaction().state() == wsrep::transaction::s_aborted);
+
+    BOOST_REQUIRE(cc1.after_statement() == 0);
+    BOOST_REQUIRE(tc.state() == wsrep::transaction::s_committed);
+    BOOST_REQUIRE(gate->replayers() == 0);
+}
@@ -240,6 +240,26 @@ BOOST_FIXTURE_TEST_CASE(server_state_applying_1pc,
         "Transaction state " << txc.state() << " not committed");
 }
 
+// Test apply through ws_meta_view
+BOOST_FIXTURE_TEST_CASE(server_state_applying_1pc_meta_view,
+                        applying_server_fixture)
+{
+    wsrep::ws_meta_view ws_meta_view(
+        ws_meta.group_id().data(), ws_meta.seqno().get(),
+        ws_meta.server_id().data(), ws_meta.transaction_id().get(),
+        ws_meta.client_id().get(), ws_meta.depends_on().get(),
+        ws_meta.flags());
+    BOOST_REQUIRE(ws_meta_view.seqno() == ws_meta.seqno());
+    BOOST_REQUIRE(ws_meta_view.server_id() == ws_meta.server_id());
+    BOOST_REQUIRE(ws_meta_view.transaction_id() == ws_meta.transaction_id());
+    BOOST_REQUIRE(ws_meta_view.ws_meta() == ws_meta);
+    char buf[1] = { 1 };
+    BOOST_REQUIRE(hps.apply(ws_handle, ws_meta_view,
+                            wsrep::const_buffer(buf, 1)) == 0);
+    const wsrep::transaction& txc(cc.transaction());
+    BOOST_REQUIRE(txc.state() == wsrep::transaction::s_committed);
+}
+
 // Test on_apply() method for 2pc
 BOOST_FIXTURE_TEST_CASE(server_state_applying_2pc,
                         applying_server_fixture)
@@ -888,6 +908,73 @@ BOOST_FIXTURE_TEST_CASE(server_state_equal_consecutive_views,
                       meta_s3.server_id(), meta_s3.transaction_id()));
 }
 
+// Test that all orphaned streaming appliers are closed in one view
+// change when there are several of them, interleaved with streaming
+// appliers which are not orphaned.
+BOOST_FIXTURE_TEST_CASE(server_state_close_many_orphaned_transactions,
+                        sst_first_server_fixture)
+{
+    connect_in_view(third_view);
+    server_service.logged_view(third_view);
+    sst_received_action();
+    ss.on_view(third_view, &hps);
+
+    std::vector<wsrep::view::member> members(ss.current_view().members());
+
+    const unsigned long long n_transactions(10);
+    long long seqno(0);
+    for (unsigned long long i(1); i <= n_transactions; ++i)
+    {
+        const char* servers[] = { "s2", "s3" };
+        for (size_t s(0); s < 2; ++s)
+        {
+            ++seqno;
+            wsrep::ws_meta meta(wsrep::gtid(wsrep::id(servers[s]),
+                                            wsrep::seqno(seqno)),
+                                wsrep::stid(wsrep::id(servers[s]),
+                                            wsrep::transaction_id(i),
+                                            wsrep::client_id(1)),
+                                wsrep::seqno(seqno),
+                                wsrep::provider::flag::start_transaction);
+            BOOST_REQUIRE(ss.on_apply(hps, ws_handle, meta,
+                                      wsrep::const_buffer("1", 1)) == 0);
+        }
+    }
+
+    // s3 drops out of the cluster, deliver primary view (s1, s2)
+    members.pop_back();
+    ss.on_view(wsrep::view(ss.current_view().state_id(),
+                           ss.current_view().view_seqno() + 1,
+                           wsrep::view::primary,
+                           0, // capabilities
+                           0, // own index
+                           1, // protocol version
+                           members), &hps);
+
+    for (unsigned long long i(1); i <= n_transactions; ++i)
+    {
+        BOOST_REQUIRE(ss.find_streaming_applier(
+                          wsrep::id("s2"), wsrep::transaction_id(i)));
+        BOOST_REQUIRE(not ss.find_streaming_applier(
+                          wsrep::id("s3"), wsrep::transaction_id(i)));
+    }
+
+    // deliver primary view with the same members, all remaining
+    // streaming appliers are closed
+    ss.on_view(wsrep::view(ss.current_view().state_id(),
+                           ss.current_view().view_seqno() + 1,
+                           wsrep::view::primary,
+                           0, // capabilities
+                           0, // own index
+                           1, // protocol version
+                           members), &hps);
+    for (unsigned long long i(1); i <= n_transactions; ++i)
+    {
+        BOOST_REQUIRE(not ss.find_streaming_applier(
+                          wsrep::id("s2"), wsrep::transaction_id(i)));
+    }
+}
+
 // Verify that prepared XA transactions are not rolled back
 // by close_orphaned_transactions()
 BOOST_FIXTURE_TEST_CASE(server_state_xa_not_orphaned,
@@ -958,3 +1045,163 @@ BOOST_FIXTURE_TEST_CASE(server_state_xa_not_orphaned,
     BOOST_REQUIRE(not ss.find_streaming_applier(
                       meta_commit_s3.server_id(), meta_commit_s3.transaction_id()));
 }
+
+///////////////////////////////////////////////////////////////////////////////
+//                             Causal read                                   //
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct causal_read_thread_arg
+    {
+        const wsrep::server_state* ss;
+        std::pair<wsrep::gtid, enum wsrep::provider::status> result;
+    };
+
+    void* causal_read_thread(void* ptr)
+    {
+        causal_read_thread_arg* arg(static_cast<causal_read_thread_arg*>(ptr));
+        arg->result = arg->ss->causal_read(1);
+        return 0;
+    }
+}
+
+// Sequential causal reads are all issued to provider
+BOOST_FIXTURE_TEST_CASE(server_state_causal_read_sequential,
+                        server_fixture_base)
+{
+    const wsrep::gtid gtid(wsrep::id("1"), wsrep::seqno(5));
+    ss.provider().causal_read_result_ = wsrep::provider::success;
+    ss.provider().causal_read_gtid_ = gtid;
+    for (size_t i(0); i < 3; ++i)
+    {
+        std::pair<wsrep::gtid, enum wsrep::provider::status> result(
+            ss.causal_read(1));
+        BOOST_REQUIRE(result.second == wsrep::provider::success);
+        BOOST_REQUIRE(result.first == gtid);
+    }
+    BOOST_REQUIRE(ss.causal_reads_issued() == 3);
+    BOOST_REQUIRE(ss.causal_reads_coalesced() == 0);
+
+    ss.provider().causal_read_result_ = wsrep::provider::error_connection_failed;
+    BOOST_REQUIRE(ss.causal_read(1).second ==
+                  wsrep::provider::error_connection_failed);
+}
+
+// Concurrent causal reads share the result of causal read issued
+// by another caller
+BOOST_FIXTURE_TEST_CASE(server_state_causal_read_coalesce,
+                        server_fixture_base)
+{
+    const wsrep::gtid gtid(wsrep::id("1"), wsrep::seqno(5));
+    ss.provider().causal_read_result_ = wsrep::provider::success;
+    ss.provider().causal_read_gtid_ = gtid;
+    ss.provider().causal_read_delay_us_ = 50000;
+
+    const size_t n_threads(8);
+    std::vector<causal_read_thread_arg> args(n_threads);
+    std::vector<pthread_t> threads(n_threads);
+    for (size_t i(0); i < n_threads; ++i)
+    {
+        args[i].ss = &ss;
+        BOOST_REQUIRE(pthread_create(&threads[i], 0, causal_read_thread,
+                                     &args[i]) == 0);
+    }
+    for (size_t i(0); i < n_threads; ++i)
+    {
+        pthread_join(threads[i], 0);
+        BOOST_REQUIRE(args[i].result.second == wsrep::provider::success);
+        BOOST_REQUIRE(args[i].result.first == gtid);
+    }
+    BOOST_REQUIRE(ss.causal_reads_issued() + ss.causal_reads_coalesced() ==
+                  n_threads);
+    BOOST_REQUIRE(ss.causal_reads_issued() < n_threads);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                        Local GTID watermark                               //
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    struct wait_for_gtid_thread_arg
+    {
+        const wsrep::server_state* ss;
+        wsrep::gtid gtid;
+        enum wsrep::provider::status result;
+    };
+
+    void* wait_for_gtid_thread(void* ptr)
+    {
+        wait_for_gtid_thread_arg* arg(
+            static_cast<wait_for_gtid_thread_arg*>(ptr));
+        arg->result = arg->ss->wait_for_gtid(arg->gtid, 1);
+        return 0;
+    }
+}
+
+// Waiting for GTID which has been committed by applier is resolved
+// without calling provider
+BOOST_FIXTURE_TEST_CASE(server_state_wait_for_gtid_committed,
+                        applying_server_fixture)
+{
+    ss.provider().wait_for_gtid_result_ = wsrep::provider::error_not_allowed;
+    char buf[1] = { 1 };
+    BOOST_REQUIRE(ss.on_apply(hps, ws_handle, ws_meta,
+                              wsrep::const_buffer(buf, 1)) == 0);
+    BOOST_REQUIRE(ss.committed_gtid() == ws_meta.gtid());
+    BOOST_REQUIRE(ss.wait_for_gtid(ws_meta.gtid(), 1) ==
+                  wsrep::provider::success);
+    // Seqno beyond watermark goes to provider
+    BOOST_REQUIRE(ss.wait_for_gtid(
+                      wsrep::gtid(ws_meta.group_id(), wsrep::seqno(2)), 1) ==
+                  wsrep::provider::error_not_allowed);
+    // Different history goes to provider
+    BOOST_REQUIRE(ss.wait_for_gtid(
+                      wsrep::gtid(wsrep::id("2"), wsrep::seqno(1)), 1) ==
+                  wsrep::provider::error_not_allowed);
+}
+
+// Waiters for seqnos in commit order are woken up when the commit
+// order is released
+BOOST_FIXTURE_TEST_CASE(server_state_wait_for_gtid_in_commit_order,
+                        server_fixture_base)
+{
+    ss.provider().wait_for_gtid_result_ = wsrep::provider::error_not_allowed;
+    const wsrep::id group_id("1");
+    ss.commit_order_entered(wsrep::gtid(group_id, wsrep::seqno(3)));
+    BOOST_REQUIRE(ss.committed_gtid() ==
+                  wsrep::gtid(group_id, wsrep::seqno(2)));
+    BOOST_REQUIRE(ss.wait_for_gtid(wsrep::gtid(group_id, wsrep::seqno(2)), 1)
+                  == wsrep::provider::success);
+
+    wait_for_gtid_thread_arg arg = {
+        &ss, wsrep::gtid(group_id, wsrep::seqno(3)),
+        wsrep::provider::error_unknown };
+    pthread_t thread;
+    BOOST_REQUIRE(pthread_create(&thread, 0, wait_for_gtid_thread, &arg) == 0);
+    ::usleep(10000);
+    ss.commit_order_left(wsrep::gtid(group_id, wsrep::seqno(3)));
+    pthread_join(thread, 0);
+    BOOST_REQUIRE(arg.result == wsrep::provider::success);
+    BOOST_REQUIRE(ss.committed_gtid() ==
+                  wsrep::gtid(group_id, wsrep::seqno(3)));
+}
+
+// Local wait for seqno in commit order times out if commit order
+// is not released
+BOOST_FIXTURE_TEST_CASE(server_state_wait_for_gtid_in_commit_order_timeout,
+                        server_fixture_base)
+{
+    ss.provider().wait_for_gtid_result_ = wsrep::provider::error_not_allowed;
+    const wsrep::id group_id("1");
+    ss.commit_order_entered(wsrep::gtid(group_id, wsrep::seqno(3)));
+    BOOST_REQUIRE(ss.wait_for_gtid(wsrep::gtid(group_id, wsrep::seqno(3)), 1)
+                  == wsrep::provider::error_transaction_missing);
+    // Timed out waiter must have been removed from the waiter queue.
+    ss.commit_order_left(wsrep::gtid(group_id, wsrep::seqno(3)));
+    BOOST_REQUIRE(ss.committed_gtid() ==
+                  wsrep::gtid(group_id, wsrep::seqno(3)));
+    BOOST_REQUIRE(ss.wait_for_gtid(wsrep::gtid(group_id, wsrep::seqno(3)), 1)
+                  == wsrep::provider::success);
+}
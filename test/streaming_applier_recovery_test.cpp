@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2024 Codership Oy <info@codership.com>
+ *
+ * This file is part of wsrep-lib.
+ *
+ * Wsrep-lib is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Wsrep-lib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with wsrep-lib.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "wsrep/streaming_applier_recovery.hpp"
+
+#include "mock_server_state.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+namespace
+{
+    // Recoverer which constructs mock streaming appliers. Mock server
+    // service is not thread safe, so construction is serialized.
+    class mock_recoverer : public wsrep::streaming_applier_recovery::recoverer
+    {
+    public:
+        mock_recoverer(wsrep::mock_server_service& server_service,
+                       wsrep::high_priority_service& hps)
+            : server_service_(server_service)
+            , hps_(hps)
+            , mutex_()
+            , fail_transaction_id_()
+            , throw_unknown_()
+        { }
+        wsrep::high_priority_service* recover(
+            const wsrep::streaming_applier_recovery::job& job)
+            WSREP_OVERRIDE
+        {
+            if (job.transaction_id == fail_transaction_id_)
+            {
+                if (throw_unknown_) throw 1;
+                throw wsrep::runtime_error("Fragment storage error");
+            }
+            wsrep::unique_lock<wsrep::mutex> lock(mutex_);
+            return server_service_.streaming_applier_service(hps_);
+        }
+        wsrep::mock_server_service& server_service_;
+        wsrep::high_priority_service& hps_;
+        wsrep::default_mutex mutex_;
+        wsrep::transaction_id fail_transaction_id_;
+        // Throw exception not derived from std::exception
+        bool throw_unknown_;
+    };
+
+    struct streaming_applier_recovery_fixture
+    {
+        streaming_applier_recovery_fixture()
+            : server_service(&ss)
+            , ss("s1", wsrep::server_state::rm_sync, server_service)
+            , cc(ss, wsrep::client_id(1),
+                 wsrep::client_state::m_high_priority)
+            , hps(ss, &cc, false)
+            , recoverer(server_service, hps)
+            , jobs()
+        {
+            for (unsigned long long i(1); i <= 100; ++i)
+            {
+                jobs.push_back(wsrep::streaming_applier_recovery::job(
+                                   wsrep::id("s2"), wsrep::transaction_id(i)));
+            }
+        }
+
+        void release_appliers()
+        {
+            for (size_t i(0); i < jobs.size(); ++i)
+            {
+                wsrep::high_priority_service* sa(
+                    ss.find_streaming_applier(jobs[i].server_id,
+                                              jobs[i].transaction_id));
+                if (sa)
+                {
+                    // Appliers were constructed in worker threads,
+                    // take ownership before releasing.
+                    static_cast<wsrep::mock_high_priority_service*>(sa)
+                        ->client_state().store_globals();
+                    ss.stop_streaming_applier(jobs[i].server_id,
+                                              jobs[i].transaction_id);
+                    server_service.release_high_priority_service(sa);
+                }
+            }
+        }
+
+        wsrep::mock_server_service server_service;
+        wsrep::mock_server_state ss;
+        wsrep::mock_client cc;
+        wsrep::mock_high_priority_service hps;
+        mock_recoverer recoverer;
+        std::vector<wsrep::streaming_applier_recovery::job> jobs;
+    };
+}
+
+BOOST_FIXTURE_TEST_CASE(streaming_applier_recovery_parallel,
+                        streaming_applier_recovery_fixture)
+{
+    wsrep::streaming_applier_recovery recovery(ss, 4, 0);
+    BOOST_REQUIRE(recovery.run(jobs, recoverer) == 0);
+    BOOST_REQUIRE(recovery.recovered() == jobs.size());
+    for (size_t i(0); i < jobs.size(); ++i)
+    {
+        BOOST_REQUIRE(ss.find_streaming_applier(jobs[i].server_id,
+                                                jobs[i].transaction_id));
+    }
+    release_appliers();
+}
+
+BOOST_FIXTURE_TEST_CASE(streaming_applier_recovery_failure,
+                        streaming_applier_recovery_fixture)
+{
+    recoverer.fail_transaction_id_ = wsrep::transaction_id(50);
+    wsrep::streaming_applier_recovery recovery(ss, 4, 0);
+    BOOST_REQUIRE(recovery.run(jobs, recoverer) == 1);
+    BOOST_REQUIRE(recovery.recovered() == jobs.size() - 1);
+    BOOST_REQUIRE(ss.find_streaming_applier(
+                      wsrep::id("s2"), wsrep::transaction_id(50)) == 0);
+    BOOST_REQUIRE(ss.find_streaming_applier(
+                      wsrep::id("s2"), wsrep::transaction_id(51)));
+    release_appliers();
+}
+
+BOOST_FIXTURE_TEST_CASE(streaming_applier_recovery_failure_unknown_exception,
+                        streaming_applier_recovery_fixture)
+{
+    recoverer.fail_transaction_id_ = wsrep::transaction_id(50);
+    recoverer.throw_unknown_ = true;
+    wsrep::streaming_applier_recovery recovery(ss, 4, 0);
+    BOOST_REQUIRE(recovery.run(jobs, recoverer) == 1);
+    BOOST_REQUIRE(recovery.recovered() == jobs.size() - 1);
+    BOOST_REQUIRE(ss.find_streaming_applier(
+                      wsrep::id("s2"), wsrep::transaction_id(50)) == 0);
+    release_appliers();
+}
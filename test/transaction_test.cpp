@@ -19,12 +19,17 @@
 
 #include "wsrep/transaction.hpp"
 #include "wsrep/provider.hpp"
+#include "wsrep/lazy.hpp"
+#include "wsrep/sr_key_set.hpp"
+#include "wsrep/xid.hpp"
 
 #include "test_utils.hpp"
 #include "client_state_fixture.hpp"
 
 #include <boost/mpl/vector.hpp>
 
+#include <chrono>
+
 namespace
 {
     typedef
@@ -33,6 +38,34 @@ namespace
     replicating_fixtures;
 }
 
+//
+// Idle client state footprint. Streaming context, SR keys, key
+// tracking, XID and TOI/NBO metadata are allocated only when used,
+// each takes a pointer until then.
+//
+BOOST_AUTO_TEST_CASE(client_state_footprint)
+{
+    // Upper bounds for LP64 targets, update when adding members.
+    if (sizeof(void*) == 8)
+    {
+        BOOST_REQUIRE(sizeof(wsrep::transaction) <= 272);
+        BOOST_REQUIRE(sizeof(wsrep::client_state) <= 512);
+    }
+    BOOST_REQUIRE(sizeof(wsrep::lazy<wsrep::streaming_context>) ==
+                  sizeof(void*));
+    BOOST_REQUIRE(sizeof(wsrep::lazy<wsrep::sr_key_set>) == sizeof(void*));
+    BOOST_REQUIRE(sizeof(wsrep::lazy<wsrep::xid>) == sizeof(void*));
+    BOOST_REQUIRE(sizeof(wsrep::lazy<wsrep::ws_meta>) == sizeof(void*));
+
+    wsrep::lazy<wsrep::streaming_context> streaming_context;
+    BOOST_REQUIRE(streaming_context.get().fragment_size() == 0);
+    BOOST_REQUIRE(streaming_context.allocated() == false);
+    streaming_context.mut().enable(wsrep::streaming_context::row, 1);
+    BOOST_REQUIRE(streaming_context.allocated());
+    streaming_context.reset();
+    BOOST_REQUIRE(streaming_context.get().fragment_size() == 0);
+}
+
 BOOST_FIXTURE_TEST_CASE(transaction_append_key_data,
                         replicating_client_fixture_sync_rm)
 {
@@ -1162,6 +1195,150 @@ BOOST_FIXTURE_TEST_CASE(transaction_keep_error_bf_idle_sync_rm,
     BOOST_REQUIRE(cc.current_error() == wsrep::e_success);
 }
 
+//
+// Test bulk BF abort of idle and executing victims. Idle victim
+// is handed to background rollbacker, executing victim rolls back
+// itself.
+//
+BOOST_FIXTURE_TEST_CASE(transaction_bulk_bf_abort,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    cc1.start_transaction(wsrep::transaction_id(1));
+    cc1.after_statement();
+    cc1.after_command_before_result();
+    cc1.after_command_after_result();
+    BOOST_REQUIRE(cc1.state() == wsrep::client_state::s_idle);
+
+    cc2.start_transaction(wsrep::transaction_id(2));
+    BOOST_REQUIRE(cc2.state() == wsrep::client_state::s_exec);
+
+    std::vector<wsrep::client_state*> victims;
+    victims.push_back(&cc1);
+    victims.push_back(&cc2);
+    BOOST_REQUIRE(sc.bf_abort(victims, wsrep::seqno(1), false) == 2);
+    cc1.sync_rollback_complete();
+    BOOST_REQUIRE(cc1.transaction().state() == wsrep::transaction::s_aborted);
+    BOOST_REQUIRE(cc2.transaction().state() ==
+                  wsrep::transaction::s_must_abort);
+
+    BOOST_REQUIRE(cc1.before_command() == 1);
+    BOOST_REQUIRE(cc1.current_error() == wsrep::e_deadlock_error);
+    cc1.after_command_before_result();
+    cc1.after_command_after_result();
+
+    BOOST_REQUIRE(cc2.after_statement());
+    BOOST_REQUIRE(cc2.transaction().state() == wsrep::transaction::s_aborted);
+    BOOST_REQUIRE(cc2.current_error() == wsrep::e_deadlock_error);
+
+    // Victims which are not active are not aborted
+    BOOST_REQUIRE(sc.bf_abort(victims, wsrep::seqno(2), false) == 0);
+}
+
+//
+// Test that local transactions are registered in client registry
+// at start and unregistered at cleanup
+//
+BOOST_FIXTURE_TEST_CASE(transaction_client_registry,
+                        replicating_two_clients_fixture_sync_rm)
+{
+    BOOST_REQUIRE(sc.client_registry() == 0);
+    sc.enable_client_registry(4);
+    wsrep::client_registry* registry(sc.client_registry());
+    BOOST_REQUIRE(registry);
+
+    cc1.start_transaction(wsrep::transaction_id(1));
+    cc2.start_transaction(wsrep::transaction_id(2));
+    BOOST_REQUIRE(registry->size() == 2);
+    BOOST_REQUIRE(registry->find(wsrep::transaction_id(1)) == &cc1);
+    BOOST_REQUIRE(registry->find(wsrep::transaction_id(2)) == &cc2);
+    BOOST_REQUIRE(registry->find(cc1.id()) == &cc1);
+    BOOST_REQUIRE(registry->find(cc2.id()) == &cc2);
+    BOOST_REQUIRE(registry->find(wsrep::transaction_id(3)) == 0);
+
+    size_t count(0);
+    registry->for_each([&count](wsrep::client_state&) { ++count; });
+    BOOST_REQUIRE(count == 2);
+
+    std::vector<wsrep::transaction_id> ids;
+    ids.push_back(wsrep::transaction_id(2));
+    ids.push_back(wsrep::transaction_id(3));
+    ids.push_back(wsrep::transaction_id(1));
+    std::vector<wsrep::client_state*> found;
+    registry->with_transactions(
+        ids, [&found](const std::vector<wsrep::client_state*>& victims)
+             { found = victims; });
+    BOOST_REQUIRE(found.size() == 2);
+    BOOST_REQUIRE(found[0] == &cc2);
+    BOOST_REQUIRE(found[1] == &cc1);
+
+    BOOST_REQUIRE(cc1.before_commit() == 0);
+    BOOST_REQUIRE(cc1.ordered_commit() == 0);
+    BOOST_REQUIRE(cc1.after_commit() == 0);
+    BOOST_REQUIRE(cc1.after_statement() == 0);
+    BOOST_REQUIRE(registry->find(wsrep::transaction_id(1)) == 0);
+    BOOST_REQUIRE(registry->find(cc1.id()) == 0);
+
+    cc2.bf_abort(wsrep::seqno(1));
+    BOOST_REQUIRE(registry->find(wsrep::transaction_id(2)) == &cc2);
+    BOOST_REQUIRE(cc2.after_statement());
+    BOOST_REQUIRE(registry->size() == 0);
+}
+
+//
+// Test retrying autocommit statement after certification failure
+//
+BOOST_FIXTURE_TEST_CASE(transaction_retry_statement,
+                        replicating_client_fixture_autocommit)
+{
+    // Retry policy disabled by default.
+    cc.start_transaction(wsrep::transaction_id(1));
+    sc.provider().certify_result_ = wsrep::provider::error_certification_failed;
+    BOOST_REQUIRE(cc.before_commit());
+    BOOST_REQUIRE(cc.before_rollback() == 0);
+    BOOST_REQUIRE(cc.after_rollback() == 0);
+    BOOST_REQUIRE(cc.after_statement());
+    BOOST_REQUIRE(cc.current_error() == wsrep::e_deadlock_error);
+    BOOST_REQUIRE(cc.retry_statement());
+    BOOST_REQUIRE(cc.retried_statements() == 0);
+    BOOST_REQUIRE(cc.statement_retries() == 0);
+
+    // Not retryable, fails without backing off.
+    cc.set_retry_policy(
+        wsrep::client_state::retry_policy(3, 10000000, 10000000));
+    cc.is_autocommit_ = false;
+    const std::chrono::steady_clock::time_point start(
+        std::chrono::steady_clock::now());
+    BOOST_REQUIRE(cc.retry_statement());
+    BOOST_REQUIRE(std::chrono::steady_clock::now() - start <
+                  std::chrono::seconds(1));
+    BOOST_REQUIRE(cc.current_error() == wsrep::e_deadlock_error);
+    BOOST_REQUIRE(cc.retried_statements() == 0);
+    BOOST_REQUIRE(cc.statement_retries() == 0);
+    cc.is_autocommit_ = true;
+    cc.set_retry_policy(wsrep::client_state::retry_policy(3, 1, 4));
+
+    // Keeps failing until attempts are exhausted.
+    BOOST_REQUIRE(cc.retry_statement());
+    BOOST_REQUIRE(cc.current_error() == wsrep::e_deadlock_error);
+    BOOST_REQUIRE(tc.active() == false);
+    BOOST_REQUIRE(cc.retried_statements() == 3);
+    BOOST_REQUIRE(cc.statement_retries() == 3);
+    BOOST_REQUIRE(cc.statement_retry_successes() == 0);
+
+    // Succeeds on retry.
+    sc.provider().certify_result_ = wsrep::provider::success;
+    BOOST_REQUIRE(cc.retry_statement() == 0);
+    BOOST_REQUIRE(cc.current_error() == wsrep::e_success);
+    BOOST_REQUIRE(tc.active() == false);
+    BOOST_REQUIRE(cc.statement_retries() == 4);
+    BOOST_REQUIRE(cc.statement_retry_successes() == 1);
+
+    // Nothing to retry without error.
+    BOOST_REQUIRE(cc.retry_statement());
+    BOOST_REQUIRE(cc.current_error() == wsrep::e_success);
+    BOOST_REQUIRE(cc.statement_retries() == 4);
+}
+
 //
 // Test before_command() with keep_command_error param
 // BF abort after ownership is acquired and before before_command()